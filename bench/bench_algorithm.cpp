@@ -0,0 +1,247 @@
+#include "benchmark.hpp"
+#include "js/algorithm.hpp"
+#include "js/thread.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::size_t size = 1 << 20;
+
+std::vector<double> random_doubles(std::size_t n) {
+    std::mt19937_64 g(42);
+    std::uniform_real_distribution<double> dist(-1, 1);
+    std::vector<double> vec(n);
+    for (auto& x : vec) x = dist(g);
+    return vec;
+}
+}  // end namespace
+
+JS_BENCHMARK(accumulate) {
+    auto data = random_doubles(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    runner.measure("std::accumulate", size, [&]() {
+        js::bench::do_not_optimize(
+            std::accumulate(data.begin(), data.end(), 0.0));
+    });
+    runner.measure("parallel_accumulate/threads", size, [&]() {
+        js::bench::do_not_optimize(js::parallel_accumulate(
+            data.begin(), data.end(), 0.0, pool.size()));
+    });
+    runner.measure("parallel_accumulate/pool", size, [&]() {
+        js::bench::do_not_optimize(
+            js::parallel_accumulate(data.begin(), data.end(), 0.0, pool));
+    });
+    runner.measure("async_accumulate/async", size, [&]() {
+        js::bench::do_not_optimize(
+            js::async_accumulate(data.begin(), data.end(), 0.0));
+    });
+    runner.measure("async_accumulate/pool", size, [&]() {
+        js::bench::do_not_optimize(
+            js::async_accumulate(data.begin(), data.end(), 0.0, pool));
+    });
+}
+
+JS_BENCHMARK(for_each) {
+    auto data = random_doubles(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    auto f = [](double& x) { x = std::sqrt(x * x + 1); };
+    // Cost grows with the value, so static blocks are unbalanced
+    auto uneven = [](double& x) {
+        double y = x;
+        int n = static_cast<int>((x + 1) * 32);
+        for (int i = 0; i < n; ++i) y = std::sqrt(y * y + 1);
+        x = y;
+    };
+    std::vector<double> sorted = data;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<double> work;
+    auto reset = [&]() { work = sorted; };
+
+    runner.measure("std::for_each", size, [&]() {
+        std::for_each(data.begin(), data.end(), f);
+    });
+    runner.measure("parallel_for_each/threads", size, [&]() {
+        js::parallel_for_each(data.begin(), data.end(), f, pool.size());
+    });
+    runner.measure("parallel_for_each/static", size, [&]() {
+        js::parallel_for_each(data.begin(), data.end(), f, pool);
+    });
+    runner.measure("uneven/static", size, reset, [&]() {
+        js::parallel_for_each(work.begin(), work.end(), uneven, pool,
+                              js::static_schedule{});
+    });
+    runner.measure("uneven/dynamic", size, reset, [&]() {
+        js::parallel_for_each(work.begin(), work.end(), uneven, pool,
+                              js::dynamic_schedule(1024));
+    });
+    runner.measure("uneven/guided", size, reset, [&]() {
+        js::parallel_for_each(work.begin(), work.end(), uneven, pool,
+                              js::guided_schedule(256));
+    });
+}
+
+JS_BENCHMARK(index_sort) {
+    auto data = random_doubles(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    runner.measure("index_sort", size, [&]() {
+        js::bench::do_not_optimize(js::index_sort(data.begin(), data.end()));
+    });
+    runner.measure("index_sort/uint32", size, [&]() {
+        js::bench::do_not_optimize(
+            js::index_sort<std::uint32_t>(data.begin(), data.end()));
+    });
+    runner.measure("parallel_index_sort", size, [&]() {
+        js::bench::do_not_optimize(
+            js::parallel_index_sort(data.begin(), data.end(), pool));
+    });
+    runner.measure("radix_index_sort", size, [&]() {
+        js::bench::do_not_optimize(
+            js::radix_index_sort(data.begin(), data.end()));
+    });
+    runner.measure("radix_index_sort/uint32", size, [&]() {
+        js::bench::do_not_optimize(
+            js::radix_index_sort<std::uint32_t>(data.begin(), data.end()));
+    });
+}
+
+JS_BENCHMARK(scan) {
+    auto data = random_doubles(size);
+    std::vector<double> out(size);
+    std::vector<std::uint32_t> counts(size, 3);
+    std::vector<std::uint32_t> offsets(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    runner.measure("std::partial_sum", size, [&]() {
+        std::partial_sum(data.begin(), data.end(), out.begin());
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("parallel_inclusive_scan/threads", size, [&]() {
+        js::parallel_inclusive_scan(data.begin(), data.end(), out.begin(),
+                                    pool.size());
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("parallel_inclusive_scan/pool", size, [&]() {
+        js::parallel_inclusive_scan(data.begin(), data.end(), out.begin(),
+                                    pool);
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("parallel_exclusive_scan/offsets", size, [&]() {
+        js::parallel_exclusive_scan(counts.begin(), counts.end(),
+                                    offsets.begin(), std::uint32_t(0), pool);
+        js::bench::do_not_optimize(offsets.data());
+    });
+}
+
+JS_BENCHMARK(transform_reduce) {
+    auto x = random_doubles(size);
+    auto y = random_doubles(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    auto square = [](double v) { return v * v; };
+    runner.measure("sum_of_squares/std::accumulate", size, [&]() {
+        js::bench::do_not_optimize(std::accumulate(
+            x.begin(), x.end(), 0.0,
+            [](double acc, double v) { return acc + v * v; }));
+    });
+    runner.measure("sum_of_squares/pool", size, [&]() {
+        js::bench::do_not_optimize(js::parallel_transform_reduce(
+            x.begin(), x.end(), 0.0, std::plus<double>(), square, pool));
+    });
+    runner.measure("dot/std::inner_product", size, [&]() {
+        js::bench::do_not_optimize(
+            std::inner_product(x.begin(), x.end(), y.begin(), 0.0));
+    });
+    runner.measure("dot/pool", size, [&]() {
+        js::bench::do_not_optimize(js::parallel_transform_reduce(
+            x.begin(), x.end(), y.begin(), 0.0, pool));
+    });
+}
+
+JS_BENCHMARK(sort) {
+    constexpr std::size_t n = 1 << 22;
+    auto data = random_doubles(n);
+    std::vector<double> work;
+    auto reset = [&]() { work = data; };
+    runner.measure("std::sort", n, reset,
+                   [&]() { std::sort(work.begin(), work.end()); });
+    runner.measure("std::stable_sort", n, reset,
+                   [&]() { std::stable_sort(work.begin(), work.end()); });
+    // Scaling with the number of workers
+    for (std::size_t threads = 1; threads <= js::ThreadPool::default_size();
+         threads *= 2) {
+        js::ThreadPool pool(threads);
+        std::string suffix = "/threads=" + std::to_string(threads);
+        runner.measure("parallel_sort" + suffix, n, reset, [&]() {
+            js::parallel_sort(work.begin(), work.end(), pool);
+        });
+        runner.measure("parallel_stable_sort" + suffix, n, reset, [&]() {
+            js::parallel_stable_sort(work.begin(), work.end(), pool);
+        });
+    }
+}
+
+JS_BENCHMARK(permutation) {
+    auto keys = random_doubles(size);
+    auto values = random_doubles(size);
+    auto index = js::index_sort(keys.begin(), keys.end());
+    js::ThreadPool& pool = js::ThreadPool::global();
+    std::vector<double> k, v;
+    auto reset = [&]() {
+        k = keys;
+        v = values;
+    };
+    runner.measure("copy_per_array", size, reset, [&]() {
+        std::vector<double> tmp(size);
+        for (auto* range : {&k, &v}) {
+            for (std::size_t i = 0; i != size; ++i) tmp[i] = (*range)[index[i]];
+            range->swap(tmp);
+        }
+    });
+    runner.measure("apply_permutation", size, reset, [&]() {
+        js::apply_permutation(index.begin(), index.end(), k.begin(),
+                              v.begin());
+    });
+    std::vector<double> out(size);
+    runner.measure("apply_permutation_copy/pool", size, [&]() {
+        js::apply_permutation_copy(index.begin(), index.end(), keys.begin(),
+                                   out.begin(), pool);
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("sort_by_key", size, reset, [&]() {
+        js::sort_by_key(k.begin(), k.end(), v.begin());
+    });
+    runner.measure("index_sort+apply_permutation", size, reset, [&]() {
+        auto perm = js::index_sort(k.begin(), k.end());
+        js::apply_permutation(perm.begin(), perm.end(), k.begin(), v.begin());
+    });
+}
+
+JS_BENCHMARK(top_k) {
+    auto data = random_doubles(size);
+    js::ThreadPool& pool = js::ThreadPool::global();
+    for (std::size_t k : {10, 1000, 100000}) {
+        std::string suffix = "/k=" + std::to_string(k);
+        runner.measure("index_sort+resize" + suffix, size, [&]() {
+            auto index = js::index_sort(data.begin(), data.end());
+            index.resize(k);
+            js::bench::do_not_optimize(index.data());
+        });
+        runner.measure("index_partial_sort" + suffix, size, [&]() {
+            auto index = js::index_partial_sort(data.begin(), data.end(), k);
+            js::bench::do_not_optimize(index.data());
+        });
+        runner.measure("index_nth_element" + suffix, size, [&]() {
+            auto index = js::index_nth_element(data.begin(), data.end(), k);
+            js::bench::do_not_optimize(index.data());
+        });
+        runner.measure("parallel_index_partial_sort" + suffix, size, [&]() {
+            auto index = js::parallel_index_partial_sort(data.begin(),
+                                                         data.end(), k, pool);
+            js::bench::do_not_optimize(index.data());
+        });
+    }
+}
@@ -0,0 +1,111 @@
+#include "benchmark.hpp"
+#include "js/container.hpp"
+#include "js/iterator.hpp"
+#include "js/tuple.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace {
+constexpr std::size_t size = 1 << 20;
+
+struct Id {
+    using type = std::int64_t;
+};
+struct Energy {
+    using type = double;
+};
+struct Mass {
+    using type = double;
+};
+struct Charge {
+    using type = int;
+};
+}  // end namespace
+
+JS_BENCHMARK(zip) {
+    std::vector<double> a(size, 1.5);
+    std::vector<double> b(size, 2.5);
+    runner.measure("index_loop", size, [&]() {
+        double sum = 0;
+        for (std::size_t i = 0; i != size; ++i) sum += a[i] * b[i];
+        js::bench::do_not_optimize(sum);
+    });
+    runner.measure("zip_loop", size, [&]() {
+        auto zip = js::makeZip(a, b);
+        double sum = 0;
+        for (auto it = zip.begin(); it != zip.end(); ++it) {
+            auto ref = *it;
+            sum += std::get<0>(ref) * std::get<1>(ref);
+        }
+        js::bench::do_not_optimize(sum);
+    });
+
+    std::mt19937_64 g(42);
+    std::vector<std::uint32_t> keys(size);
+    for (auto& k : keys) k = static_cast<std::uint32_t>(g());
+    std::vector<std::uint32_t> sort_keys;
+    std::vector<double> sort_values;
+    auto reset = [&]() {
+        sort_keys = keys;
+        sort_values = a;
+    };
+    runner.measure("sort/zip", size, reset, [&]() {
+        auto zip = js::makeZip(sort_keys, sort_values);
+        std::sort(zip.begin(), zip.end(), [](const auto& x, const auto& y) {
+            return std::get<0>(x) < std::get<0>(y);
+        });
+    });
+    runner.measure("sort/pairs", size, reset, [&]() {
+        std::vector<std::pair<std::uint32_t, double>> pairs(size);
+        for (std::size_t i = 0; i != size; ++i) {
+            pairs[i] = {sort_keys[i], sort_values[i]};
+        }
+        std::sort(pairs.begin(), pairs.end(), [](const auto& x, const auto& y) {
+            return x.first < y.first;
+        });
+        for (std::size_t i = 0; i != size; ++i) {
+            sort_keys[i] = pairs[i].first;
+            sort_values[i] = pairs[i].second;
+        }
+    });
+}
+
+JS_BENCHMARK(soa_vector) {
+    using Row = js::TaggedTuple<Id, Energy, Mass, Charge>;
+    std::vector<Row> aos;
+    js::SoAVector<Id, Energy, Mass, Charge> soa;
+    aos.reserve(size);
+    soa.reserve(size);
+    for (std::size_t i = 0; i != size; ++i) {
+        aos.push_back(Row(static_cast<std::int64_t>(i), 0.5 * i, 1.0, 1));
+        soa.emplace_back(static_cast<std::int64_t>(i), 0.5 * i, 1.0, 1);
+    }
+    runner.measure("scan/aos", size, [&]() {
+        double sum = 0;
+        for (auto& row : aos) sum += js::get<Energy>(row);
+        js::bench::do_not_optimize(sum);
+    });
+    runner.measure("scan/soa", size, [&]() {
+        const auto& energy = js::get<Energy>(soa);
+        js::bench::do_not_optimize(
+            std::accumulate(energy.begin(), energy.end(), 0.0));
+    });
+    runner.measure("push_back/aos", size, [&]() {
+        std::vector<Row> v;
+        for (std::size_t i = 0; i != size; ++i) {
+            v.push_back(Row(static_cast<std::int64_t>(i), 0.5, 1.0, 1));
+        }
+        js::bench::do_not_optimize(v.data());
+    });
+    runner.measure("push_back/soa", size, [&]() {
+        js::SoAVector<Id, Energy, Mass, Charge> v;
+        for (std::size_t i = 0; i != size; ++i) {
+            v.emplace_back(static_cast<std::int64_t>(i), 0.5, 1.0, 1);
+        }
+        js::bench::do_not_optimize(v.data<Id>());
+    });
+}
@@ -0,0 +1,82 @@
+#include "benchmark.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace {
+void usage(const char* name) {
+    std::cerr
+        << "Usage: " << name << " [options]\n"
+        << "  --filter=<string>     run benchmarks containing string\n"
+        << "  --format=text|csv|json\n"
+        << "  --output=<file>       write results to file\n"
+        << "  --repetitions=<n>     measured runs (default 15)\n"
+        << "  --warmups=<n>         unmeasured runs (default 2)\n"
+        << "  --min-time=<ns>       minimal duration of a run (default 1e5)\n"
+        << "  --list                list benchmark groups\n";
+}
+
+bool starts_with(const std::string& str, const std::string& prefix) {
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+}  // end namespace
+
+int main(int argc, char** argv) {
+    js::bench::Settings settings;
+    std::string format = "text";
+    std::string output;
+    for (int i = 1; i != argc; ++i) {
+        std::string arg = argv[i];
+        std::string value = arg.substr(arg.find('=') + 1);
+        if (starts_with(arg, "--filter=")) {
+            settings.filter = value;
+        } else if (starts_with(arg, "--format=")) {
+            format = value;
+        } else if (starts_with(arg, "--output=")) {
+            output = value;
+        } else if (starts_with(arg, "--repetitions=")) {
+            settings.repetitions = std::max(1ul, std::stoul(value));
+        } else if (starts_with(arg, "--warmups=")) {
+            settings.warmups = std::stoul(value);
+        } else if (starts_with(arg, "--min-time=")) {
+            settings.min_time = std::stod(value);
+        } else if (arg == "--list") {
+            for (const auto& g : js::bench::registry()) {
+                std::cout << g.first << '\n';
+            }
+            return EXIT_SUCCESS;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (format != "text" && format != "csv" && format != "json") {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    js::bench::Runner runner(settings);
+    for (const auto& g : js::bench::registry()) {
+        runner.group(g.first);
+        g.second(runner);
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output);
+        if (!file) {
+            std::cerr << "Could not open " << output << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    std::ostream& out = output.empty() ? std::cout : file;
+    if (format == "csv") {
+        js::bench::write_csv(out, runner.results());
+    } else if (format == "json") {
+        js::bench::write_json(out, runner.results());
+    } else {
+        js::bench::write_text(out, runner.results());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+#include "benchmark.hpp"
+#include "js/algorithm/parallel_algorithm.hpp"
+#include "js/random.hpp"
+#include "js/random/binomial.hpp"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+constexpr std::size_t samples = 1 << 16;
+}  // end namespace
+
+JS_BENCHMARK(engines) {
+    std::mt19937 mt32(42);
+    std::mt19937_64 mt64(42);
+    runner.measure("mt19937", samples, [&]() {
+        std::uint32_t x = 0;
+        for (std::size_t i = 0; i != samples; ++i) x ^= mt32();
+        js::bench::do_not_optimize(x);
+    });
+    runner.measure("mt19937_64", samples, [&]() {
+        std::uint64_t x = 0;
+        for (std::size_t i = 0; i != samples; ++i) x ^= mt64();
+        js::bench::do_not_optimize(x);
+    });
+    js::Philox4x32 philox(42);
+    runner.measure("philox4x32", samples, [&]() {
+        std::uint64_t x = 0;
+        for (std::size_t i = 0; i != samples; ++i) x ^= philox();
+        js::bench::do_not_optimize(x);
+    });
+    std::vector<std::uint64_t> out(samples);
+    runner.measure("mt19937_64/fill", samples, [&]() {
+        for (auto& x : out) x = mt64();
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("philox4x32/fill", samples, [&]() {
+        philox.fill(out.data(), samples);
+        js::bench::do_not_optimize(out.data());
+    });
+}
+
+JS_BENCHMARK(seeding) {
+    runner.measure("seed64", 1,
+                   [&]() { js::bench::do_not_optimize(js::seed64()); });
+    constexpr std::size_t workers = 1024;
+    std::vector<std::uint64_t> seeds(workers);
+    runner.measure("seed64_per_engine", workers, [&]() {
+        for (auto& s : seeds) s = js::seed64();
+        js::bench::do_not_optimize(seeds.data());
+    });
+    runner.measure("fill_seeds", workers, [&]() {
+        js::fill_seeds(seeds.begin(), seeds.end());
+        js::bench::do_not_optimize(seeds.data());
+    });
+    runner.measure("SeedExpander", workers, [&]() {
+        js::SeedExpander expander = js::SeedExpander::from_entropy();
+        for (auto& s : seeds) s = expander();
+        js::bench::do_not_optimize(seeds.data());
+    });
+    std::vector<std::mt19937_64> engines(workers);
+    runner.measure("mt19937_64/std::seed_seq", workers, [&]() {
+        std::vector<std::uint32_t> words(8 * workers);
+        js::fill_seeds(words.begin(), words.end());
+        for (std::size_t i = 0; i != workers; ++i) {
+            std::seed_seq seq(words.begin() + 8 * i, words.begin() + 8 * i + 8);
+            engines[i].seed(seq);
+        }
+        js::bench::do_not_optimize(engines.data());
+    });
+    runner.measure("mt19937_64/SeedExpander", workers, [&]() {
+        js::SeedExpander expander = js::SeedExpander::from_entropy();
+        for (auto& g : engines) g.seed(expander);
+        js::bench::do_not_optimize(engines.data());
+    });
+}
+
+JS_BENCHMARK(binomial) {
+    std::mt19937_64 g(42);
+    const int trials[] = {10, 1000, 1000000};
+    for (int n : trials) {
+        std::string suffix = "/n=" + std::to_string(n);
+        std::binomial_distribution<int> std_dist(n, 0.3);
+        runner.measure("std" + suffix, samples, [&]() {
+            int x = 0;
+            for (std::size_t i = 0; i != samples; ++i) x += std_dist(g);
+            js::bench::do_not_optimize(x);
+        });
+        runner.measure("js" + suffix, samples, [&]() {
+            int x = 0;
+            for (std::size_t i = 0; i != samples; ++i) {
+                x += js::detail::binomial(g, n, 0.3);
+            }
+            js::bench::do_not_optimize(x);
+        });
+    }
+}
+
+JS_BENCHMARK(multinomial) {
+    std::mt19937_64 g(42);
+    std::array<double, 16> prob;
+    for (std::size_t i = 0; i != prob.size(); ++i) {
+        prob[i] = (i + 1) / 136.;
+    }
+    const int trials[] = {1, 10, 32, 64, 100000};
+    for (int n : trials) {
+        std::string suffix = "/n=" + std::to_string(n);
+        js::MultinomialDistribution<16> dist(n, prob);
+        std::vector<std::array<int, 16>> out(samples);
+        runner.measure("operator()" + suffix, samples, [&]() {
+            for (auto& o : out) o = dist(g);
+            js::bench::do_not_optimize(out.data());
+        });
+        runner.measure("generate" + suffix, samples, [&]() {
+            dist.generate(g, out.begin(), samples);
+            js::bench::do_not_optimize(out.data());
+        });
+    }
+}
+
+JS_BENCHMARK(dynamic_multinomial) {
+    std::mt19937_64 g(42);
+    constexpr std::size_t categories = 2000;
+    // Geometric probabilities, most of the mass in few categories
+    std::vector<double> prob(categories);
+    double sum = 0;
+    for (std::size_t i = 0; i != categories; ++i) {
+        prob[(i * 7919) % categories] = std::pow(0.9, double(i));
+        sum += prob[(i * 7919) % categories];
+    }
+    for (auto& p : prob) p /= sum;
+    constexpr std::size_t draws = 1 << 10;
+    const int trials[] = {10, 1000, 100000};
+    for (int n : trials) {
+        std::string suffix = "/n=" + std::to_string(n);
+        js::DynamicMultinomialDistribution<> dist(n, prob);
+        std::vector<std::vector<int>> rows(draws,
+                                           std::vector<int>(categories));
+        runner.measure("generate" + suffix, draws, [&]() {
+            dist.generate(g, rows.begin(), draws);
+            js::bench::do_not_optimize(rows.data());
+        });
+        std::vector<std::pair<std::size_t, int>> sparse;
+        runner.measure("sparse" + suffix, draws, [&]() {
+            for (std::size_t k = 0; k != draws; ++k) {
+                sparse.clear();
+                dist.sparse(g, std::back_inserter(sparse));
+            }
+            js::bench::do_not_optimize(sparse.data());
+        });
+    }
+}
+
+JS_BENCHMARK(categorical) {
+    std::mt19937_64 g(42);
+    std::vector<double> weights(64);
+    for (std::size_t i = 0; i != weights.size(); ++i) weights[i] = i + 1.;
+    std::vector<int> out(samples);
+    std::discrete_distribution<int> std_dist(weights.begin(), weights.end());
+    runner.measure("std::discrete_distribution", samples, [&]() {
+        for (auto& x : out) x = std_dist(g);
+        js::bench::do_not_optimize(out.data());
+    });
+    js::DiscreteAliasDistribution<int> alias(weights.begin(), weights.end());
+    runner.measure("alias/operator()", samples, [&]() {
+        for (auto& x : out) x = alias(g);
+        js::bench::do_not_optimize(out.data());
+    });
+    runner.measure("alias/generate", samples, [&]() {
+        alias.generate(g, out.begin(), samples);
+        js::bench::do_not_optimize(out.data());
+    });
+}
+
+JS_BENCHMARK(for_each_random) {
+    std::array<double, 4> prob{{0.1, 0.2, 0.3, 0.4}};
+    js::MultinomialDistribution<4> dist(100, prob);
+    std::vector<std::array<int, 4>> agents(samples);
+    std::mt19937_64 mt64(42);
+    runner.measure("serial/mt19937_64", samples, [&]() {
+        for (auto& a : agents) a = dist(mt64);
+        js::bench::do_not_optimize(agents.data());
+    });
+    auto draw = [&dist](std::array<int, 4>& a, js::Philox4x32& g) {
+        a = dist(g);
+    };
+    runner.measure("serial/philox_per_agent", samples, [&]() {
+        for (std::size_t i = 0; i != samples; ++i) {
+            js::Philox4x32 g(42, i);
+            draw(agents[i], g);
+        }
+        js::bench::do_not_optimize(agents.data());
+    });
+    runner.measure("parallel_for_each_random", samples, [&]() {
+        js::parallel_for_each_random_auto(agents.begin(), agents.end(), draw,
+                                          42);
+        js::bench::do_not_optimize(agents.data());
+    });
+}
@@ -0,0 +1,247 @@
+#include "benchmark.hpp"
+#include "js/stream.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr std::size_t file_values = 1 << 23;
+const std::string file_name = "bench_stream_input.bin";
+
+void write_input() {
+    std::vector<std::uint64_t> values(file_values);
+    std::iota(values.begin(), values.end(), std::uint64_t(0));
+    std::ofstream out(file_name, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(values.data()),
+              values.size() * sizeof(std::uint64_t));
+}
+}  // end namespace
+
+JS_BENCHMARK(read_file) {
+    write_input();
+    runner.measure("ifstream", file_values, [&]() {
+        std::ifstream in(file_name, std::ios::binary);
+        std::vector<std::uint64_t> values(file_values);
+        in.read(reinterpret_cast<char*>(values.data()),
+                values.size() * sizeof(std::uint64_t));
+        js::bench::do_not_optimize(
+            std::accumulate(values.begin(), values.end(), std::uint64_t(0)));
+    });
+    runner.measure("MappedFile", file_values, [&]() {
+        js::MappedFile file(file_name, js::MappedFile::Mode::read,
+                            js::AccessHint::sequential);
+        auto values = file.span<std::uint64_t>();
+        js::bench::do_not_optimize(
+            std::accumulate(values.begin(), values.end(), std::uint64_t(0)));
+    });
+    std::remove(file_name.c_str());
+}
+
+JS_BENCHMARK(write_file) {
+    std::vector<std::uint64_t> values(1024);
+    std::iota(values.begin(), values.end(), std::uint64_t(0));
+    const std::size_t blocks = file_values / values.size();
+    const std::size_t bytes = values.size() * sizeof(std::uint64_t);
+    runner.measure("ofstream", file_values, [&]() {
+        std::ofstream out(file_name, std::ios::binary);
+        for (std::size_t b = 0; b != blocks; ++b) {
+            out.write(reinterpret_cast<const char*>(values.data()), bytes);
+        }
+    });
+    runner.measure("MappedFile/append", file_values, [&]() {
+        std::remove(file_name.c_str());
+        js::MappedFile out(file_name, js::MappedFile::Mode::read_write);
+        for (std::size_t b = 0; b != blocks; ++b) {
+            out.append(values.data(), bytes);
+        }
+    });
+    std::remove(file_name.c_str());
+}
+
+JS_BENCHMARK(file_names) {
+    const std::string base = "bench_stream_name";
+    constexpr std::size_t existing = 2000;
+    for (std::size_t i = 0; i != existing; ++i) {
+        std::ofstream(js::detail::numbered_filename(base, "txt", i));
+    }
+    runner.measure("linear_stat", 1, [&]() {
+        std::size_t index = 0;
+        while (js::detail::file_exists(
+            js::detail::numbered_filename(base, "txt", index))) {
+            ++index;
+        }
+        js::bench::do_not_optimize(index);
+    });
+    runner.measure("free_filename", 1, [&]() {
+        auto name = js::detail::free_filename(base, "txt", -42);
+        js::bench::do_not_optimize(name.data());
+    });
+    for (std::size_t i = 0; i != existing; ++i) {
+        std::remove(js::detail::numbered_filename(base, "txt", i).c_str());
+    }
+}
+
+JS_BENCHMARK(rotating_file) {
+    js::RotationPolicy policy;
+    policy.max_bytes = 1 << 20;
+    constexpr std::size_t lines = 1 << 18;
+    runner.measure("ofstream", lines, [&]() {
+        std::ofstream out("bench_stream_rotating.txt");
+        for (std::size_t i = 0; i != lines; ++i) out << i << " " << i << "\n";
+    });
+    std::remove("bench_stream_rotating.txt");
+    runner.measure("RotatingFileHandler", lines, [&]() {
+        std::vector<std::string> files;
+        {
+            js::RotatingFileHandler out("bench_stream_rotating", "txt",
+                                        policy);
+            for (std::size_t i = 0; i != lines; ++i) {
+                out << i << " " << i << "\n";
+            }
+            files = out.files();
+        }
+        for (const auto& name : files) std::remove(name.c_str());
+    });
+}
+
+JS_BENCHMARK(compressed_file) {
+    constexpr std::size_t lines = 1 << 19;
+    std::string text;
+    for (std::size_t i = 0; i != lines; ++i) {
+        text += std::to_string(i) + " " + std::to_string(i % 1000) + "\n";
+    }
+    const std::string name = "bench_stream_compressed.jsz";
+    runner.measure("ofstream", lines, [&]() {
+        std::remove(name.c_str());
+        std::ofstream out(name, std::ios::binary);
+        out.write(text.data(), text.size());
+    });
+    auto write = [&](js::Codec codec, js::ThreadPool& pool) {
+        std::remove(name.c_str());
+        js::CompressedFileHandler out(
+            js::CompressedFileHandler::default_block_size, codec, pool);
+        out.open("bench_stream_compressed", "jsz");
+        out.write(text.data(), text.size());
+    };
+    js::ThreadPool single(1);
+    runner.measure("lz/1_thread", lines,
+                   [&]() { write(js::Codec::lz, single); });
+    runner.measure("lz/pool", lines,
+                   [&]() { write(js::Codec::lz, js::ThreadPool::global()); });
+#ifdef JS_HAVE_ZLIB
+    runner.measure("zlib/1_thread", lines,
+                   [&]() { write(js::Codec::zlib, single); });
+    runner.measure("zlib/pool", lines, [&]() {
+        write(js::Codec::zlib, js::ThreadPool::global());
+    });
+#endif
+    runner.measure("read/pool", lines, [&]() {
+        js::CompressedFileReader in(name);
+        js::bench::do_not_optimize(in.str().data());
+    });
+    std::remove(name.c_str());
+}
+
+JS_BENCHMARK(number_format) {
+    constexpr std::size_t rows = 1 << 17;
+    std::vector<double> values(rows);
+    for (std::size_t i = 0; i != rows; ++i) values[i] = 1.0 / (i + 3);
+    runner.measure("snprintf/%.17g", rows, [&]() {
+        char buffer[32];
+        for (double x : values) {
+            js::bench::do_not_optimize(
+                std::snprintf(buffer, sizeof(buffer), "%.17g", x));
+        }
+    });
+    runner.measure("format_number/double", rows, [&]() {
+        char buffer[js::max_number_size];
+        for (double x : values) {
+            js::bench::do_not_optimize(js::format_number(buffer, x));
+        }
+    });
+    runner.measure("format_number/int", rows, [&]() {
+        char buffer[js::max_number_size];
+        for (std::size_t i = 0; i != rows; ++i) {
+            js::bench::do_not_optimize(js::format_number(buffer, i * 7919));
+        }
+    });
+    const std::string name = "bench_stream_numbers.txt";
+    runner.measure("ofstream", rows, [&]() {
+        std::remove(name.c_str());
+        std::ofstream out(name);
+        out.precision(17);
+        for (std::size_t i = 0; i != rows; ++i) {
+            out << i << '\t' << values[i] << '\n';
+        }
+    });
+    runner.measure("BasicFileHandler", rows, [&]() {
+        std::remove(name.c_str());
+        js::detail::BasicFileHandler out("bench_stream_numbers", "txt");
+        for (std::size_t i = 0; i != rows; ++i) {
+            out << i << '\t' << values[i] << '\n';
+        }
+    });
+    runner.measure("BasicFileHandler/write_row", rows, [&]() {
+        std::remove(name.c_str());
+        js::detail::BasicFileHandler out("bench_stream_numbers", "txt");
+        for (std::size_t i = 0; i != rows; ++i) {
+            out.write_row(std::make_tuple(i, values[i]));
+        }
+    });
+    std::remove(name.c_str());
+}
+
+namespace {
+struct Index {
+    using type = std::int64_t;
+};
+struct Value {
+    using type = double;
+};
+struct Weight {
+    using type = double;
+};
+}  // end namespace
+
+JS_BENCHMARK(table_reader) {
+    constexpr std::size_t rows = 1 << 20;
+    const std::string name = "bench_stream_table.txt";
+    {
+        js::detail::BasicFileHandler out("bench_stream_table", "txt");
+        for (std::size_t i = 0; i != rows; ++i) {
+            out.write_row(std::make_tuple(i, 1.0 / (i + 3), 0.25 * i));
+        }
+    }
+    runner.measure("ifstream", rows, [&]() {
+        std::ifstream in(name);
+        std::vector<std::int64_t> index;
+        std::vector<double> value, weight;
+        std::int64_t i;
+        double v, w;
+        while (in >> i >> v >> w) {
+            index.push_back(i);
+            value.push_back(v);
+            weight.push_back(w);
+        }
+        js::bench::do_not_optimize(index.data());
+    });
+    js::ThreadPool single(1);
+    runner.measure("TableReader/1_thread", rows, [&]() {
+        js::TableReader<Index, Value, Weight> reader(name, js::TableFormat(),
+                                                     single);
+        js::bench::do_not_optimize(reader.read().size());
+    });
+    runner.measure("TableReader/pool", rows, [&]() {
+        js::TableReader<Index, Value, Weight> reader(name);
+        js::bench::do_not_optimize(reader.read().size());
+    });
+    runner.measure("TableReader/one_column", rows, [&]() {
+        js::TableReader<Value> reader(name);
+        reader.columns({{1}});
+        js::bench::do_not_optimize(reader.read().size());
+    });
+    std::remove(name.c_str());
+}
@@ -0,0 +1,254 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "js/stopwatch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <ostream>
+#include <ratio>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace js {
+namespace bench {
+
+/**
+ * Prevents the compiler from optimizing away the computation of `value`.
+ */
+template <class T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/// Forces all pending writes to memory to be performed
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+/// Settings of a benchmark run
+struct Settings {
+    /// Runs before the measurement
+    std::size_t warmups = 2;
+    /// Measured runs
+    std::size_t repetitions = 15;
+    /// Minimal duration of a measured run in nanoseconds
+    double min_time = 1e5;
+    /// Only run benchmarks containing this string
+    std::string filter;
+};
+
+/// Measured times of one benchmark in nanoseconds per iteration
+struct Result {
+    std::string group;
+    std::string name;
+    /// Processed items per iteration, used for the throughput
+    std::size_t items;
+    /// Iterations per measured run
+    std::size_t iterations;
+    std::vector<double> times;
+
+    /// Linear interpolation between the closest ranks, `q` in [0, 1]
+    double percentile(double q) const {
+        std::vector<double> sorted(times);
+        std::sort(sorted.begin(), sorted.end());
+        double pos = q * (sorted.size() - 1);
+        std::size_t lower = static_cast<std::size_t>(std::floor(pos));
+        std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+        return sorted[lower] + (pos - lower) * (sorted[upper] - sorted[lower]);
+    }
+    double median() const { return percentile(0.5); }
+    double min() const { return *std::min_element(times.begin(), times.end()); }
+    double mean() const {
+        double sum = 0;
+        for (double t : times) sum += t;
+        return sum / times.size();
+    }
+    /// Items per second of the median run
+    double throughput() const { return items * 1e9 / median(); }
+};
+
+/**
+ * Runs and collects the benchmarks of a group. Every measurement is
+ * repeated `Settings::repetitions` times after `Settings::warmups`
+ * unmeasured runs.
+ */
+class Runner {
+  private:
+    using Watch = StopWatch<std::nano>;
+
+    Settings _settings;
+    std::string _group;
+    std::vector<Result> _results;
+
+    bool selected(const std::string& name) const {
+        return (_group + "/" + name).find(_settings.filter) !=
+               std::string::npos;
+    }
+
+  public:
+    explicit Runner(const Settings& settings) : _settings(settings) {}
+
+    void group(const std::string& name) { _group = name; }
+    const std::vector<Result>& results() const noexcept { return _results; }
+
+    /**\brief Measures `body()`
+     *
+     * Short bodies are executed several times per run, so that a run
+     * takes at least `Settings::min_time`.
+     */
+    template <class Body>
+    void measure(const std::string& name, std::size_t items, Body body) {
+        if (!selected(name)) return;
+        for (std::size_t i = 0; i != _settings.warmups; ++i) {
+            body();
+        }
+        std::size_t iterations = 1;
+        while (true) {
+            Watch watch;
+            for (std::size_t i = 0; i != iterations; ++i) {
+                body();
+            }
+            clobber_memory();
+            if (watch.stop() >= _settings.min_time || iterations >= (1 << 30))
+                break;
+            iterations *= 2;
+        }
+        Result result{_group, name, items, iterations, {}};
+        for (std::size_t r = 0; r != _settings.repetitions; ++r) {
+            Watch watch;
+            for (std::size_t i = 0; i != iterations; ++i) {
+                body();
+            }
+            clobber_memory();
+            result.times.push_back(watch.stop() / iterations);
+        }
+        _results.push_back(std::move(result));
+    }
+
+    /**\brief Measures `body()`, calling the unmeasured `setup()` before
+     * every run
+     *
+     * Used for benchmarks modifying their input, like sorting.
+     */
+    template <class Setup, class Body>
+    void measure(const std::string& name, std::size_t items, Setup setup,
+                 Body body) {
+        if (!selected(name)) return;
+        for (std::size_t i = 0; i != _settings.warmups; ++i) {
+            setup();
+            body();
+        }
+        Result result{_group, name, items, 1, {}};
+        for (std::size_t r = 0; r != _settings.repetitions; ++r) {
+            setup();
+            clobber_memory();
+            Watch watch;
+            body();
+            clobber_memory();
+            result.times.push_back(watch.stop());
+        }
+        _results.push_back(std::move(result));
+    }
+};
+
+/// Registered benchmark groups
+inline std::vector<std::pair<std::string, std::function<void(Runner&)>>>&
+registry() {
+    static std::vector<std::pair<std::string, std::function<void(Runner&)>>>
+        groups;
+    return groups;
+}
+
+struct Registration {
+    Registration(const char* name, void (*f)(Runner&)) {
+        registry().emplace_back(name, f);
+    }
+};
+
+/**@name Output
+ */
+///@{
+inline void write_text(std::ostream& out, const std::vector<Result>& results) {
+    out << std::left << std::setw(48) << "benchmark" << std::right
+        << std::setw(14) << "median [ns]" << std::setw(14) << "p10 [ns]"
+        << std::setw(14) << "p90 [ns]" << std::setw(14) << "items/s"
+        << '\n';
+    out << std::setprecision(4);
+    for (const auto& r : results) {
+        out << std::left << std::setw(48) << (r.group + "/" + r.name)
+            << std::right << std::setw(14) << r.median() << std::setw(14)
+            << r.percentile(0.1) << std::setw(14) << r.percentile(0.9)
+            << std::setw(14) << r.throughput() << '\n';
+    }
+}
+
+inline void write_csv(std::ostream& out, const std::vector<Result>& results) {
+    out << "group,name,items,iterations,repetitions,min_ns,median_ns,mean_ns,"
+           "p10_ns,p90_ns,items_per_second\n";
+    out << std::setprecision(10);
+    for (const auto& r : results) {
+        out << r.group << ',' << r.name << ',' << r.items << ','
+            << r.iterations << ',' << r.times.size() << ',' << r.min() << ','
+            << r.median() << ',' << r.mean() << ',' << r.percentile(0.1)
+            << ',' << r.percentile(0.9) << ',' << r.throughput() << '\n';
+    }
+}
+
+inline void write_json(std::ostream& out, const std::vector<Result>& results) {
+    out << std::setprecision(10);
+    out << "{\n  \"benchmarks\": [";
+    for (std::size_t i = 0; i != results.size(); ++i) {
+        const Result& r = results[i];
+        out << (i ? ",\n" : "\n") << "    {\"group\": \"" << r.group
+            << "\", \"name\": \"" << r.name << "\", \"items\": " << r.items
+            << ", \"iterations\": " << r.iterations
+            << ", \"min_ns\": " << r.min() << ", \"median_ns\": " << r.median()
+            << ", \"mean_ns\": " << r.mean()
+            << ", \"p10_ns\": " << r.percentile(0.1)
+            << ", \"p90_ns\": " << r.percentile(0.9)
+            << ", \"items_per_second\": " << r.throughput()
+            << ", \"times_ns\": [";
+        for (std::size_t t = 0; t != r.times.size(); ++t) {
+            out << (t ? ", " : "") << r.times[t];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+}
+///@}
+
+}  // end namespace bench
+}  // end namespace js
+
+/**
+ * Defines and registers a benchmark group
+ * \code{.cpp}
+ * JS_BENCHMARK(sort) {
+ *     runner.measure("std::sort", n, setup, body);
+ * }
+ * \endcode
+ */
+#define JS_BENCHMARK(group_name)                                          \
+    static void js_benchmark_##group_name(::js::bench::Runner& runner);   \
+    static ::js::bench::Registration js_benchmark_registration_##group_name( \
+        #group_name, &js_benchmark_##group_name);                         \
+    static void js_benchmark_##group_name(::js::bench::Runner& runner)
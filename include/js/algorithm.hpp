@@ -2,3 +2,4 @@
 
 #include "algorithm/sort.hpp"
 #include "algorithm/parallel_algorithm.hpp"
+#include "algorithm/permutation.hpp"
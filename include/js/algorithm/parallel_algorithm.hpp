@@ -19,15 +19,27 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 /*
  * Be advised, this is mainly for test purposes to see if there is any
  * difference between using the raw std::thread and std::async approach.
+ *
+ * The overloads taking a ThreadPool reuse the workers of the pool
+ * instead of creating new threads on every call. The `_auto` variants
+ * use the process wide pool `ThreadPool::global()`.
  */
 
 
 #pragma once
 
+#include "../memory/aligned_allocator.hpp"
+#include "../random/philox.hpp"
+#include "../thread/thread_pool.hpp"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <functional>
 #include <iterator>
+#include <numeric>
 #include <thread>
+#include <type_traits>
 #include <vector>
 #include <list>
 #include <future>
@@ -48,54 +60,366 @@ struct for_each {
         std::for_each(start, stop, f);
     }
 };
+
+/**
+ * Calls `f(worker_index)` for `no_workers` workers. Worker 0 runs on the
+ * calling thread, the others are posted to the pool. The first exception
+ * thrown by a worker is rethrown after all workers are done.
+ */
+template <class WorkerFunction>
+void run_workers(ThreadPool& pool, std::size_t no_workers, WorkerFunction& f) {
+    std::atomic<std::size_t> remaining(no_workers - 1);
+    std::vector<std::exception_ptr> errors(no_workers);
+    for (std::size_t i = 1; i != no_workers; ++i) {
+        pool.post([&, i]() {
+            try {
+                f(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            remaining.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    try {
+        f(std::size_t(0));
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+    pool.wait_until([&remaining]() {
+        return remaining.load(std::memory_order_acquire) == 0;
+    });
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+/**
+ * Same as run_workers, but every worker except worker 0 gets a new
+ * std::thread.
+ */
+template <class WorkerFunction>
+void run_threads(std::size_t no_workers, WorkerFunction& f) {
+    std::vector<std::exception_ptr> errors(no_workers);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i != no_workers; ++i) {
+        threads.emplace_back([&f, &errors, i]() {
+            try {
+                f(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    try {
+        f(std::size_t(0));
+    } catch (...) {
+        errors[0] = std::current_exception();
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (auto& e : errors) {
+        if (e) std::rethrow_exception(e);
+    }
+}
+
+/**
+ * Splits [begin, end) into `no_blocks` blocks and calls
+ * `f(block_begin, block_end, block_index)` for every block on the pool.
+ */
+template <class Iterator, class BlockFunction>
+void run_blocks(ThreadPool& pool, Iterator begin, Iterator end,
+                std::size_t no_blocks, BlockFunction& f) {
+    std::size_t length = std::distance(begin, end);
+    std::size_t block_size = length / no_blocks;
+    std::vector<Iterator> bounds;
+    bounds.reserve(no_blocks + 1);
+    bounds.push_back(begin);
+    for (std::size_t i = 1; i != no_blocks; ++i) {
+        auto block_end = bounds.back();
+        std::advance(block_end, block_size);
+        bounds.push_back(block_end);
+    }
+    bounds.push_back(end);
+    auto worker = [&bounds, &f](std::size_t i) {
+        f(bounds[i], bounds[i + 1], i);
+    };
+    run_workers(pool, no_blocks, worker);
+}
+
+/**
+ * Every worker repeatedly claims the chunk [start, stop) of [0, length)
+ * given by `next_chunk(counter, start, stop)` and calls `f(start, stop)`
+ * until the range is exhausted. If `f` throws, the remaining chunks are
+ * skipped.
+ */
+template <class ChunkClaim, class ChunkFunction>
+void run_chunks(ThreadPool& pool, std::size_t length, std::size_t no_workers,
+                ChunkClaim next_chunk, ChunkFunction& f) {
+    std::atomic<std::size_t> counter(0);
+    auto worker = [&](std::size_t) {
+        std::size_t start, stop;
+        while (next_chunk(counter, start, stop)) {
+            try {
+                f(start, stop);
+            } catch (...) {
+                counter.store(length);
+                throw;
+            }
+        }
+    };
+    run_workers(pool, no_workers, worker);
+}
 }  // end detail
 
 template <class Iterator, class BinaryOperator, class T>
 T parallel_accumulate(Iterator begin, Iterator end, T init, BinaryOperator op,
                       std::size_t no_threads) {
     std::size_t length = std::distance(begin, end);
+    no_threads = std::min(no_threads, length);
+    if (no_threads == 0) return init;
     std::size_t block_size = length / no_threads;
     std::vector<std::thread> threads;
-    std::vector<T> tmp_acc(no_threads, 0);
+    // One cache line per result, so the threads do not share lines
+    padded_vector<T> tmp_acc(no_threads, CacheLinePadded<T>{init});
     auto block_start = begin;
     for (std::size_t i = 0; i != (no_threads - 1); ++i) {
         auto block_end = block_start;
         std::advance(block_end, block_size);
         threads.emplace_back(
             std::move(detail::accumulate<Iterator, BinaryOperator, T>()),
-            block_start, block_end, std::ref(tmp_acc[i]), op);
+            block_start, block_end, std::ref(tmp_acc[i].value), op);
         block_start = block_end;
     }
     threads.emplace_back(
         std::move(detail::accumulate<Iterator, BinaryOperator, T>()),
-        block_start, end, std::ref(tmp_acc[no_threads - 1]), op);
+        block_start, end, std::ref(tmp_acc[no_threads - 1].value), op);
     for (auto& t : threads) {
         t.join();
     }
-    return std::accumulate(tmp_acc.begin(), tmp_acc.end(), init, op);
+    for (auto& acc : tmp_acc) {
+        init = op(init, acc.value);
+    }
+    return init;
 }
 
 template <class Iterator, class T>
 T parallel_accumulate(Iterator begin, Iterator end, T init,
                       std::size_t no_threads) {
-    return parallel_accumulate(begin, end, std::plus<T>(), init, no_threads);
+    return parallel_accumulate(begin, end, init, std::plus<T>(), no_threads);
+}
+
+/**
+ * Same as above, but the blocks are executed by the workers of `pool`.
+ * The range is split into at most `pool.size()` blocks.
+ */
+template <class Iterator, class T, class BinaryOperator>
+T parallel_accumulate(Iterator begin, Iterator end, T init, BinaryOperator op,
+                      ThreadPool& pool) {
+    std::size_t length = std::distance(begin, end);
+    std::size_t no_blocks = std::min(pool.size(), length);
+    if (no_blocks == 0) return init;
+    padded_vector<T> tmp_acc(no_blocks, CacheLinePadded<T>{init});
+    auto block = [&tmp_acc, &op](Iterator start, Iterator stop,
+                                 std::size_t i) {
+        detail::accumulate<Iterator, BinaryOperator, T>()(
+            start, stop, tmp_acc[i].value, op);
+    };
+    detail::run_blocks(pool, begin, end, no_blocks, block);
+    for (auto& acc : tmp_acc) {
+        init = op(init, acc.value);
+    }
+    return init;
+}
+
+template <class Iterator, class T>
+T parallel_accumulate(Iterator begin, Iterator end, T init, ThreadPool& pool) {
+    return parallel_accumulate(begin, end, init, std::plus<T>(), pool);
 }
 
 template <class Iterator, class T, class BinaryOperator>
 T parallel_accumulate_auto(Iterator begin, Iterator end, T init,
                            BinaryOperator op) {
-    long no_threads = std::thread::hardware_concurrency();
-    return parallel_accumulate(begin, end, init, op,
-                               (no_threads > 1) ? no_threads : 2);
+    return parallel_accumulate(begin, end, init, op, ThreadPool::global());
 }
 
 template <class Iterator, class T>
 T parallel_accumulate_auto(Iterator begin, Iterator end, T init) {
-    long no_threads = std::thread::hardware_concurrency();
-    return parallel_accumulate(begin, end, std::plus<T>(), init,
-                               (no_threads > 1) ? no_threads : 2);
+    return parallel_accumulate(begin, end, init, std::plus<T>(),
+                               ThreadPool::global());
+}
+
+/**\name Transform reduce
+ *
+ * `parallel_transform_reduce` computes `init reduce t(x0) reduce t(x1)
+ * ...` for the unary transform `t` or `init reduce t(x0, y0) reduce t(x1,
+ * y1) ...` for a binary transform of two ranges, without storing the
+ * transformed values, e.g. sums of squares, dot products or the minimum
+ * and its index.
+ *
+ * Every worker reduces one block into its own cache line, starting from
+ * the transformed first element of the block. Therefore `T` does not
+ * need a zero or identity element, but has to be constructible from the
+ * result of the transform. `reduce` has to be associative and accept
+ * `(T, T)` as well as `(T, transform result)`, so user types like
+ * compensated sums can be used. The partial results are combined in the
+ * order of the blocks.
+ */
+///@{
+namespace detail {
+/// Bounds of `no_blocks` blocks of [first, first + length)
+template <class Iterator>
+std::vector<Iterator> block_bounds(Iterator first, std::size_t length,
+                                   std::size_t no_blocks) {
+    std::size_t block_size = length / no_blocks;
+    std::vector<Iterator> bounds{first};
+    for (std::size_t i = 1; i != no_blocks; ++i) {
+        bounds.push_back(std::next(bounds.back(), block_size));
+    }
+    bounds.push_back(
+        std::next(bounds.back(), length - (no_blocks - 1) * block_size));
+    return bounds;
+}
+
+/**
+ * Calls `block(i)` for `no_blocks` blocks with `run`, stores the results
+ * in cache line padded partials and reduces them onto `init`.
+ */
+template <class T, class BinaryReduce, class BlockFunction, class RunWorkers>
+T reduce_partials(std::size_t no_blocks, T init, BinaryReduce& reduce,
+                  BlockFunction block, RunWorkers run) {
+    padded_vector<T> partials(no_blocks, CacheLinePadded<T>{init});
+    auto worker = [&partials, &block](std::size_t i) {
+        partials[i].value = block(i);
+    };
+    run(no_blocks, worker);
+    for (auto& p : partials) {
+        init = reduce(std::move(init), std::move(p.value));
+    }
+    return init;
 }
 
+template <class Iterator, class T, class BinaryReduce, class UnaryTransform,
+          class RunWorkers>
+T transform_reduce(Iterator first, Iterator last, T init, BinaryReduce reduce,
+                   UnaryTransform transform, std::size_t no_blocks,
+                   RunWorkers run) {
+    std::size_t length = std::distance(first, last);
+    no_blocks = std::min(no_blocks, length);
+    if (no_blocks == 0) return init;
+    auto bounds = block_bounds(first, length, no_blocks);
+    auto block = [&](std::size_t i) {
+        Iterator it = bounds[i];
+        T acc(transform(*it));
+        for (++it; it != bounds[i + 1]; ++it) {
+            acc = reduce(std::move(acc), transform(*it));
+        }
+        return acc;
+    };
+    return reduce_partials(no_blocks, init, reduce, block, run);
+}
+
+template <class Iterator1, class Iterator2, class T, class BinaryReduce,
+          class BinaryTransform, class RunWorkers>
+T transform_reduce(Iterator1 first1, Iterator1 last1, Iterator2 first2,
+                   T init, BinaryReduce reduce, BinaryTransform transform,
+                   std::size_t no_blocks, RunWorkers run) {
+    std::size_t length = std::distance(first1, last1);
+    no_blocks = std::min(no_blocks, length);
+    if (no_blocks == 0) return init;
+    auto bounds1 = block_bounds(first1, length, no_blocks);
+    auto bounds2 = block_bounds(first2, length, no_blocks);
+    auto block = [&](std::size_t i) {
+        Iterator1 it1 = bounds1[i];
+        Iterator2 it2 = bounds2[i];
+        T acc(transform(*it1, *it2));
+        for (++it1, ++it2; it1 != bounds1[i + 1]; ++it1, ++it2) {
+            acc = reduce(std::move(acc), transform(*it1, *it2));
+        }
+        return acc;
+    };
+    return reduce_partials(no_blocks, init, reduce, block, run);
+}
+}  // end namespace detail
+
+template <class Iterator, class T, class BinaryReduce, class UnaryTransform>
+T parallel_transform_reduce(Iterator first, Iterator last, T init,
+                            BinaryReduce reduce, UnaryTransform transform,
+                            std::size_t no_threads) {
+    auto run = [](std::size_t n, auto& f) { detail::run_threads(n, f); };
+    return detail::transform_reduce(first, last, init, reduce, transform,
+                                    no_threads, run);
+}
+
+template <class Iterator, class T, class BinaryReduce, class UnaryTransform>
+T parallel_transform_reduce(Iterator first, Iterator last, T init,
+                            BinaryReduce reduce, UnaryTransform transform,
+                            ThreadPool& pool) {
+    auto run = [&pool](std::size_t n, auto& f) {
+        detail::run_workers(pool, n, f);
+    };
+    return detail::transform_reduce(first, last, init, reduce, transform,
+                                    pool.size(), run);
+}
+
+template <class Iterator, class T, class BinaryReduce, class UnaryTransform>
+T parallel_transform_reduce_auto(Iterator first, Iterator last, T init,
+                                 BinaryReduce reduce,
+                                 UnaryTransform transform) {
+    return parallel_transform_reduce(first, last, init, reduce, transform,
+                                     ThreadPool::global());
+}
+
+template <class Iterator1, class Iterator2, class T, class BinaryReduce,
+          class BinaryTransform>
+T parallel_transform_reduce(Iterator1 first1, Iterator1 last1,
+                            Iterator2 first2, T init, BinaryReduce reduce,
+                            BinaryTransform transform,
+                            std::size_t no_threads) {
+    auto run = [](std::size_t n, auto& f) { detail::run_threads(n, f); };
+    return detail::transform_reduce(first1, last1, first2, init, reduce,
+                                    transform, no_threads, run);
+}
+
+template <class Iterator1, class Iterator2, class T, class BinaryReduce,
+          class BinaryTransform>
+T parallel_transform_reduce(Iterator1 first1, Iterator1 last1,
+                            Iterator2 first2, T init, BinaryReduce reduce,
+                            BinaryTransform transform, ThreadPool& pool) {
+    auto run = [&pool](std::size_t n, auto& f) {
+        detail::run_workers(pool, n, f);
+    };
+    return detail::transform_reduce(first1, last1, first2, init, reduce,
+                                    transform, pool.size(), run);
+}
+
+/// Inner product of two ranges
+template <class Iterator1, class Iterator2, class T>
+T parallel_transform_reduce(Iterator1 first1, Iterator1 last1,
+                            Iterator2 first2, T init, ThreadPool& pool) {
+    return parallel_transform_reduce(first1, last1, first2, init,
+                                     std::plus<T>(), std::multiplies<T>(),
+                                     pool);
+}
+
+template <class Iterator1, class Iterator2, class T, class BinaryReduce,
+          class BinaryTransform>
+T parallel_transform_reduce_auto(Iterator1 first1, Iterator1 last1,
+                                 Iterator2 first2, T init,
+                                 BinaryReduce reduce,
+                                 BinaryTransform transform) {
+    return parallel_transform_reduce(first1, last1, first2, init, reduce,
+                                     transform, ThreadPool::global());
+}
+
+template <class Iterator1, class Iterator2, class T>
+T parallel_transform_reduce_auto(Iterator1 first1, Iterator1 last1,
+                                 Iterator2 first2, T init) {
+    return parallel_transform_reduce(first1, last1, first2, init,
+                                     ThreadPool::global());
+}
+///@}
+
 template <class Iterator, class Functor>
 void parallel_for_each(Iterator begin, Iterator end, Functor f,
                        std::size_t no_threads) {
@@ -117,12 +441,456 @@ void parallel_for_each(Iterator begin, Iterator end, Functor f,
     }
 }
 
+/**
+ * Same as above, but the blocks are executed by the workers of `pool`.
+ */
+template <class Iterator, class Functor>
+void parallel_for_each(Iterator begin, Iterator end, Functor f,
+                       ThreadPool& pool) {
+    std::size_t length = std::distance(begin, end);
+    std::size_t no_blocks = std::min(pool.size(), length);
+    if (no_blocks == 0) return;
+    auto block = [&f](Iterator start, Iterator stop, std::size_t) {
+        detail::for_each<Iterator, Functor>()(start, stop, f);
+    };
+    detail::run_blocks(pool, begin, end, no_blocks, block);
+}
+
+/**\name Scheduling policies for parallel_for_each
+ *
+ * The static schedule splits the range into one equal block per worker.
+ * If the costs per element vary, the dynamic and guided schedules hand
+ * out chunks from a shared counter, so the workers stay busy until the
+ * whole range is done. Both require random access iterators.
+ */
+///@{
+/// One equal sized block per worker
+struct static_schedule {};
+
+/// Chunks of constant size `grain`
+struct dynamic_schedule {
+    std::size_t grain;
+    explicit dynamic_schedule(std::size_t g = 1) : grain(g > 0 ? g : 1) {}
+};
+
+/**\brief Guided self-scheduling
+ *
+ * Chunks of `remaining / (2 * workers)` elements, but at least
+ * `min_grain`. Chunks start large and shrink towards the end of the
+ * range.
+ */
+struct guided_schedule {
+    std::size_t min_grain;
+    explicit guided_schedule(std::size_t g = 1) : min_grain(g > 0 ? g : 1) {}
+};
+///@}
+
+namespace detail {
+/// Claims chunks of constant size
+struct DynamicClaim {
+    std::size_t length;
+    std::size_t grain;
+    bool operator()(std::atomic<std::size_t>& counter, std::size_t& start,
+                    std::size_t& stop) const {
+        start = counter.fetch_add(grain);
+        if (start >= length) return false;
+        stop = std::min(start + grain, length);
+        return true;
+    }
+};
+
+/// Claims chunks shrinking with the remaining work
+struct GuidedClaim {
+    std::size_t length;
+    std::size_t min_grain;
+    std::size_t no_workers;
+    bool operator()(std::atomic<std::size_t>& counter, std::size_t& start,
+                    std::size_t& stop) const {
+        start = counter.load();
+        do {
+            if (start >= length) return false;
+            std::size_t remaining = length - start;
+            std::size_t grain =
+                std::max(min_grain, remaining / (2 * no_workers));
+            stop = start + std::min(grain, remaining);
+        } while (!counter.compare_exchange_weak(start, stop));
+        return true;
+    }
+};
+
+/**
+ * Calls `f(start, stop)` for chunks [start, stop) covering [0, length)
+ * as given by the schedule.
+ */
+template <class ChunkFunction>
+void for_each_chunk(std::size_t length, ThreadPool& pool, static_schedule,
+                    ChunkFunction& f) {
+    std::size_t no_workers = std::min(pool.size(), length);
+    if (no_workers == 0) return;
+    auto worker = [&](std::size_t w) {
+        f(length * w / no_workers, length * (w + 1) / no_workers);
+    };
+    run_workers(pool, no_workers, worker);
+}
+
+template <class ChunkFunction>
+void for_each_chunk(std::size_t length, ThreadPool& pool,
+                    dynamic_schedule schedule, ChunkFunction& f) {
+    std::size_t grain = schedule.grain;
+    std::size_t no_chunks = (length + grain - 1) / grain;
+    std::size_t no_workers = std::min(pool.size(), no_chunks);
+    if (no_workers == 0) return;
+    run_chunks(pool, length, no_workers, DynamicClaim{length, grain}, f);
+}
+
+template <class ChunkFunction>
+void for_each_chunk(std::size_t length, ThreadPool& pool,
+                    guided_schedule schedule, ChunkFunction& f) {
+    std::size_t min_grain = schedule.min_grain;
+    std::size_t no_chunks = (length + min_grain - 1) / min_grain;
+    std::size_t no_workers = std::min(pool.size(), no_chunks);
+    if (no_workers == 0) return;
+    run_chunks(pool, length, no_workers,
+               GuidedClaim{length, min_grain, no_workers}, f);
+}
+}  // end namespace detail
+
+template <class Iterator, class Functor>
+void parallel_for_each(Iterator begin, Iterator end, Functor f,
+                       ThreadPool& pool, static_schedule) {
+    parallel_for_each(begin, end, f, pool);
+}
+
+template <class Iterator, class Functor>
+void parallel_for_each(Iterator begin, Iterator end, Functor f,
+                       ThreadPool& pool, dynamic_schedule schedule) {
+    static_assert(
+        std::is_base_of<std::random_access_iterator_tag,
+                        typename std::iterator_traits<
+                            Iterator>::iterator_category>::value,
+        "dynamic_schedule requires random access iterators");
+    auto chunk = [begin, &f](std::size_t start, std::size_t stop) {
+        std::for_each(begin + start, begin + stop, f);
+    };
+    detail::for_each_chunk(std::distance(begin, end), pool, schedule, chunk);
+}
+
+template <class Iterator, class Functor>
+void parallel_for_each(Iterator begin, Iterator end, Functor f,
+                       ThreadPool& pool, guided_schedule schedule) {
+    static_assert(
+        std::is_base_of<std::random_access_iterator_tag,
+                        typename std::iterator_traits<
+                            Iterator>::iterator_category>::value,
+        "guided_schedule requires random access iterators");
+    auto chunk = [begin, &f](std::size_t start, std::size_t stop) {
+        std::for_each(begin + start, begin + stop, f);
+    };
+    detail::for_each_chunk(std::distance(begin, end), pool, schedule, chunk);
+}
+
+/**\brief Parallel for each with a random number engine per element
+ *
+ * Calls `f(*it, g)`, where `g` is an `Engine` constructed from
+ * `(seed, index)` and `index` is the position of `it` in the range. With
+ * the default Philox4x32 every element draws from its own stream of the
+ * master seed. The results are the same for any pool size and schedule
+ * and equal to the serial loop
+ *
+ *     for (std::size_t i = 0; i != size; ++i) {
+ *         js::Philox4x32 g(seed, i);
+ *         f(begin[i], g);
+ *     }
+ *
+ * Constructing a Philox4x32 is a few stores, so no engine state is
+ * shared or locked. Requires random access iterators.
+ */
+template <class Engine = Philox4x32, class Iterator, class Functor,
+          class Schedule = static_schedule>
+void parallel_for_each_random(Iterator begin, Iterator end, Functor f,
+                              std::uint64_t seed, ThreadPool& pool,
+                              Schedule schedule = Schedule()) {
+    static_assert(
+        std::is_base_of<std::random_access_iterator_tag,
+                        typename std::iterator_traits<
+                            Iterator>::iterator_category>::value,
+        "parallel_for_each_random requires random access iterators");
+    auto chunk = [begin, seed, &f](std::size_t start, std::size_t stop) {
+        for (std::size_t i = start; i != stop; ++i) {
+            Engine g(seed, i);
+            f(begin[i], g);
+        }
+    };
+    detail::for_each_chunk(std::distance(begin, end), pool, schedule, chunk);
+}
+
+template <class Engine = Philox4x32, class Iterator, class Functor,
+          class Schedule = static_schedule>
+void parallel_for_each_random_auto(Iterator begin, Iterator end, Functor f,
+                                   std::uint64_t seed,
+                                   Schedule schedule = Schedule()) {
+    parallel_for_each_random<Engine>(begin, end, f, seed,
+                                     ThreadPool::global(), schedule);
+}
+
 template <class Iterator, class Functor>
 void parallel_for_each_auto(Iterator begin, Iterator end, Functor f) {
-    long no_threads = std::thread::hardware_concurrency();
-    parallel_for_each(begin, end, f, (no_threads > 1) ? no_threads : 2);
+    parallel_for_each(begin, end, f, ThreadPool::global());
+}
+
+template <class Iterator, class Functor, class Schedule>
+void parallel_for_each_auto(Iterator begin, Iterator end, Functor f,
+                            Schedule schedule) {
+    parallel_for_each(begin, end, f, ThreadPool::global(), schedule);
+}
+
+/**
+ * Prefix scans
+ */
+
+namespace detail {
+/// True if sums of the range can use the unrolled kernel
+template <class Iterator, class T, class BinaryOperator>
+using use_sum_kernel = std::integral_constant<
+    bool,
+    std::is_arithmetic<T>::value &&
+        std::is_arithmetic<
+            typename std::iterator_traits<Iterator>::value_type>::value &&
+        std::is_base_of<std::random_access_iterator_tag,
+                        typename std::iterator_traits<
+                            Iterator>::iterator_category>::value &&
+        (std::is_same<BinaryOperator, std::plus<T>>::value ||
+         std::is_same<BinaryOperator, std::plus<>>::value)>;
+
+/**
+ * Sum with eight independent accumulators. Without the dependency on a
+ * single accumulator the compiler can keep them in vector registers.
+ * Changes the order of floating point additions.
+ */
+template <class Iterator, class T>
+T unrolled_sum(Iterator first, std::size_t n, T init) {
+    T acc[8] = {};
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        for (std::size_t j = 0; j != 8; ++j) {
+            acc[j] += first[i + j];
+        }
+    }
+    for (; i != n; ++i) {
+        acc[i % 8] += first[i];
+    }
+    return init + (((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+                   ((acc[4] + acc[5]) + (acc[6] + acc[7])));
+}
+
+template <class Iterator, class T, class BinaryOperator>
+T block_reduce(Iterator first, Iterator last, T init, BinaryOperator,
+               std::true_type) {
+    return unrolled_sum(first, std::distance(first, last), init);
+}
+
+template <class Iterator, class T, class BinaryOperator>
+T block_reduce(Iterator first, Iterator last, T init, BinaryOperator op,
+               std::false_type) {
+    return std::accumulate(first, last, init, op);
+}
+
+/**
+ * Scans [first, last) into `out`. With `exclusive` the value before an
+ * element is written, otherwise the value including it. `carry` is the
+ * result of the preceding blocks, it is ignored if `has_carry` is false.
+ * `first == out` is allowed.
+ */
+template <class InputIt, class OutputIt, class T, class BinaryOperator>
+void scan_block(InputIt first, InputIt last, OutputIt out, T carry,
+                bool has_carry, bool exclusive, BinaryOperator op) {
+    if (first == last) return;
+    if (exclusive) {
+        T acc = carry;
+        for (; first != last; ++first, ++out) {
+            T value = op(acc, *first);
+            *out = acc;
+            acc = std::move(value);
+        }
+        return;
+    }
+    T acc = has_carry ? op(carry, *first) : T(*first);
+    *out = acc;
+    for (++first, ++out; first != last; ++first, ++out) {
+        acc = op(acc, *first);
+        *out = acc;
+    }
 }
 
+/**
+ * Two pass blocked scan. The first pass reduces every block but the
+ * last, the results are scanned serially to get the carry of every
+ * block, and the second pass scans the blocks with their carry.
+ * `run(no_blocks, f)` executes `f(i)` for every block.
+ */
+template <class InputIt, class OutputIt, class T, class BinaryOperator,
+          class RunWorkers>
+OutputIt parallel_scan(InputIt first, InputIt last, OutputIt d_first, T init,
+                       bool exclusive, BinaryOperator op,
+                       std::size_t no_blocks, RunWorkers run) {
+    std::size_t length = std::distance(first, last);
+    no_blocks = std::min(no_blocks, length);
+    if (no_blocks < 2) {
+        scan_block(first, last, d_first, init, exclusive, exclusive, op);
+        std::advance(d_first, length);
+        return d_first;
+    }
+    std::size_t block_size = length / no_blocks;
+    std::vector<InputIt> in_bounds{first};
+    std::vector<OutputIt> out_bounds{d_first};
+    for (std::size_t i = 1; i != no_blocks; ++i) {
+        in_bounds.push_back(std::next(in_bounds.back(), block_size));
+        out_bounds.push_back(std::next(out_bounds.back(), block_size));
+    }
+    in_bounds.push_back(last);
+    out_bounds.push_back(std::next(out_bounds.back(), length -
+                                                          (no_blocks - 1) *
+                                                              block_size));
+
+    using kernel = use_sum_kernel<InputIt, T, BinaryOperator>;
+    std::vector<T> carry(no_blocks, init);
+    auto reduce = [&](std::size_t i) {
+        if (i + 1 == no_blocks) return;
+        InputIt start = in_bounds[i];
+        T value = *start;
+        carry[i + 1] = block_reduce(++start, in_bounds[i + 1], std::move(value),
+                                    op, kernel{});
+    };
+    run(no_blocks, reduce);
+
+    for (std::size_t i = 1; i != no_blocks; ++i) {
+        if (i > 1 || exclusive) carry[i] = op(carry[i - 1], carry[i]);
+    }
+
+    auto scan = [&](std::size_t i) {
+        scan_block(in_bounds[i], in_bounds[i + 1], out_bounds[i], carry[i],
+                   exclusive || i > 0, exclusive, op);
+    };
+    run(no_blocks, scan);
+    return out_bounds.back();
+}
+}  // end namespace detail
+
+/**\name Prefix scans
+ *
+ * `parallel_inclusive_scan` writes `x0, x0 op x1, x0 op x1 op x2, ...`,
+ * `parallel_exclusive_scan` writes `init, init op x0, init op x0 op x1,
+ * ...` to the range starting at `d_first` and returns the end of the
+ * output range. The input and output ranges may be the same.
+ *
+ * The range is split into one block per worker and read twice: first to
+ * reduce the blocks, then to scan them with the result of the preceding
+ * blocks. `op` has to be associative, but not commutative. For
+ * arithmetic types summed with std::plus, the reduction uses an unrolled
+ * kernel, which reorders floating point additions.
+ */
+///@{
+template <class InputIt, class OutputIt, class BinaryOperator>
+OutputIt parallel_inclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, BinaryOperator op,
+                                 std::size_t no_threads) {
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    auto run = [](std::size_t n, auto& f) { detail::run_threads(n, f); };
+    return detail::parallel_scan(first, last, d_first, T(), false, op,
+                                 no_threads, run);
+}
+
+template <class InputIt, class OutputIt>
+OutputIt parallel_inclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, std::size_t no_threads) {
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    return parallel_inclusive_scan(first, last, d_first, std::plus<T>(),
+                                   no_threads);
+}
+
+template <class InputIt, class OutputIt, class BinaryOperator>
+OutputIt parallel_inclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, BinaryOperator op,
+                                 ThreadPool& pool) {
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    auto run = [&pool](std::size_t n, auto& f) {
+        detail::run_workers(pool, n, f);
+    };
+    return detail::parallel_scan(first, last, d_first, T(), false, op,
+                                 pool.size(), run);
+}
+
+template <class InputIt, class OutputIt>
+OutputIt parallel_inclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, ThreadPool& pool) {
+    using T = typename std::iterator_traits<InputIt>::value_type;
+    return parallel_inclusive_scan(first, last, d_first, std::plus<T>(), pool);
+}
+
+template <class InputIt, class OutputIt, class BinaryOperator>
+OutputIt parallel_inclusive_scan_auto(InputIt first, InputIt last,
+                                      OutputIt d_first, BinaryOperator op) {
+    return parallel_inclusive_scan(first, last, d_first, op,
+                                   ThreadPool::global());
+}
+
+template <class InputIt, class OutputIt>
+OutputIt parallel_inclusive_scan_auto(InputIt first, InputIt last,
+                                      OutputIt d_first) {
+    return parallel_inclusive_scan(first, last, d_first, ThreadPool::global());
+}
+
+template <class InputIt, class OutputIt, class T, class BinaryOperator>
+OutputIt parallel_exclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, T init, BinaryOperator op,
+                                 std::size_t no_threads) {
+    auto run = [](std::size_t n, auto& f) { detail::run_threads(n, f); };
+    return detail::parallel_scan(first, last, d_first, init, true, op,
+                                 no_threads, run);
+}
+
+template <class InputIt, class OutputIt, class T>
+OutputIt parallel_exclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, T init,
+                                 std::size_t no_threads) {
+    return parallel_exclusive_scan(first, last, d_first, init, std::plus<T>(),
+                                   no_threads);
+}
+
+template <class InputIt, class OutputIt, class T, class BinaryOperator>
+OutputIt parallel_exclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, T init, BinaryOperator op,
+                                 ThreadPool& pool) {
+    auto run = [&pool](std::size_t n, auto& f) {
+        detail::run_workers(pool, n, f);
+    };
+    return detail::parallel_scan(first, last, d_first, init, true, op,
+                                 pool.size(), run);
+}
+
+template <class InputIt, class OutputIt, class T>
+OutputIt parallel_exclusive_scan(InputIt first, InputIt last,
+                                 OutputIt d_first, T init, ThreadPool& pool) {
+    return parallel_exclusive_scan(first, last, d_first, init, std::plus<T>(),
+                                   pool);
+}
+
+template <class InputIt, class OutputIt, class T, class BinaryOperator>
+OutputIt parallel_exclusive_scan_auto(InputIt first, InputIt last,
+                                      OutputIt d_first, T init,
+                                      BinaryOperator op) {
+    return parallel_exclusive_scan(first, last, d_first, init, op,
+                                   ThreadPool::global());
+}
+
+template <class InputIt, class OutputIt, class T>
+OutputIt parallel_exclusive_scan_auto(InputIt first, InputIt last,
+                                      OutputIt d_first, T init) {
+    return parallel_exclusive_scan(first, last, d_first, init,
+                                   ThreadPool::global());
+}
+///@}
+
 /**
  * Using std::async for the calculations
  */
@@ -155,7 +923,11 @@ T async_accumulate(Iterator begin, Iterator end, T init, BinaryOperator op) {
         tmp_val.emplace_back(std::async(
             std::launch::async, detail::async_sum<Iterator, BinaryOperator>(),
             iter_start, iter_end, op));
+        iter_start = iter_end;
     }
+    tmp_val.emplace_back(std::async(
+        std::launch::async, detail::async_sum<Iterator, BinaryOperator>(),
+        iter_start, end, op));
     for (auto& t : tmp_val) {
         t.wait();
         init = op(init, t.get());
@@ -163,9 +935,50 @@ T async_accumulate(Iterator begin, Iterator end, T init, BinaryOperator op) {
     return init;
 }
 
+/**
+ * Same as above, but the chunks are submitted to `pool`. While waiting
+ * for the results, the calling thread executes pending pool tasks.
+ */
+template <class Iterator, class T, class BinaryOperator>
+T async_accumulate(Iterator begin, Iterator end, T init, BinaryOperator op,
+                   ThreadPool& pool) {
+    std::size_t length = std::distance(begin, end);
+    std::size_t chunks = std::min(pool.size(), length);
+    if (chunks == 0) return init;
+    std::size_t chunk_size = length / chunks;
+    std::list<std::future<T>> tmp_val;
+    auto iter_start = begin;
+    for (std::size_t i = 0; i != chunks; ++i) {
+        auto iter_end = iter_start;
+        if (i + 1 == chunks) {
+            iter_end = end;
+        } else {
+            std::advance(iter_end, chunk_size);
+        }
+        tmp_val.emplace_back(pool.submit([iter_start, iter_end, op]() -> T {
+            return detail::async_sum<Iterator, BinaryOperator>()(
+                iter_start, iter_end, op);
+        }));
+        iter_start = iter_end;
+    }
+    for (auto& t : tmp_val) {
+        pool.wait_until([&t]() {
+            return t.wait_for(std::chrono::seconds(0)) ==
+                   std::future_status::ready;
+        });
+        init = op(init, t.get());
+    }
+    return init;
+}
+
 template <class Iterator, class T>
 T async_accumulate(Iterator begin, Iterator end, T init) {
     return async_accumulate(begin, end, init, std::plus<T>());
 }
 
+template <class Iterator, class T>
+T async_accumulate(Iterator begin, Iterator end, T init, ThreadPool& pool) {
+    return async_accumulate(begin, end, init, std::plus<T>(), pool);
+}
+
 }  // end js
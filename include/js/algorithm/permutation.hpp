@@ -0,0 +1,169 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../thread/thread_pool.hpp"
+#include "parallel_algorithm.hpp"
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace js {
+
+namespace detail {
+/// Throws std::invalid_argument if [first, last) is no permutation
+template <class IndexIterator>
+void check_permutation(IndexIterator first, IndexIterator last) {
+    std::size_t n = std::distance(first, last);
+    std::vector<bool> seen(n, false);
+    for (; first != last; ++first) {
+        std::size_t i = static_cast<std::size_t>(*first);
+        if (i >= n || seen[i]) {
+            throw std::invalid_argument("Index range is not a permutation");
+        }
+        seen[i] = true;
+    }
+}
+
+template <class... Iterator, std::size_t... I>
+std::tuple<typename std::iterator_traits<Iterator>::value_type...>
+move_out(std::tuple<Iterator...>& ranges, std::size_t i,
+         std::index_sequence<I...>) {
+    return std::tuple<typename std::iterator_traits<Iterator>::value_type...>(
+        std::move(std::get<I>(ranges)[i])...);
+}
+
+template <class... Iterator, std::size_t... I>
+void move_within(std::tuple<Iterator...>& ranges, std::size_t to,
+                 std::size_t from, std::index_sequence<I...>) {
+    int dummy[] = {
+        0, (std::get<I>(ranges)[to] = std::move(std::get<I>(ranges)[from]),
+            0)...};
+    (void)dummy;
+}
+
+template <class... Iterator, class Values, std::size_t... I>
+void move_in(std::tuple<Iterator...>& ranges, std::size_t i, Values& values,
+             std::index_sequence<I...>) {
+    int dummy[] = {
+        0, (std::get<I>(ranges)[i] = std::move(std::get<I>(values)), 0)...};
+    (void)dummy;
+}
+}  // end namespace detail
+
+/**
+ * \brief Reorders ranges in place by an index permutation
+ *
+ * Afterwards element `i` of every range is the element `index[i]` of
+ * before, e.g. the indices of index_sort sort the ranges. The cycles of
+ * the permutation are followed, so every element is moved once and
+ * only one element per range and one bit per index are stored
+ * temporarily. All ranges are permuted in the same pass over the index.
+ * Following a cycle is a chain of dependent random loads, so if memory
+ * permits, apply_permutation_copy is considerably faster.
+ *
+ * Throws std::invalid_argument before any element is moved if the index
+ * range is no permutation of 0, ..., n - 1.
+ */
+template <class IndexIterator, class... RandomAccessIterator>
+void apply_permutation(IndexIterator index_first, IndexIterator index_last,
+                       RandomAccessIterator... ranges) {
+    static_assert(sizeof...(RandomAccessIterator) > 0,
+                  "At least one range required");
+    detail::check_permutation(index_first, index_last);
+    std::size_t n = std::distance(index_first, index_last);
+    auto range_tuple = std::make_tuple(ranges...);
+    auto seq = std::index_sequence_for<RandomAccessIterator...>{};
+    std::vector<bool> done(n, false);
+    for (std::size_t start = 0; start != n; ++start) {
+        if (done[start]) continue;
+        std::size_t j = start;
+        std::size_t k = static_cast<std::size_t>(index_first[j]);
+        done[j] = true;
+        if (k == start) continue;
+        auto first_values = detail::move_out(range_tuple, start, seq);
+        while (k != start) {
+            detail::move_within(range_tuple, j, k, seq);
+            j = k;
+            done[j] = true;
+            k = static_cast<std::size_t>(index_first[j]);
+        }
+        detail::move_in(range_tuple, j, first_values, seq);
+    }
+}
+
+/**
+ * \brief Writes `src[index[i]]` to `dst[i]`
+ *
+ * Out of place version of apply_permutation. Several ranges can be
+ * permuted at once by passing IteratorTuple iterators. The index values
+ * are not checked.
+ */
+template <class IndexIterator, class RandomAccessIterator,
+          class OutputIterator>
+OutputIterator apply_permutation_copy(IndexIterator index_first,
+                                      IndexIterator index_last,
+                                      RandomAccessIterator src,
+                                      OutputIterator dst) {
+    for (; index_first != index_last; ++index_first, ++dst) {
+        *dst = src[*index_first];
+    }
+    return dst;
+}
+
+/**
+ * \brief Parallel version of apply_permutation_copy
+ *
+ * Every worker of `pool` gathers one block of the output. Requires random
+ * access to the index and the output.
+ */
+template <class IndexIterator, class RandomAccessIterator,
+          class OutputIterator>
+OutputIterator apply_permutation_copy(IndexIterator index_first,
+                                      IndexIterator index_last,
+                                      RandomAccessIterator src,
+                                      OutputIterator dst, ThreadPool& pool) {
+    std::size_t n = std::distance(index_first, index_last);
+    std::size_t no_workers = std::min(pool.size(), n);
+    if (no_workers == 0) return dst;
+    auto gather = [&](std::size_t w) {
+        std::size_t lo = n * w / no_workers;
+        std::size_t hi = n * (w + 1) / no_workers;
+        for (std::size_t i = lo; i != hi; ++i) {
+            dst[i] = src[index_first[i]];
+        }
+    };
+    detail::run_workers(pool, no_workers, gather);
+    return dst + n;
+}
+
+template <class IndexIterator, class RandomAccessIterator,
+          class OutputIterator>
+OutputIterator apply_permutation_copy_auto(IndexIterator index_first,
+                                           IndexIterator index_last,
+                                           RandomAccessIterator src,
+                                           OutputIterator dst) {
+    return apply_permutation_copy(index_first, index_last, src, dst,
+                                  ThreadPool::global());
+}
+
+}  // end namespace js
@@ -1,29 +1,322 @@
 #pragma once
 
+#include "../iterator/iterator_tuple.hpp"
+#include "../thread/thread_pool.hpp"
+#include "../type_traits/std_extension.hpp"
+#include "parallel_algorithm.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
 #include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace js {
 
+namespace detail {
+/// Throws std::length_error if `size` indices do not fit into `Index`
+template <class Index>
+void check_index_size(std::size_t size) {
+    static_assert(std::is_integral<Index>::value,
+                  "Index type has to be an integral type");
+    if (size > 0 && size - 1 > static_cast<std::size_t>(
+                                   std::numeric_limits<Index>::max())) {
+        throw std::length_error("Index type too small for the range");
+    }
+}
+
+/// Creates the vector 0, 1, ..., size - 1
+template <class Index>
+std::vector<Index> make_index_vector(std::size_t size) {
+    check_index_size<Index>(size);
+    std::vector<Index> index_vec(size);
+    std::iota(index_vec.begin(), index_vec.end(), static_cast<Index>(0));
+    return index_vec;
+}
+
+/**
+ * Number of elements of A among the first `k` elements of the stable
+ * merge of the sorted ranges A = [a, a + na) and B = [b, b + nb).
+ */
+template <class Iterator, class Comparator>
+std::size_t merge_co_rank(std::size_t k, Iterator a, std::size_t na,
+                          Iterator b, std::size_t nb, Comparator& comp) {
+    std::size_t lo = (k > nb) ? k - nb : 0;
+    std::size_t hi = std::min(k, na);
+    while (lo < hi) {
+        std::size_t i = lo + (hi - lo) / 2;
+        std::size_t j = k - i;
+        // Take more of A while B[j - 1] is not smaller than A[i]
+        if (j > 0 && !comp(b[j - 1], a[i])) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Moves the elements [k0, k1) of the stable merge of the sorted runs
+ * src[lo, mid) and src[mid, hi) to dst[lo + k0, lo + k1). `i0` and `i1`
+ * are the co-ranks of `k0` and `k1`, see merge_co_rank.
+ */
+template <class SrcIterator, class DstIterator, class Comparator>
+void merge_part(SrcIterator src, std::size_t lo, std::size_t mid,
+                DstIterator dst, std::size_t k0, std::size_t k1,
+                std::size_t i0, std::size_t i1, Comparator& comp) {
+    SrcIterator a = src + lo;
+    SrcIterator b = src + mid;
+    std::merge(std::make_move_iterator(a + i0), std::make_move_iterator(a + i1),
+               std::make_move_iterator(b + (k0 - i0)),
+               std::make_move_iterator(b + (k1 - i1)), dst + lo + k0, comp);
+}
+
+/**
+ * Sorts [first, last) by sorting one block per worker and merging the
+ * sorted blocks pairwise. Every merge is split into parts with binary
+ * searches, so all workers are busy until the last merge. `buffer` has
+ * to point to at least as many elements as the range. With `stable` the
+ * blocks are sorted with std::stable_sort and the sort is stable.
+ */
+template <class RandomAccessIterator, class BufferIterator, class Comparator>
+void parallel_merge_sort(RandomAccessIterator first, RandomAccessIterator last,
+                         BufferIterator buffer, Comparator comp,
+                         ThreadPool& pool, bool stable) {
+    std::size_t length = std::distance(first, last);
+    std::size_t no_workers = pool.size();
+    std::size_t no_blocks = std::min(no_workers, length);
+    if (no_blocks < 2) {
+        if (stable) {
+            std::stable_sort(first, last, comp);
+        } else {
+            std::sort(first, last, comp);
+        }
+        return;
+    }
+    std::size_t block_size = length / no_blocks;
+    std::vector<std::size_t> bounds(no_blocks + 1);
+    for (std::size_t i = 0; i != no_blocks; ++i) {
+        bounds[i] = i * block_size;
+    }
+    bounds[no_blocks] = length;
+    auto sort_block = [&](std::size_t i) {
+        if (stable) {
+            std::stable_sort(first + bounds[i], first + bounds[i + 1], comp);
+        } else {
+            std::sort(first + bounds[i], first + bounds[i + 1], comp);
+        }
+    };
+    run_workers(pool, no_blocks, sort_block);
+
+    // Merge pairs of runs, switching between the range and the buffer
+    bool in_buffer = false;
+    while (bounds.size() > 2) {
+        std::size_t no_runs = bounds.size() - 1;
+        std::size_t no_merges = (no_runs + 1) / 2;
+        std::size_t parts = (no_workers + no_merges - 1) / no_merges;
+        // The splits are computed before any element is moved
+        std::vector<std::size_t> split(no_merges * (parts + 1));
+        for (std::size_t m = 0; m != no_merges; ++m) {
+            std::size_t lo = bounds[2 * m];
+            std::size_t mid = bounds[std::min(2 * m + 1, no_runs)];
+            std::size_t hi = bounds[std::min(2 * m + 2, no_runs)];
+            for (std::size_t q = 0; q <= parts; ++q) {
+                std::size_t k = (hi - lo) * q / parts;
+                split[m * (parts + 1) + q] =
+                    in_buffer ? merge_co_rank(k, buffer + lo, mid - lo,
+                                              buffer + mid, hi - mid, comp)
+                              : merge_co_rank(k, first + lo, mid - lo,
+                                              first + mid, hi - mid, comp);
+            }
+        }
+        auto merge_task = [&](std::size_t t) {
+            std::size_t m = t / parts;
+            std::size_t q = t % parts;
+            std::size_t lo = bounds[2 * m];
+            std::size_t mid = bounds[std::min(2 * m + 1, no_runs)];
+            std::size_t hi = bounds[std::min(2 * m + 2, no_runs)];
+            std::size_t k0 = (hi - lo) * q / parts;
+            std::size_t k1 = (hi - lo) * (q + 1) / parts;
+            std::size_t i0 = split[m * (parts + 1) + q];
+            std::size_t i1 = split[m * (parts + 1) + q + 1];
+            if (in_buffer) {
+                merge_part(buffer, lo, mid, first, k0, k1, i0, i1, comp);
+            } else {
+                merge_part(first, lo, mid, buffer, k0, k1, i0, i1, comp);
+            }
+        };
+        run_workers(pool, no_merges * parts, merge_task);
+        std::vector<std::size_t> merged;
+        for (std::size_t i = 0; i < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+        }
+        if (merged.back() != length) merged.push_back(length);
+        bounds.swap(merged);
+        in_buffer = !in_buffer;
+    }
+    if (in_buffer) {
+        auto move_back = [&](std::size_t i) {
+            std::size_t lo = length * i / no_workers;
+            std::size_t hi = length * (i + 1) / no_workers;
+            std::move(buffer + lo, buffer + hi, first + lo);
+        };
+        run_workers(pool, no_workers, move_back);
+    }
+}
+
+/// Inputs shorter than this are sorted serially
+constexpr std::size_t parallel_sort_threshold = 1 << 14;
+
+/**
+ * Sample sort: the elements are distributed into buckets, which are
+ * separated by splitters chosen from a sorted random sample. Every
+ * bucket is then sorted independently. Buckets are handed out
+ * dynamically, so workers with small buckets take more of them.
+ */
+template <class RandomAccessIterator, class Comparator>
+void sample_sort(RandomAccessIterator first, RandomAccessIterator last,
+                 Comparator comp, ThreadPool& pool) {
+    using value_type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    using bucket_type = std::uint16_t;
+    constexpr std::size_t oversampling = 32;
+    std::size_t length = std::distance(first, last);
+    std::size_t no_workers = pool.size();
+    std::size_t no_buckets = std::min<std::size_t>(
+        4 * no_workers, std::numeric_limits<bucket_type>::max());
+
+    // Splitters from a sorted sample, deterministic for a given input
+    std::vector<value_type> sample;
+    sample.reserve(no_buckets * oversampling);
+    std::minstd_rand g(static_cast<std::minstd_rand::result_type>(length));
+    std::uniform_int_distribution<std::size_t> pick(0, length - 1);
+    for (std::size_t i = 0; i != no_buckets * oversampling; ++i) {
+        sample.push_back(first[pick(g)]);
+    }
+    std::sort(sample.begin(), sample.end(), comp);
+    std::vector<value_type> splitters;
+    for (std::size_t b = 1; b != no_buckets; ++b) {
+        splitters.push_back(sample[b * oversampling]);
+    }
+
+    // Classify and count per block
+    std::vector<bucket_type> bucket(length);
+    std::vector<std::vector<std::size_t>> offset(
+        no_workers, std::vector<std::size_t>(no_buckets, 0));
+    auto block_begin = [&](std::size_t i) { return length * i / no_workers; };
+    auto classify = [&](std::size_t w) {
+        auto& count = offset[w];
+        for (std::size_t i = block_begin(w); i != block_begin(w + 1); ++i) {
+            std::size_t b =
+                std::upper_bound(splitters.begin(), splitters.end(), first[i],
+                                 comp) -
+                splitters.begin();
+            bucket[i] = static_cast<bucket_type>(b);
+            ++count[b];
+        }
+    };
+    run_workers(pool, no_workers, classify);
+
+    // Bucket b of block w starts after all smaller buckets and after
+    // bucket b of the preceding blocks
+    std::vector<std::size_t> bucket_bounds(no_buckets + 1, 0);
+    std::size_t position = 0;
+    for (std::size_t b = 0; b != no_buckets; ++b) {
+        bucket_bounds[b] = position;
+        for (std::size_t w = 0; w != no_workers; ++w) {
+            std::size_t count = offset[w][b];
+            offset[w][b] = position;
+            position += count;
+        }
+    }
+    bucket_bounds[no_buckets] = length;
+
+    std::vector<value_type> buffer(length);
+    auto scatter = [&](std::size_t w) {
+        auto& out = offset[w];
+        for (std::size_t i = block_begin(w); i != block_begin(w + 1); ++i) {
+            buffer[out[bucket[i]]++] = std::move(first[i]);
+        }
+    };
+    run_workers(pool, no_workers, scatter);
+
+    auto claim = [no_buckets](std::atomic<std::size_t>& counter,
+                              std::size_t& start, std::size_t& stop) {
+        start = counter.fetch_add(1);
+        stop = start + 1;
+        return start < no_buckets;
+    };
+    auto sort_buckets = [&](std::size_t start, std::size_t stop) {
+        for (std::size_t b = start; b != stop; ++b) {
+            auto lo = buffer.begin() + bucket_bounds[b];
+            auto hi = buffer.begin() + bucket_bounds[b + 1];
+            std::sort(lo, hi, comp);
+            std::move(lo, hi, first + bucket_bounds[b]);
+        }
+    };
+    run_chunks(pool, no_buckets, no_workers, claim, sort_buckets);
+}
+
+/**
+ * Maps arithmetic keys to unsigned integers of the same size, such that
+ * the order of the unsigned integers is the order of the keys. Negative
+ * zero is ordered before positive zero, NaNs are ordered by their bit
+ * pattern at both ends.
+ */
+template <class T, class = void>
+struct RadixKey;
+
+template <class T>
+struct RadixKey<T, std::enable_if_t<std::is_integral<T>::value>> {
+    using type = std::make_unsigned_t<T>;
+    static type get(T value) {
+        type key = static_cast<type>(value);
+        if (std::is_signed<T>::value) {
+            key ^= type(1) << (std::numeric_limits<type>::digits - 1);
+        }
+        return key;
+    }
+};
+
+template <class T>
+struct RadixKey<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8,
+                  "Only 32 and 64 bit floating point types are supported");
+    using type =
+        std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+    static type get(T value) {
+        type key;
+        std::memcpy(&key, &value, sizeof(T));
+        constexpr type sign_bit = type(1) << (sizeof(T) * 8 - 1);
+        return (key & sign_bit) ? ~key : (key | sign_bit);
+    }
+};
+}  // end namespace detail
+
 /**
  * \brief Get indices of random access container using a comparator.
  *
  * Given a comparator, the function returns a vector with the indicies
- * of the sorted random access container.
+ * of the sorted random access container. The index type can be set by
+ * the first template parameter, e.g. `index_sort<std::uint32_t>(...)`
+ * halves the memory of the index vector.
  */
-template <class RandomAccessIterator, class Comparator>
-std::vector<std::size_t> index_sort(RandomAccessIterator begin,
-                                    RandomAccessIterator end, Comparator comp) {
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> index_sort(RandomAccessIterator begin,
+                              RandomAccessIterator end, Comparator comp) {
     std::size_t size = std::distance(
         begin,
         end);  // Note, this makes only sense if begin < end and not end < begin
-    std::vector<std::size_t> index_vec(size);
-    std::iota(index_vec.begin(), index_vec.end(), static_cast<std::size_t>(0));
+    std::vector<Index> index_vec = detail::make_index_vector<Index>(size);
     std::sort(index_vec.begin(), index_vec.end(),
-              [&](std::size_t i1, std::size_t i2) {
-                  return comp(begin[i1], begin[i2]);
-              });
+              [&](Index i1, Index i2) { return comp(begin[i1], begin[i2]); });
 
     return index_vec;
 }
@@ -32,12 +325,448 @@ std::vector<std::size_t> index_sort(RandomAccessIterator begin,
  * \brief Same as <index_sort> but with std::less as comparator
  *
  */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> index_sort(RandomAccessIterator begin,
+                              RandomAccessIterator end) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    return index_sort<Index>(begin, end, std::less<type>());
+}
+
+/**
+ * \brief Parallel version of <index_sort>
+ *
+ * Blocks of the index vector are sorted by the workers of `pool` and
+ * merged afterwards. Needs an additional buffer of the size of the index
+ * vector. The order of equal elements is unspecified.
+ */
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> parallel_index_sort(RandomAccessIterator begin,
+                                       RandomAccessIterator end,
+                                       Comparator comp, ThreadPool& pool) {
+    std::size_t size = std::distance(begin, end);
+    std::vector<Index> index_vec = detail::make_index_vector<Index>(size);
+    std::vector<Index> buffer(size);
+    detail::parallel_merge_sort(
+        index_vec.begin(), index_vec.end(), buffer.begin(),
+        [&](Index i1, Index i2) { return comp(begin[i1], begin[i2]); }, pool,
+        false);
+    return index_vec;
+}
+
+/**
+ * \brief Same as <parallel_index_sort> but with std::less as comparator
+ */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> parallel_index_sort(RandomAccessIterator begin,
+                                       RandomAccessIterator end,
+                                       ThreadPool& pool) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    return parallel_index_sort<Index>(begin, end, std::less<type>(), pool);
+}
+
+namespace detail {
+/**
+ * Orders indices by the referenced values and equal values by the
+ * index, so the k smallest elements are unique.
+ */
+template <class Index, class RandomAccessIterator, class Comparator>
+struct IndexLess {
+    RandomAccessIterator begin;
+    Comparator& comp;
+    bool operator()(Index i1, Index i2) const {
+        if (comp(begin[i1], begin[i2])) return true;
+        if (comp(begin[i2], begin[i1])) return false;
+        return i1 < i2;
+    }
+};
+
+/**
+ * Max heap of the indices of the k smallest elements in [lo, hi). Later
+ * elements have larger indices, so they only enter the heap if they are
+ * strictly smaller than the top, which needs a single comparison.
+ */
+template <class Index, class RandomAccessIterator, class Comparator>
+std::vector<Index> top_k_heap(RandomAccessIterator begin, std::size_t lo,
+                              std::size_t hi, std::size_t k,
+                              Comparator& comp) {
+    IndexLess<Index, RandomAccessIterator, Comparator> less{begin, comp};
+    std::vector<Index> heap;
+    k = std::min(k, hi - lo);
+    if (k == 0) return heap;
+    heap.reserve(k);
+    for (std::size_t i = lo; i != lo + k; ++i) {
+        heap.push_back(static_cast<Index>(i));
+    }
+    std::make_heap(heap.begin(), heap.end(), less);
+    for (std::size_t i = lo + k; i != hi; ++i) {
+        if (comp(begin[i], begin[heap.front()])) {
+            std::pop_heap(heap.begin(), heap.end(), less);
+            heap.back() = static_cast<Index>(i);
+            std::push_heap(heap.begin(), heap.end(), less);
+        }
+    }
+    return heap;
+}
+}  // end namespace detail
+
+/**
+ * \brief Indices of the k smallest elements in sorted order
+ *
+ * Returns the first `min(k, size)` indices of the index vector of a
+ * stable sort, i.e. equal elements are ordered by their index. Uses a heap
+ * of k indices: O(n log k) time and O(k) memory.
+ */
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> index_partial_sort(RandomAccessIterator begin,
+                                      RandomAccessIterator end, std::size_t k,
+                                      Comparator comp) {
+    std::size_t size = std::distance(begin, end);
+    detail::check_index_size<Index>(size);
+    std::vector<Index> heap =
+        detail::top_k_heap<Index>(begin, 0, size, k, comp);
+    std::sort_heap(heap.begin(), heap.end(),
+                   detail::IndexLess<Index, RandomAccessIterator, Comparator>{
+                       begin, comp});
+    return heap;
+}
+
+/**
+ * \brief Same as <index_partial_sort> but with std::less as comparator
+ */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> index_partial_sort(RandomAccessIterator begin,
+                                      RandomAccessIterator end,
+                                      std::size_t k) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    return index_partial_sort<Index>(begin, end, k, std::less<type>());
+}
+
+/**
+ * \brief Indices of the k smallest elements, the largest of them last
+ *
+ * Same set of indices as <index_partial_sort>, but only the last index,
+ * the k-th smallest element, is at its sorted position. The indices are
+ * collected in a buffer of 2k, which is reduced to the k smallest with
+ * std::nth_element when full: O(n) expected time and O(k) memory.
+ */
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> index_nth_element(RandomAccessIterator begin,
+                                     RandomAccessIterator end, std::size_t k,
+                                     Comparator comp) {
+    std::size_t size = std::distance(begin, end);
+    detail::check_index_size<Index>(size);
+    k = std::min(k, size);
+    std::vector<Index> buffer;
+    if (k == 0) return buffer;
+    detail::IndexLess<Index, RandomAccessIterator, Comparator> less{begin,
+                                                                     comp};
+    buffer.reserve(2 * k);
+    auto reduce = [&]() {
+        std::nth_element(buffer.begin(), buffer.begin() + (k - 1),
+                         buffer.end(), less);
+        buffer.resize(k);
+        // Move the k-th smallest to the back
+        std::swap(buffer[k - 1],
+                  *std::max_element(buffer.begin(), buffer.end(), less));
+    };
+    std::size_t i = 0;
+    for (; i != std::min(2 * k, size); ++i) {
+        buffer.push_back(static_cast<Index>(i));
+    }
+    reduce();
+    for (; i != size; ++i) {
+        // New indices are larger, so only strictly smaller elements count
+        if (comp(begin[i], begin[buffer[k - 1]])) {
+            buffer.push_back(static_cast<Index>(i));
+            if (buffer.size() == 2 * k) reduce();
+        }
+    }
+    if (buffer.size() > k) reduce();
+    return buffer;
+}
+
+/**
+ * \brief Same as <index_nth_element> but with std::less as comparator
+ */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> index_nth_element(RandomAccessIterator begin,
+                                     RandomAccessIterator end,
+                                     std::size_t k) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    return index_nth_element<Index>(begin, end, k, std::less<type>());
+}
+
+/**
+ * \brief Parallel version of <index_partial_sort>
+ *
+ * Every worker of `pool` keeps a heap of the k smallest elements of its
+ * block. The heaps are merged at the end, so the result is the same as
+ * the one of <index_partial_sort>.
+ */
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> parallel_index_partial_sort(RandomAccessIterator begin,
+                                               RandomAccessIterator end,
+                                               std::size_t k, Comparator comp,
+                                               ThreadPool& pool) {
+    std::size_t size = std::distance(begin, end);
+    detail::check_index_size<Index>(size);
+    std::size_t no_workers = std::min(pool.size(), size);
+    if (no_workers < 2) {
+        return index_partial_sort<Index>(begin, end, k, comp);
+    }
+    std::vector<std::vector<Index>> heaps(no_workers);
+    auto worker = [&](std::size_t w) {
+        heaps[w] = detail::top_k_heap<Index>(begin, size * w / no_workers,
+                                             size * (w + 1) / no_workers, k,
+                                             comp);
+    };
+    detail::run_workers(pool, no_workers, worker);
+    std::vector<Index> merged;
+    for (const auto& heap : heaps) {
+        merged.insert(merged.end(), heap.begin(), heap.end());
+    }
+    k = std::min(k, merged.size());
+    std::partial_sort(
+        merged.begin(), merged.begin() + k, merged.end(),
+        detail::IndexLess<Index, RandomAccessIterator, Comparator>{begin,
+                                                                   comp});
+    merged.resize(k);
+    return merged;
+}
+
+/**
+ * \brief Same as <parallel_index_partial_sort> but with std::less as
+ * comparator
+ */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> parallel_index_partial_sort(RandomAccessIterator begin,
+                                               RandomAccessIterator end,
+                                               std::size_t k,
+                                               ThreadPool& pool) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    return parallel_index_partial_sort<Index>(begin, end, k, std::less<type>(),
+                                              pool);
+}
+
+template <class Index = std::size_t, class RandomAccessIterator,
+          class Comparator>
+std::vector<Index> parallel_index_partial_sort_auto(RandomAccessIterator begin,
+                                                    RandomAccessIterator end,
+                                                    std::size_t k,
+                                                    Comparator comp) {
+    return parallel_index_partial_sort<Index>(begin, end, k, comp,
+                                              ThreadPool::global());
+}
+
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> parallel_index_partial_sort_auto(RandomAccessIterator begin,
+                                                    RandomAccessIterator end,
+                                                    std::size_t k) {
+    return parallel_index_partial_sort<Index>(begin, end, k,
+                                              ThreadPool::global());
+}
+
+/**
+ * \brief Parallel version of std::sort
+ *
+ * Sample sort on the workers of `pool`: the elements are distributed into
+ * buckets by splitters taken from a sorted sample and the buckets are
+ * sorted independently. Ranges shorter than 2^14 elements are sorted with
+ * std::sort. Needs a buffer of the size of the range, so the value type
+ * has to be default constructible and move assignable.
+ */
+template <class RandomAccessIterator, class Comparator>
+void parallel_sort(RandomAccessIterator first, RandomAccessIterator last,
+                   Comparator comp, ThreadPool& pool) {
+    std::size_t length = std::distance(first, last);
+    if (length < detail::parallel_sort_threshold || pool.size() < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+    detail::sample_sort(first, last, comp, pool);
+}
+
+/**
+ * \brief Same as <parallel_sort> but with std::less as comparator
+ */
 template <class RandomAccessIterator>
-std::vector<std::size_t> index_sort(RandomAccessIterator begin,
-                                    RandomAccessIterator end) {
+void parallel_sort(RandomAccessIterator first, RandomAccessIterator last,
+                   ThreadPool& pool) {
     using type =
         typename std::iterator_traits<RandomAccessIterator>::value_type;
-    return index_sort(begin, end, std::less<type>());
+    parallel_sort(first, last, std::less<type>(), pool);
+}
+
+template <class RandomAccessIterator, class Comparator>
+void parallel_sort_auto(RandomAccessIterator first, RandomAccessIterator last,
+                        Comparator comp) {
+    parallel_sort(first, last, comp, ThreadPool::global());
+}
+
+template <class RandomAccessIterator>
+void parallel_sort_auto(RandomAccessIterator first,
+                        RandomAccessIterator last) {
+    parallel_sort(first, last, ThreadPool::global());
+}
+
+/**
+ * \brief Parallel version of std::stable_sort
+ *
+ * One block per worker is sorted with std::stable_sort, then the blocks
+ * are merged pairwise. Every merge is split between the workers, so the
+ * last merges are parallel as well. Ranges shorter than 2^14 elements are
+ * sorted with std::stable_sort. Needs a buffer of the size of the range,
+ * so the value type has to be default constructible and move assignable.
+ */
+template <class RandomAccessIterator, class Comparator>
+void parallel_stable_sort(RandomAccessIterator first,
+                          RandomAccessIterator last, Comparator comp,
+                          ThreadPool& pool) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    std::size_t length = std::distance(first, last);
+    if (length < detail::parallel_sort_threshold || pool.size() < 2) {
+        std::stable_sort(first, last, comp);
+        return;
+    }
+    std::vector<type> buffer(length);
+    detail::parallel_merge_sort(first, last, buffer.begin(), comp, pool,
+                                true);
+}
+
+/**
+ * \brief Same as <parallel_stable_sort> but with std::less as comparator
+ */
+template <class RandomAccessIterator>
+void parallel_stable_sort(RandomAccessIterator first,
+                          RandomAccessIterator last, ThreadPool& pool) {
+    using type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    parallel_stable_sort(first, last, std::less<type>(), pool);
+}
+
+template <class RandomAccessIterator, class Comparator>
+void parallel_stable_sort_auto(RandomAccessIterator first,
+                               RandomAccessIterator last, Comparator comp) {
+    parallel_stable_sort(first, last, comp, ThreadPool::global());
+}
+
+template <class RandomAccessIterator>
+void parallel_stable_sort_auto(RandomAccessIterator first,
+                               RandomAccessIterator last) {
+    parallel_stable_sort(first, last, ThreadPool::global());
+}
+
+namespace detail {
+template <class... T>
+using all_iterators = conjugation<is_iterator<T>...>;
+}  // end namespace detail
+
+/**
+ * \brief Sorts the keys and reorders the value ranges accordingly
+ *
+ * The ranges are sorted together through an IteratorTuple, like zipped
+ * ranges, so no index vector or temporary copies are needed. The value
+ * ranges start at `values` and have the length of the key range. The
+ * order of equal keys is unspecified.
+ */
+template <class KeyIterator, class Comparator, class... ValueIterator>
+std::enable_if_t<!detail::is_iterator<Comparator>::value>
+sort_by_key(KeyIterator keys_first, KeyIterator keys_last, Comparator comp,
+            ValueIterator... values) {
+    auto first = makeIteratorTuple(keys_first, values...);
+    auto last = first + std::distance(keys_first, keys_last);
+    std::sort(first, last, [&comp](const auto& a, const auto& b) {
+        return comp(std::get<0>(a), std::get<0>(b));
+    });
+}
+
+/**
+ * \brief Same as <sort_by_key> but with std::less as comparator
+ */
+template <class KeyIterator, class... ValueIterator>
+std::enable_if_t<detail::all_iterators<ValueIterator...>::value> sort_by_key(
+    KeyIterator keys_first, KeyIterator keys_last, ValueIterator... values) {
+    using type = typename std::iterator_traits<KeyIterator>::value_type;
+    sort_by_key(keys_first, keys_last, std::less<type>(), values...);
+}
+
+/**
+ * \brief LSD radix index sort for arithmetic types
+ *
+ * Sorts pairs of (key, index) in ascending order with one pass per byte
+ * of the key. The keys are read once, so there are no indirect loads
+ * during sorting. Passes in which all keys have the same byte are
+ * skipped. The sort is stable.
+ *
+ * Floating point keys are ordered by std::less, except that -0 is placed
+ * before +0 and NaNs are placed at the beginning (negative NaN) or the end
+ * (positive NaN).
+ */
+template <class Index = std::size_t, class RandomAccessIterator>
+std::vector<Index> radix_index_sort(RandomAccessIterator begin,
+                                    RandomAccessIterator end) {
+    using value_type =
+        typename std::iterator_traits<RandomAccessIterator>::value_type;
+    static_assert(std::is_arithmetic<value_type>::value &&
+                      !std::is_same<value_type, bool>::value,
+                  "radix_index_sort requires arithmetic keys");
+    using radix_key = detail::RadixKey<value_type>;
+    using key_type = typename radix_key::type;
+    struct Entry {
+        key_type key;
+        Index index;
+    };
+    constexpr std::size_t no_passes = sizeof(key_type);
+    constexpr std::size_t no_buckets = 256;
+
+    std::size_t size = std::distance(begin, end);
+    detail::check_index_size<Index>(size);
+    std::vector<Entry> entries(size);
+    std::vector<std::array<std::size_t, no_buckets>> histogram(no_passes);
+    for (auto& h : histogram) {
+        h.fill(0);
+    }
+    for (std::size_t i = 0; i != size; ++i) {
+        key_type key = radix_key::get(begin[i]);
+        entries[i] = Entry{key, static_cast<Index>(i)};
+        for (std::size_t pass = 0; pass != no_passes; ++pass) {
+            ++histogram[pass][(key >> (8 * pass)) & 0xff];
+        }
+    }
+
+    std::vector<Entry> buffer(size);
+    for (std::size_t pass = 0; pass != no_passes; ++pass) {
+        auto& count = histogram[pass];
+        if (std::find(count.begin(), count.end(), size) != count.end()) {
+            continue;
+        }
+        std::size_t offset = 0;
+        for (auto& c : count) {
+            std::size_t tmp = c;
+            c = offset;
+            offset += tmp;
+        }
+        for (const auto& e : entries) {
+            buffer[count[(e.key >> (8 * pass)) & 0xff]++] = e;
+        }
+        entries.swap(buffer);
+    }
+
+    std::vector<Index> index_vec(size);
+    for (std::size_t i = 0; i != size; ++i) {
+        index_vec[i] = entries[i].index;
+    }
+    return index_vec;
 }
 
 }  // end namespace js
@@ -0,0 +1,289 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../iterator/iterator_tuple.hpp"
+#include "../memory/aligned_allocator.hpp"
+#include "../tuple/taggedtuple.hpp"
+#include "../tuple/tuple_functions.hpp"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace js {
+
+/**\ingroup container
+ * \brief Column of a SoAVector
+ */
+template <class T>
+using soa_column_t = std::vector<T, AlignedAllocator<T>>;
+
+/**\ingroup container
+ * \brief Reference to a row of a SoAVector
+ *
+ * Tuple of references to the elements of the row. Assignment writes
+ * through to the columns. The elements can be accessed by tag with
+ * `get<Tag>(row)` or by position with `std::get<I>(row)`.
+ */
+template <bool IsConst, class... Tags>
+class SoARow
+    : public detail::ReferenceTuple<
+          std::conditional_t<IsConst, const tag_t<Tags>&, tag_t<Tags>&>...> {
+  private:
+    using base = detail::ReferenceTuple<
+        std::conditional_t<IsConst, const tag_t<Tags>&, tag_t<Tags>&>...>;
+
+  public:
+    using base::base;
+    using base::operator=;
+};
+
+/**\ingroup container
+ * \brief Get element of tag in a row of a SoAVector
+ */
+template <class Tag, bool IsConst, class... Tags>
+decltype(auto) get(const SoARow<IsConst, Tags...>& row) {
+    return std::get<detail::FindTagIndex<Tag, Tags...>::value>(row);
+}
+
+/**\ingroup container
+ * \brief Vector of TaggedTuple values stored as struct of arrays
+ *
+ * Every tag gets its own contiguous column of `Tag::type`, aligned to a
+ * cache line. Loops touching only a few fields therefore only load those
+ * fields and can be vectorized, e.g.
+ * \code{.cpp}
+ * struct Energy { using type = double; };
+ * struct Id { using type = int; };
+ *
+ * SoAVector<Id, Energy> particles;
+ * particles.emplace_back(1, 0.5);
+ * double sum = 0;
+ * for (double e : get<Energy>(particles)) sum += e;
+ * \endcode
+ *
+ * `operator[]` returns a SoARow. The iterators are IteratorTuple over the
+ * column iterators, like the iterators of ZipBase, so the rows can be
+ * sorted with std::sort.
+ */
+template <class... Tags>
+class SoAVector {
+    static_assert(sizeof...(Tags) > 0, "SoAVector needs at least one tag");
+
+  public:
+    using value_type = TaggedTuple<Tags...>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = SoARow<false, Tags...>;
+    using const_reference = SoARow<true, Tags...>;
+    using iterator =
+        IteratorTuple<typename soa_column_t<tag_t<Tags>>::iterator...>;
+    using const_iterator =
+        IteratorTuple<typename soa_column_t<tag_t<Tags>>::const_iterator...>;
+
+  private:
+    using index_sequence = std::index_sequence_for<Tags...>;
+
+    std::tuple<soa_column_t<tag_t<Tags>>...> _columns;
+
+    template <class F>
+    void for_each_column(F f) {
+        for_each_tuple(_columns, f);
+    }
+
+    template <std::size_t... I>
+    reference row(size_type i, std::index_sequence<I...>) {
+        return reference(std::get<I>(_columns)[i]...);
+    }
+    template <std::size_t... I>
+    const_reference row(size_type i, std::index_sequence<I...>) const {
+        return const_reference(std::get<I>(_columns)[i]...);
+    }
+    template <std::size_t... I>
+    iterator make_iterator(size_type i, std::index_sequence<I...>) {
+        return iterator(std::get<I>(_columns).begin() + i...);
+    }
+    template <std::size_t... I>
+    const_iterator make_iterator(size_type i,
+                                 std::index_sequence<I...>) const {
+        return const_iterator(std::get<I>(_columns).cbegin() + i...);
+    }
+
+    template <class... Arg, std::size_t... I>
+    void emplace_back_impl(std::index_sequence<I...>, Arg&&... arg);
+    template <class Tuple, std::size_t... I>
+    void push_back_impl(Tuple&& tuple, std::index_sequence<I...>) {
+        emplace_back_impl(index_sequence{},
+                          std::get<I>(std::forward<Tuple>(tuple))...);
+    }
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    SoAVector() = default;
+    /// Creates `size` value initialized rows
+    explicit SoAVector(size_type size) { resize(size); }
+    ///@}
+
+    /**@name Capacity
+     */
+    ///@{
+    size_type size() const noexcept { return std::get<0>(_columns).size(); }
+    bool empty() const noexcept { return size() == 0; }
+    /// Smallest capacity of the columns
+    size_type capacity() const noexcept;
+    void reserve(size_type n) {
+        for_each_column([n](auto& c) { c.reserve(n); });
+    }
+    void shrink_to_fit() {
+        for_each_column([](auto& c) { c.shrink_to_fit(); });
+    }
+    ///@}
+
+    /**@name Modifiers
+     * If the constructor of an element throws, the rows are unchanged.
+     */
+    ///@{
+    /// Append row, the arguments are given in the order of the tags
+    template <class... Arg>
+    void emplace_back(Arg&&... arg) {
+        static_assert(sizeof...(Arg) == sizeof...(Tags),
+                      "One argument per tag required");
+        emplace_back_impl(index_sequence{}, std::forward<Arg>(arg)...);
+    }
+    /// Append row, also accepts TaggedTuple<Tags...>
+    void push_back(const tuple_t<Tags...>& value) {
+        push_back_impl(value, index_sequence{});
+    }
+    void push_back(tuple_t<Tags...>&& value) {
+        push_back_impl(std::move(value), index_sequence{});
+    }
+    void pop_back() {
+        for_each_column([](auto& c) { c.pop_back(); });
+    }
+    void resize(size_type n) {
+        for_each_column([n](auto& c) { c.resize(n); });
+    }
+    void clear() noexcept {
+        for_each_column([](auto& c) { c.clear(); });
+    }
+    ///@}
+
+    /**@name Element access
+     */
+    ///@{
+    reference operator[](size_type i) { return row(i, index_sequence{}); }
+    const_reference operator[](size_type i) const {
+        return row(i, index_sequence{});
+    }
+    reference front() { return (*this)[0]; }
+    reference back() { return (*this)[size() - 1]; }
+    /// Column of `Tag`
+    template <class Tag>
+    soa_column_t<tag_t<Tag>>& column() noexcept {
+        return std::get<detail::FindTagIndex<Tag, Tags...>::value>(_columns);
+    }
+    template <class Tag>
+    const soa_column_t<tag_t<Tag>>& column() const noexcept {
+        return std::get<detail::FindTagIndex<Tag, Tags...>::value>(_columns);
+    }
+    /// Pointer to the cache line aligned data of the column of `Tag`
+    template <class Tag>
+    tag_t<Tag>* data() noexcept {
+        return column<Tag>().data();
+    }
+    template <class Tag>
+    const tag_t<Tag>* data() const noexcept {
+        return column<Tag>().data();
+    }
+    ///@}
+
+    /**@name Iterators
+     */
+    ///@{
+    iterator begin() { return make_iterator(0, index_sequence{}); }
+    iterator end() { return make_iterator(size(), index_sequence{}); }
+    const_iterator begin() const { return make_iterator(0, index_sequence{}); }
+    const_iterator end() const {
+        return make_iterator(size(), index_sequence{});
+    }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    ///@}
+
+    void swap(SoAVector& other) noexcept { _columns.swap(other._columns); }
+};
+
+/**\ingroup container
+ * \brief Get column of tag in SoAVector
+ */
+template <class Tag, class... Tags>
+soa_column_t<tag_t<Tag>>& get(SoAVector<Tags...>& soa) noexcept {
+    return soa.template column<Tag>();
+}
+
+/**\ingroup container
+ * \brief Get column of tag in const SoAVector
+ */
+template <class Tag, class... Tags>
+const soa_column_t<tag_t<Tag>>& get(const SoAVector<Tags...>& soa) noexcept {
+    return soa.template column<Tag>();
+}
+
+template <class... Tags>
+void swap(SoAVector<Tags...>& a, SoAVector<Tags...>& b) noexcept {
+    a.swap(b);
+}
+
+/*
+ * Functions implementations
+ */
+
+template <class... Tags>
+typename SoAVector<Tags...>::size_type SoAVector<Tags...>::capacity() const
+    noexcept {
+    size_type cap = std::get<0>(_columns).capacity();
+    for_each_tuple(_columns, [&cap](const auto& c) {
+        if (c.capacity() < cap) cap = c.capacity();
+    });
+    return cap;
+}
+
+template <class... Tags>
+template <class... Arg, std::size_t... I>
+void SoAVector<Tags...>::emplace_back_impl(std::index_sequence<I...>,
+                                           Arg&&... arg) {
+    size_type old_size = size();
+    try {
+        int dummy[] = {
+            0, (std::get<I>(_columns).emplace_back(std::forward<Arg>(arg)),
+                0)...};
+        (void)dummy;
+    } catch (...) {
+        for_each_column([old_size](auto& c) {
+            if (c.size() > old_size) c.pop_back();
+        });
+        throw;
+    }
+}
+
+}  // end namespace js
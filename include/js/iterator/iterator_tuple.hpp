@@ -27,22 +27,90 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace js {
 
 namespace detail {
+/**
+ * Tuple of the references of the iterators. Assignment writes through
+ * the references and swap exchanges the referenced values, so that
+ * algorithms like std::sort can permute the elements of zipped ranges.
+ */
+template <class... Ref>
+class ReferenceTuple : public std::tuple<Ref...> {
+  private:
+    using base = std::tuple<Ref...>;
+
+    template <std::size_t... I>
+    void swap_impl(ReferenceTuple& other, std::index_sequence<I...>) {
+        using std::swap;
+        int dummy[] = {0, (swap(std::get<I>(*this), std::get<I>(other)), 0)...};
+        (void)dummy;
+    }
+
+  public:
+    ReferenceTuple(Ref... ref) : base(std::forward<Ref>(ref)...) {}
+    ReferenceTuple(const ReferenceTuple&) = default;
+    ReferenceTuple(ReferenceTuple&&) = default;
+
+    ReferenceTuple& operator=(const ReferenceTuple& other) {
+        base::operator=(static_cast<const base&>(other));
+        return *this;
+    }
+    ReferenceTuple& operator=(ReferenceTuple&& other) {
+        base::operator=(static_cast<base&&>(other));
+        return *this;
+    }
+    template <class... T>
+    ReferenceTuple& operator=(const std::tuple<T...>& other) {
+        base::operator=(other);
+        return *this;
+    }
+    template <class... T>
+    ReferenceTuple& operator=(std::tuple<T...>&& other) {
+        base::operator=(std::move(other));
+        return *this;
+    }
+
+    friend void swap(ReferenceTuple&& a, ReferenceTuple&& b) {
+        a.swap_impl(b, std::index_sequence_for<Ref...>{});
+    }
+    friend void swap(ReferenceTuple& a, ReferenceTuple& b) {
+        a.swap_impl(b, std::index_sequence_for<Ref...>{});
+    }
+};
+
 template <class... Iterator>
-using reference_t = std::tuple<typename std::iterator_traits<Iterator>::reference...>;
+using reference_t =
+    ReferenceTuple<typename std::iterator_traits<Iterator>::reference...>;
 
 template <class... Iter>
 using iterator_t = std::tuple<Iter...>;
 
+/// Weakest of the given iterator categories
+template <class... Category>
+struct weakest_category;
+
+template <class Category>
+struct weakest_category<Category> {
+    using type = Category;
+};
+
+template <class C1, class C2, class... Tail>
+struct weakest_category<C1, C2, Tail...>
+    : weakest_category<std::conditional_t<std::is_base_of<C1, C2>::value, C1,
+                                          C2>,
+                       Tail...> {};
+
+template <class... Iter>
+using iterator_category_t = typename weakest_category<
+    typename std::iterator_traits<Iter>::iterator_category...>::type;
+
 template <class F, class Iterator, std::size_t... I>
 void iter_impl(F&& f, Iterator& iter, std::index_sequence<I...>) {
     int dummy[] = {0, (f(std::get<I>(iter)), 0)...};
     (void)dummy;
 }
 
-template <class Iterator, std::size_t... I>
-decltype(auto) make_deref_impl(const Iterator& iter,
-                               std::index_sequence<I...>) {
-    return std::tie(*std::get<I>(iter)...);
+template <class Reference, class Iterator, std::size_t... I>
+Reference make_deref_impl(const Iterator& iter, std::index_sequence<I...>) {
+    return Reference(*std::get<I>(iter)...);
 }
 }  // end namespace detail
 
@@ -58,6 +126,12 @@ decltype(auto) make_deref_impl(const Iterator& iter,
  *
  * std::tuple<typename Container::iterator::reference...>
  *
+ * The iterator category is the weakest category of the iterators. If
+ * all iterators have random access, so does the tuple, and zipped ranges
+ * can be sorted in place with std::sort or split into chunks in O(1).
+ * Comparisons and differences only use the first iterator, since all
+ * iterators move in lockstep.
+ *
  * ###Issues:
  *  * This implementation makes needless and potentially time consuming
  *  copies of reference_t<Iter...> while dereferencing.
@@ -71,11 +145,21 @@ class IteratorTuple {
     using value_type = std::tuple<typename std::iterator_traits<Iter>::value_type...>;
     using reference = detail::reference_t<Iter...>;
     using pointer = std::tuple<typename std::iterator_traits<Iter>::pointer...>;
+    using iterator_category = detail::iterator_category_t<Iter...>;
 
   private:
     detail::iterator_t<Iter...> _iter_pos;
 
+    static constexpr bool random_access =
+        std::is_base_of<std::random_access_iterator_tag,
+                        iterator_category>::value;
+
+    const std::tuple_element_t<0, detail::iterator_t<Iter...>>& first() const {
+        return std::get<0>(_iter_pos);
+    }
+
   public:
+    IteratorTuple() : _iter_pos() {}
     // Create from iterator tuple
     /*
     IteratorTuple(const std::tuple<Iter...>& tuple) : _iter_pos(tuple) {}
@@ -112,10 +196,61 @@ class IteratorTuple {
         return tmp;
     }
 
-    reference operator*() {
-        return detail::make_deref_impl(_iter_pos,
-                                       std::index_sequence_for<Iter...>{});
+    reference operator*() const {
+        return detail::make_deref_impl<reference>(
+            _iter_pos, std::index_sequence_for<Iter...>{});
+    }
+
+    /**@name Random access
+     * Only available if all iterators have random access.
+     */
+    ///@{
+    IteratorTuple<Iter...>& operator+=(difference_type n) {
+        static_assert(random_access, "Requires random access iterators");
+        detail::iter_impl([n](auto& i) -> void { i += n; }, _iter_pos,
+                          std::index_sequence_for<Iter...>{});
+        return *this;
+    }
+    IteratorTuple<Iter...>& operator-=(difference_type n) {
+        return *this += -n;
+    }
+    IteratorTuple<Iter...> operator+(difference_type n) const {
+        auto tmp = *this;
+        return tmp += n;
+    }
+    friend IteratorTuple<Iter...> operator+(difference_type n,
+                                            const IteratorTuple<Iter...>& i) {
+        return i + n;
+    }
+    IteratorTuple<Iter...> operator-(difference_type n) const {
+        auto tmp = *this;
+        return tmp -= n;
+    }
+    friend difference_type operator-(const IteratorTuple<Iter...>& i1,
+                                     const IteratorTuple<Iter...>& i2) {
+        static_assert(random_access, "Requires random access iterators");
+        return i1.first() - i2.first();
+    }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    friend bool operator<(const IteratorTuple<Iter...>& i1,
+                          const IteratorTuple<Iter...>& i2) {
+        static_assert(random_access, "Requires random access iterators");
+        return i1.first() < i2.first();
+    }
+    friend bool operator>(const IteratorTuple<Iter...>& i1,
+                          const IteratorTuple<Iter...>& i2) {
+        return i2 < i1;
+    }
+    friend bool operator<=(const IteratorTuple<Iter...>& i1,
+                           const IteratorTuple<Iter...>& i2) {
+        return !(i2 < i1);
+    }
+    friend bool operator>=(const IteratorTuple<Iter...>& i1,
+                           const IteratorTuple<Iter...>& i2) {
+        return !(i1 < i2);
     }
+    ///@}
 
     IteratorTuple<Iter...>& operator=(const IteratorTuple<Iter...>& iter) {
         _iter_pos = iter._iter_pos;
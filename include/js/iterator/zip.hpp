@@ -96,9 +96,17 @@ decltype(auto) make_iter_from_tuples(std::index_sequence<T...>, C& c,
  * Be careful, the containers **must** have the same size, the otherwise
  * the behavior is undefined.
  *
+ * The iterators have random access if all containers have random access,
+ * so zipped containers can be sorted, e.g.
+ * \code{.cpp}
+ * auto zip = makeZip(keys, values);
+ * std::sort(zip.begin(), zip.end(), [](const auto& a, const auto& b) {
+ *     return std::get<0>(a) < std::get<0>(b);
+ * });
+ * \endcode
+ *
  * ###Issues:
  * * Zip does not fulfill the requirements for a container.
- * * Add random access if constructing container have random access.
  * * Range base for loops only with r-value ref
  */
 template <class... Arg>
@@ -118,7 +126,9 @@ class ZipBase {
   public:
     ZipBase() = delete;
     ZipBase(Arg&... arg)
-        : _container(arg...), _max_length(calc_max_length(arg...)) {}
+        : _container(arg...), _max_length(calc_max_length(arg...)) {
+        container_size(_length, arg...);
+    }
     ZipBase(const ZipBase<Arg...>& z)
         : _container(z._container),
           _max_length(z._max_length),
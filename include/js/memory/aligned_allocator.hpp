@@ -0,0 +1,110 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <vector>
+
+namespace js {
+
+/**\ingroup memory
+ * \brief Assumed size of a cache line in bytes
+ */
+constexpr std::size_t cache_line_size = 64;
+
+/**\ingroup memory
+ * \brief Allocator returning memory aligned to `Alignment` bytes
+ *
+ * The default alignment is a cache line, so that arrays start at a cache
+ * line and can be loaded with aligned vector instructions. `Alignment`
+ * has to be a power of two and a multiple of `sizeof(void*)`.
+ */
+template <class T, std::size_t Alignment = cache_line_size>
+class AlignedAllocator {
+    static_assert(Alignment >= alignof(T),
+                  "Alignment has to be at least the alignment of T");
+    static_assert((Alignment & (Alignment - 1)) == 0,
+                  "Alignment has to be a power of two");
+    static_assert(Alignment % sizeof(void*) == 0,
+                  "Alignment has to be a multiple of sizeof(void*)");
+
+  public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    static constexpr std::size_t alignment = Alignment;
+
+    template <class U>
+    struct rebind {
+        using other = AlignedAllocator<U, Alignment>;
+    };
+
+    AlignedAllocator() noexcept = default;
+    template <class U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_alloc();
+        }
+        void* ptr = nullptr;
+        if (::posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+    }
+    void deallocate(T* ptr, std::size_t) noexcept { std::free(ptr); }
+};
+
+template <class T, class U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) noexcept {
+    return true;
+}
+
+template <class T, class U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T, Alignment>&,
+                const AlignedAllocator<U, Alignment>&) noexcept {
+    return false;
+}
+
+/**\ingroup memory
+ * \brief Value occupying whole cache lines
+ *
+ * Threads writing to neighbouring elements of an array of
+ * CacheLinePadded values do not share cache lines (no false sharing).
+ * Arrays have to be allocated with AlignedAllocator, see padded_vector.
+ */
+template <class T>
+struct alignas(cache_line_size) CacheLinePadded {
+    T value;
+};
+
+/**\ingroup memory
+ * \brief Vector of cache line padded values
+ */
+template <class T>
+using padded_vector =
+    std::vector<CacheLinePadded<T>, AlignedAllocator<CacheLinePadded<T>>>;
+
+}  // end namespace js
@@ -0,0 +1,561 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "stopwatch.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <ratio>
+#include <utility>
+#include <vector>
+
+/**\defgroup profiler Profiler
+ * \brief Scoped timers aggregated into per thread call trees
+ *
+ * Scopes are instrumented with
+ * \code{.cpp}
+ * void f() {
+ *     JS_PROFILE_SCOPE("f");
+ *     ...
+ * }
+ * \endcode
+ * Nothing is recorded until `js::Profiler::enable()` is called. While
+ * disabled, a scope costs one load of an atomic flag and one branch.
+ * Defining `JS_NO_PROFILING` removes the scopes completely.
+ *
+ * Every thread records into its own call tree, so recording needs no
+ * locks. The reports merge the trees of all threads and can be created
+ * while other threads are still recording.
+ */
+
+namespace js {
+
+/**\ingroup profiler
+ * \brief Static description of an instrumented scope
+ */
+struct ProfileZone {
+    const char* name;
+    const char* file;
+    int line;
+};
+
+namespace detail {
+/**
+ * Append only storage of the owning thread. Elements are published with
+ * a release store of the size, so other threads can read all elements
+ * below `size()` without locks. Storage is allocated in chunks and never
+ * moves.
+ */
+template <class T, std::size_t ChunkSize, std::size_t MaxChunks>
+class ChunkedLog {
+  private:
+    std::unique_ptr<T[]> _chunks[MaxChunks];
+    std::atomic<std::uint32_t> _size;
+
+  public:
+    static constexpr std::size_t max_size = ChunkSize * MaxChunks;
+
+    ChunkedLog() : _size(0) {}
+
+    /// Number of published elements
+    std::uint32_t size() const noexcept {
+        return _size.load(std::memory_order_acquire);
+    }
+    T& operator[](std::size_t i) {
+        return _chunks[i / ChunkSize][i % ChunkSize];
+    }
+    const T& operator[](std::size_t i) const {
+        return _chunks[i / ChunkSize][i % ChunkSize];
+    }
+
+    /**
+     * Called by the owning thread only. Initializes a new element with
+     * `init` and publishes it. Returns false if the log is full.
+     */
+    template <class Init>
+    bool push(Init init) {
+        std::uint32_t i = _size.load(std::memory_order_relaxed);
+        if (i == max_size) return false;
+        std::unique_ptr<T[]>& chunk = _chunks[i / ChunkSize];
+        if (!chunk) chunk.reset(new T[ChunkSize]);
+        init(chunk[i % ChunkSize]);
+        _size.store(i + 1, std::memory_order_release);
+        return true;
+    }
+
+    void clear() noexcept { _size.store(0, std::memory_order_release); }
+};
+
+/**
+ * Node of a call tree. `zone` and `parent` do not change after the node
+ * is published. The statistics are only written by the owning thread,
+ * they are atomic so that reports can read them while recording.
+ */
+struct ProfileNode {
+    const ProfileZone* zone;
+    std::uint32_t parent;
+    std::uint32_t first_child;
+    std::uint32_t next_sibling;
+    std::atomic<std::uint64_t> calls;
+    std::atomic<std::int64_t> total;
+};
+
+/// Single execution of a zone for the trace output
+struct ProfileEvent {
+    const ProfileZone* zone;
+    std::int64_t start;
+    std::int64_t duration;
+};
+
+/// Recorded data of a single thread
+struct ThreadProfile {
+    static constexpr std::uint32_t no_node = 0xffffffff;
+
+    ChunkedLog<ProfileNode, 256, 256> nodes;
+    ChunkedLog<ProfileEvent, 4096, 256> events;
+    std::uint32_t current;
+    std::uint32_t thread_index;
+    ThreadProfile* next;
+
+    explicit ThreadProfile(std::uint32_t index)
+        : current(0), thread_index(index), next(nullptr) {
+        // Root node of the call tree
+        nodes.push([](ProfileNode& node) {
+            node.zone = nullptr;
+            node.parent = no_node;
+            node.first_child = no_node;
+            node.next_sibling = no_node;
+            node.calls.store(0, std::memory_order_relaxed);
+            node.total.store(0, std::memory_order_relaxed);
+        });
+    }
+
+    /// Child of the current node for `zone`, created if necessary
+    std::uint32_t child(const ProfileZone* zone);
+};
+
+/// Lock free list of the profiles of all threads
+class ProfileRegistry {
+  private:
+    std::atomic<ThreadProfile*> _head;
+    std::atomic<std::uint32_t> _no_threads;
+
+  public:
+    ProfileRegistry() : _head(nullptr), _no_threads(0) {}
+    ~ProfileRegistry() {
+        ThreadProfile* p = _head.load();
+        while (p) {
+            ThreadProfile* next = p->next;
+            delete p;
+            p = next;
+        }
+    }
+
+    ThreadProfile* add() {
+        ThreadProfile* p = new ThreadProfile(_no_threads.fetch_add(1));
+        p->next = _head.load(std::memory_order_relaxed);
+        while (!_head.compare_exchange_weak(p->next, p,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+        }
+        return p;
+    }
+
+    /// Profiles in the order of registration
+    std::vector<ThreadProfile*> profiles() const {
+        std::vector<ThreadProfile*> result;
+        for (ThreadProfile* p = _head.load(std::memory_order_acquire); p;
+             p = p->next) {
+            result.push_back(p);
+        }
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+};
+
+/// Call tree merged over all threads
+struct MergedProfile {
+    struct Node {
+        const ProfileZone* zone;
+        std::size_t parent;
+        std::uint64_t calls;
+        std::int64_t total;
+        std::vector<std::size_t> children;
+    };
+    std::vector<Node> nodes;
+};
+}  // end namespace detail
+
+/**\ingroup profiler
+ * \brief Global switch and reports of the profiler
+ *
+ * Times are measured in nanoseconds since the first use of the profiler.
+ */
+class Profiler {
+  private:
+    static std::atomic<bool>& enabled_flag() noexcept {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+    static std::atomic<bool>& trace_flag() noexcept {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+    static StopWatch<std::nano, std::chrono::steady_clock, std::int64_t>&
+    clock() {
+        static StopWatch<std::nano, std::chrono::steady_clock, std::int64_t>
+            watch;
+        return watch;
+    }
+    static detail::MergedProfile merge();
+
+  public:
+    static detail::ProfileRegistry& registry() {
+        static detail::ProfileRegistry reg;
+        return reg;
+    }
+    /// Profile of the calling thread
+    static detail::ThreadProfile& this_thread() {
+        static thread_local detail::ThreadProfile* profile = registry().add();
+        return *profile;
+    }
+
+    /**@name Settings
+     */
+    ///@{
+    /**\brief Start recording
+     *
+     * If `trace` is true, every execution of a scope is stored for
+     * `write_chrome_trace()` in addition to the call tree statistics.
+     */
+    static void enable(bool trace = false) {
+        clock();
+        trace_flag().store(trace, std::memory_order_relaxed);
+        enabled_flag().store(true, std::memory_order_relaxed);
+    }
+    static void disable() noexcept {
+        enabled_flag().store(false, std::memory_order_relaxed);
+    }
+    static bool enabled() noexcept {
+        return enabled_flag().load(std::memory_order_relaxed);
+    }
+    static bool tracing() noexcept {
+        return trace_flag().load(std::memory_order_relaxed);
+    }
+    /**\brief Discard all recorded data
+     *
+     * Must not be called while instrumented scopes are executed.
+     */
+    static void reset();
+    ///@}
+
+    /// Nanoseconds since the first use of the profiler
+    static std::int64_t now() { return clock().split(); }
+
+    /**@name Reports
+     */
+    ///@{
+    /**\brief Calls, total and self time per zone, sorted by self time
+     *
+     * Total times of recursive zones contain the nested calls.
+     */
+    static void report_flat(std::ostream& out);
+    /// Call tree merged over all threads
+    static void report_tree(std::ostream& out);
+    /**\brief Recorded scopes in the Chrome trace event format
+     *
+     * The output can be loaded with chrome://tracing or Perfetto. Needs
+     * `enable(true)`.
+     */
+    static void write_chrome_trace(std::ostream& out);
+    ///@}
+};
+
+/**\ingroup profiler
+ * \brief Records the lifetime of the object for a zone
+ *
+ * Usually created by JS_PROFILE_SCOPE.
+ */
+class ProfileScope {
+  private:
+    detail::ThreadProfile* _profile;
+    const ProfileZone* _zone;
+    std::uint32_t _node;
+    std::uint32_t _parent;
+    std::int64_t _start;
+
+    void begin();
+    void end();
+
+  public:
+    explicit ProfileScope(const ProfileZone& zone)
+        : _profile(nullptr), _zone(&zone) {
+        if (Profiler::enabled()) begin();
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+    ~ProfileScope() {
+        if (_profile) end();
+    }
+};
+
+#define JS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define JS_PROFILE_CONCAT(a, b) JS_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef JS_NO_PROFILING
+#define JS_PROFILE_SCOPE(name)
+#else
+/**\ingroup profiler
+ * \brief Profiles the enclosing scope under the string literal `name`
+ */
+#define JS_PROFILE_SCOPE(name)                                             \
+    static const ::js::ProfileZone JS_PROFILE_CONCAT(js_profile_zone_,     \
+                                                     __LINE__){            \
+        name, __FILE__, __LINE__};                                         \
+    ::js::ProfileScope JS_PROFILE_CONCAT(js_profile_scope_, __LINE__)(     \
+        JS_PROFILE_CONCAT(js_profile_zone_, __LINE__))
+#endif
+/**\ingroup profiler
+ * \brief Profiles the enclosing function
+ */
+#define JS_PROFILE_FUNCTION() JS_PROFILE_SCOPE(__func__)
+
+/*
+ * Functions implementations
+ */
+
+namespace detail {
+inline std::uint32_t ThreadProfile::child(const ProfileZone* zone) {
+    ProfileNode& parent = nodes[current];
+    std::uint32_t c = parent.first_child;
+    while (c != no_node) {
+        if (nodes[c].zone == zone) return c;
+        c = nodes[c].next_sibling;
+    }
+    std::uint32_t index = nodes.size();
+    std::uint32_t parent_index = current;
+    bool added = nodes.push([&](ProfileNode& node) {
+        node.zone = zone;
+        node.parent = parent_index;
+        node.first_child = no_node;
+        node.next_sibling = parent.first_child;
+        node.calls.store(0, std::memory_order_relaxed);
+        node.total.store(0, std::memory_order_relaxed);
+    });
+    if (!added) return no_node;
+    parent.first_child = index;
+    return index;
+}
+
+inline void write_zone_name(std::ostream& out, const ProfileZone* zone) {
+    out << zone->name << " (" << zone->file << ':' << zone->line << ')';
+}
+
+inline void write_json_string(std::ostream& out, const char* str) {
+    out << '"';
+    for (; *str; ++str) {
+        char c = *str;
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u00" << "0123456789abcdef"[(c >> 4) & 0xf]
+                << "0123456789abcdef"[c & 0xf];
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+inline double to_ms(std::int64_t ns) { return ns * 1e-6; }
+}  // end namespace detail
+
+inline void ProfileScope::begin() {
+    detail::ThreadProfile& profile = Profiler::this_thread();
+    std::uint32_t node = profile.child(_zone);
+    if (node == detail::ThreadProfile::no_node) return;
+    _profile = &profile;
+    _node = node;
+    _parent = profile.current;
+    profile.current = node;
+    _start = Profiler::now();
+}
+
+inline void ProfileScope::end() {
+    std::int64_t duration = Profiler::now() - _start;
+    detail::ProfileNode& node = _profile->nodes[_node];
+    // Only this thread writes, so load and store suffice
+    node.calls.store(node.calls.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    node.total.store(node.total.load(std::memory_order_relaxed) + duration,
+                     std::memory_order_relaxed);
+    _profile->current = _parent;
+    if (Profiler::tracing()) {
+        const ProfileZone* zone = _zone;
+        std::int64_t start = _start;
+        _profile->events.push([&](detail::ProfileEvent& event) {
+            event.zone = zone;
+            event.start = start;
+            event.duration = duration;
+        });
+    }
+}
+
+inline void Profiler::reset() {
+    for (detail::ThreadProfile* p : registry().profiles()) {
+        for (std::uint32_t i = 0, n = p->nodes.size(); i != n; ++i) {
+            p->nodes[i].calls.store(0, std::memory_order_relaxed);
+            p->nodes[i].total.store(0, std::memory_order_relaxed);
+        }
+        p->events.clear();
+    }
+}
+
+inline detail::MergedProfile Profiler::merge() {
+    detail::MergedProfile merged;
+    merged.nodes.push_back({nullptr, 0, 0, 0, {}});
+    std::map<std::pair<std::size_t, const ProfileZone*>, std::size_t> lookup;
+    for (detail::ThreadProfile* p : registry().profiles()) {
+        std::uint32_t no_nodes = p->nodes.size();
+        // Parents are created before their children
+        std::vector<std::size_t> merged_index(no_nodes, 0);
+        for (std::uint32_t i = 1; i < no_nodes; ++i) {
+            const detail::ProfileNode& node = p->nodes[i];
+            std::size_t parent = merged_index[node.parent];
+            auto key = std::make_pair(parent, node.zone);
+            auto it = lookup.find(key);
+            if (it == lookup.end()) {
+                it = lookup.emplace(key, merged.nodes.size()).first;
+                merged.nodes[parent].children.push_back(merged.nodes.size());
+                merged.nodes.push_back({node.zone, parent, 0, 0, {}});
+            }
+            merged_index[i] = it->second;
+            auto& m = merged.nodes[it->second];
+            m.calls += node.calls.load(std::memory_order_relaxed);
+            m.total += node.total.load(std::memory_order_relaxed);
+        }
+    }
+    return merged;
+}
+
+inline void Profiler::report_flat(std::ostream& out) {
+    struct Entry {
+        std::uint64_t calls;
+        std::int64_t total;
+        std::int64_t self;
+    };
+    detail::MergedProfile merged = merge();
+    std::map<const ProfileZone*, Entry> zones;
+    for (const auto& node : merged.nodes) {
+        if (!node.zone || node.calls == 0) continue;
+        Entry& entry = zones[node.zone];
+        std::int64_t children = 0;
+        for (std::size_t c : node.children) {
+            children += merged.nodes[c].total;
+        }
+        entry.calls += node.calls;
+        entry.total += node.total;
+        entry.self += node.total - children;
+    }
+    std::vector<std::pair<const ProfileZone*, Entry>> sorted(zones.begin(),
+                                                             zones.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.self > b.second.self;
+    });
+
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::setw(12) << "calls" << std::setw(14) << "total [ms]"
+        << std::setw(14) << "self [ms]"
+        << "  zone\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& z : sorted) {
+        out << std::setw(12) << z.second.calls << std::setw(14)
+            << detail::to_ms(z.second.total) << std::setw(14)
+            << detail::to_ms(z.second.self) << "  ";
+        detail::write_zone_name(out, z.first);
+        out << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+inline void Profiler::report_tree(std::ostream& out) {
+    detail::MergedProfile merged = merge();
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::setw(14) << "total [ms]" << std::setw(12) << "calls"
+        << "  zone\n";
+    out << std::fixed << std::setprecision(3);
+    // Depth first, children ordered by total time
+    std::vector<std::pair<std::size_t, std::size_t>> stack{{0, 0}};
+    while (!stack.empty()) {
+        std::size_t index = stack.back().first;
+        std::size_t depth = stack.back().second;
+        stack.pop_back();
+        const auto& node = merged.nodes[index];
+        if (node.zone) {
+            if (node.calls == 0) continue;
+            out << std::setw(14) << detail::to_ms(node.total) << std::setw(12)
+                << node.calls << "  " << std::string(2 * (depth - 1), ' ');
+            detail::write_zone_name(out, node.zone);
+            out << '\n';
+        }
+        std::vector<std::size_t> children = node.children;
+        std::sort(children.begin(), children.end(),
+                  [&](std::size_t a, std::size_t b) {
+                      return merged.nodes[a].total < merged.nodes[b].total;
+                  });
+        for (std::size_t c : children) {
+            stack.emplace_back(c, depth + 1);
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+inline void Profiler::write_chrome_trace(std::ostream& out) {
+    auto flags = out.flags();
+    auto precision = out.precision();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (detail::ThreadProfile* p : registry().profiles()) {
+        for (std::uint32_t i = 0, n = p->events.size(); i != n; ++i) {
+            const detail::ProfileEvent& event = p->events[i];
+            out << (first ? "\n" : ",\n") << "{\"name\":";
+            detail::write_json_string(out, event.zone->name);
+            out << ",\"cat\":\"js\",\"ph\":\"X\",\"ts\":" << event.start * 1e-3
+                << ",\"dur\":" << event.duration * 1e-3
+                << ",\"pid\":0,\"tid\":" << p->thread_index << '}';
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    out.flags(flags);
+    out.precision(precision);
+}
+
+}  // end namespace js
@@ -19,7 +19,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #pragma once
 
 #include "random/random_device.hpp"
+#include "random/discrete_alias.hpp"
 #include "random/distribution.hpp"
+#include "random/philox.hpp"
 
 /**@defgroup random Random numbers
  */
@@ -0,0 +1,182 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace js {
+namespace detail {
+
+/// Uniform random number in [0, 1)
+template <class RealType, class UniformRandomBitGenerator>
+RealType uniform_canonical(UniformRandomBitGenerator& g) {
+    return std::generate_canonical<RealType,
+                                   std::numeric_limits<RealType>::digits>(g);
+}
+
+/**@brief Binomial random numbers by inversion
+ *
+ * Sequential search of the cumulative distribution, starting at 0. The
+ * expected number of iterations is `n * p`, so this is used for small
+ * means only. Requires `p <= 0.5`.
+ */
+template <class IntType, class UniformRandomBitGenerator>
+IntType binomial_inversion(UniformRandomBitGenerator& g, IntType n, double p) {
+    double q = 1 - p;
+    double qn = std::exp(n * std::log(q));
+    double np = n * p;
+    double bound = std::min(static_cast<double>(n),
+                            np + 10 * std::sqrt(np * q + 1));
+    IntType x = 0;
+    double px = qn;
+    double u = uniform_canonical<double>(g);
+    while (u > px) {
+        ++x;
+        if (x > bound) {
+            x = 0;
+            px = qn;
+            u = uniform_canonical<double>(g);
+        } else {
+            u -= px;
+            px = ((n - x + 1) * p * px) / (x * q);
+        }
+    }
+    return x;
+}
+
+/**@brief Binomial random numbers with the BTPE algorithm
+ *
+ * Triangle, parallelogram, exponential acceptance/rejection algorithm
+ * of Kachitvichyanukul and Schmeiser, "Binomial random variate
+ * generation", Commun. ACM 31 (1988). The setup is constant and the
+ * expected number of uniforms per variate is small for large `n * p`.
+ * Requires `p <= 0.5`.
+ */
+template <class IntType, class UniformRandomBitGenerator>
+IntType binomial_btpe(UniformRandomBitGenerator& g, IntType n, double p) {
+    const double r = p;
+    const double q = 1 - r;
+    const double fm = n * r + r;
+    const double m = std::floor(fm);
+    const double p1 = std::floor(2.195 * std::sqrt(n * r * q) - 4.6 * q) + 0.5;
+    const double xm = m + 0.5;
+    const double xl = xm - p1;
+    const double xr = xm + p1;
+    const double c = 0.134 + 20.5 / (15.3 + m);
+    double a = (fm - xl) / (fm - xl * r);
+    const double laml = a * (1 + a / 2);
+    a = (xr - fm) / (xr * q);
+    const double lamr = a * (1 + a / 2);
+    const double p2 = p1 * (1 + 2 * c);
+    const double p3 = p2 + c / laml;
+    const double p4 = p3 + c / lamr;
+    const double nrq = n * r * q;
+
+    while (true) {
+        double u = uniform_canonical<double>(g) * p4;
+        double v = uniform_canonical<double>(g);
+        double y;
+        if (u <= p1) {
+            // Triangular region, immediate acceptance
+            return static_cast<IntType>(std::floor(xm - p1 * v + u));
+        } else if (u <= p2) {
+            // Parallelogram region
+            double x = xl + (u - p1) / c;
+            v = v * c + 1 - std::abs(m - x + 0.5) / p1;
+            if (v > 1) continue;
+            y = std::floor(x);
+        } else if (u <= p3) {
+            // Left exponential tail
+            y = std::floor(xl + std::log(v) / laml);
+            if (y < 0 || v == 0) continue;
+            v = v * (u - p2) * laml;
+        } else {
+            // Right exponential tail
+            y = std::floor(xr - std::log(v) / lamr);
+            if (y > n || v == 0) continue;
+            v = v * (u - p3) * lamr;
+        }
+
+        double k = std::abs(y - m);
+        if (k <= 20 || k >= nrq / 2 - 1) {
+            // Explicit evaluation of f(y) / f(m)
+            double s = r / q;
+            double aa = s * (n + 1);
+            double f = 1;
+            if (m < y) {
+                for (double i = m + 1; i <= y; ++i) f *= (aa / i - s);
+            } else if (m > y) {
+                for (double i = y + 1; i <= m; ++i) f /= (aa / i - s);
+            }
+            if (v <= f) return static_cast<IntType>(y);
+            continue;
+        }
+
+        // Squeeze using upper and lower bounds of log(f(y))
+        double rho =
+            (k / nrq) * ((k * (k / 3 + 0.625) + 0.1666666666666667) / nrq + 0.5);
+        double t = -k * k / (2 * nrq);
+        double log_v = std::log(v);
+        if (log_v < t - rho) return static_cast<IntType>(y);
+        if (log_v > t + rho) continue;
+
+        // Final acceptance test with Stirling's formula
+        double x1 = y + 1;
+        double f1 = m + 1;
+        double z = n + 1 - m;
+        double w = n - y + 1;
+        double x2 = x1 * x1;
+        double f2 = f1 * f1;
+        double z2 = z * z;
+        double w2 = w * w;
+        double bound =
+            xm * std::log(f1 / x1) + (n - m + 0.5) * std::log(z / w) +
+            (y - m) * std::log(w * r / (x1 * q)) +
+            (13680. - (462. - (132. - (99. - 140. / f2) / f2) / f2) / f2) /
+                f1 / 166320. +
+            (13680. - (462. - (132. - (99. - 140. / z2) / z2) / z2) / z2) / z /
+                166320. +
+            (13680. - (462. - (132. - (99. - 140. / x2) / x2) / x2) / x2) /
+                x1 / 166320. +
+            (13680. - (462. - (132. - (99. - 140. / w2) / w2) / w2) / w2) / w /
+                166320.;
+        if (log_v <= bound) return static_cast<IntType>(y);
+    }
+}
+
+/**@brief Binomial random number
+ *
+ * Uses inversion for `n * min(p, 1 - p) < 30` and BTPE otherwise.
+ */
+template <class IntType, class UniformRandomBitGenerator>
+IntType binomial(UniformRandomBitGenerator& g, IntType n, double p) {
+    if (n <= 0 || p <= 0) return 0;
+    if (p >= 1) return n;
+    bool flipped = p > 0.5;
+    double r = flipped ? 1 - p : p;
+    IntType x = (n * r < 30) ? binomial_inversion(g, n, r)
+                             : binomial_btpe(g, n, r);
+    return flipped ? n - x : x;
+}
+
+}  // end namespace detail
+}  // end namespace js
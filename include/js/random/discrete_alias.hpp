@@ -0,0 +1,309 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "binomial.hpp"
+#include <cstddef>
+#include <initializer_list>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <vector>
+
+namespace js {
+
+template <class, class>
+class DiscreteAliasDistribution;
+
+namespace detail {
+
+/// Entry of an alias table, kept together for a single cache access
+template <class IntType, class RealType>
+struct AliasEntry {
+    /// Probability to keep the drawn category
+    RealType prob;
+    /// Category taken otherwise
+    IntType alias;
+};
+
+/// True if no weight is negative and the sum is positive
+template <class RealType>
+bool valid_weights(const RealType* weights, std::size_t n) {
+    RealType sum = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        if (!(weights[i] >= 0)) return false;
+        sum += weights[i];
+    }
+    return sum > 0;
+}
+
+/**@brief Builds the alias table of the weights with Vose's method
+ *
+ * M. D. Vose, "A linear algorithm for generating random numbers with a
+ * given distribution", IEEE Trans. Softw. Eng. 17 (1991). The weights
+ * need not be normalized. Throws std::invalid_argument if a weight is
+ * negative or all weights are zero.
+ */
+template <class IntType, class RealType>
+void alias_table(const RealType* weights, std::size_t n,
+                 AliasEntry<IntType, RealType>* table) {
+    if (!valid_weights(weights, n)) {
+        throw std::invalid_argument(
+            "Alias table: weights must be non negative with positive sum");
+    }
+    RealType sum = std::accumulate(weights, weights + n, RealType(0));
+    std::vector<RealType> scaled(n);
+    std::vector<std::size_t> low, high;
+    for (std::size_t i = 0; i != n; ++i) {
+        scaled[i] = weights[i] * static_cast<RealType>(n) / sum;
+        (scaled[i] < 1 ? low : high).push_back(i);
+    }
+    while (!low.empty() && !high.empty()) {
+        std::size_t s = low.back();
+        std::size_t l = high.back();
+        low.pop_back();
+        table[s].prob = scaled[s];
+        table[s].alias = static_cast<IntType>(l);
+        scaled[l] = (scaled[l] + scaled[s]) - 1;
+        if (scaled[l] < 1) {
+            high.pop_back();
+            low.push_back(l);
+        }
+    }
+    // Left overs are 1 up to rounding errors
+    for (auto i : low) table[i] = {RealType(1), static_cast<IntType>(i)};
+    for (auto i : high) table[i] = {RealType(1), static_cast<IntType>(i)};
+}
+
+/// Draws a category from an alias table with `n` entries
+template <class IntType, class RealType, class UniformRandomBitGenerator>
+IntType alias_sample(UniformRandomBitGenerator& g,
+                     const AliasEntry<IntType, RealType>* table,
+                     std::size_t n) {
+    RealType u = uniform_canonical<RealType>(g) * static_cast<RealType>(n);
+    std::size_t i = static_cast<std::size_t>(u);
+    // Guards against u rounding up to n
+    if (i >= n) i = n - 1;
+    const auto& entry = table[i];
+    return (u - static_cast<RealType>(i) < entry.prob)
+               ? static_cast<IntType>(i)
+               : entry.alias;
+}
+
+/**@brief Parameter set for the alias distribution
+ *
+ * Stores the normalized probabilities and the alias table, which is
+ * built once when the parameters are set.
+ */
+template <class IntType, class RealType>
+class ParamDiscreteAlias {
+  private:
+    std::vector<RealType> _prob;
+    std::vector<AliasEntry<IntType, RealType>> _table;
+    friend DiscreteAliasDistribution<IntType, RealType>;
+
+    void init() {
+        if (_prob.empty()) _prob.push_back(1);
+        _table.resize(_prob.size());
+        alias_table(_prob.data(), _prob.size(), _table.data());
+        RealType sum = std::accumulate(_prob.begin(), _prob.end(), RealType(0));
+        for (auto& p : _prob) p /= sum;
+    }
+
+  public:
+    using distribution_type = DiscreteAliasDistribution<IntType, RealType>;
+
+    /**@name Constructor
+     *@{
+     */
+    /// Single category with probability one
+    ParamDiscreteAlias() { init(); }
+    /// Weights from the range [first, last)
+    template <class InputIt>
+    ParamDiscreteAlias(InputIt first, InputIt last) : _prob(first, last) {
+        init();
+    }
+    ParamDiscreteAlias(std::initializer_list<RealType> weights)
+        : ParamDiscreteAlias(weights.begin(), weights.end()) {}
+    /**@}
+     */
+
+    /// Normalized probabilities
+    std::vector<RealType> probabilities() const { return _prob; }
+
+    friend bool operator==(const ParamDiscreteAlias& p1,
+                           const ParamDiscreteAlias& p2) {
+        return p1._prob == p2._prob;
+    }
+    friend bool operator!=(const ParamDiscreteAlias& p1,
+                           const ParamDiscreteAlias& p2) {
+        return !(p1 == p2);
+    }
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os, const ParamDiscreteAlias& p) {
+        os << p._prob.size();
+        for (const auto& x : p._prob) {
+            os << " " << x;
+        }
+        return os;
+    }
+    template <class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>& operator>>(
+        std::basic_istream<CharT, Traits>& is, ParamDiscreteAlias& p) {
+        std::size_t n;
+        is >> n;
+        std::vector<RealType> prob(n);
+        for (auto& x : prob) {
+            is >> std::ws >> x;
+        }
+        if (is) {
+            p._prob = std::move(prob);
+            p.init();
+        }
+        return is;
+    }
+};
+
+}  // end namespace detail
+
+/**@ingroup random
+ * @brief Discrete distribution sampled with an alias table
+ *
+ * Same distribution as std::discrete_distribution, but every sample
+ * takes constant time: one uniform number selects a category and its
+ * alias. Building the table takes O(n) time when the parameters are
+ * set. `generate` draws many samples into an output range.
+ *
+ * Fulfills the random number distribution concept,
+ * http://en.cppreference.com/w/cpp/concept/RandomNumberDistribution
+ */
+template <class IntType = int, class RealType = double>
+class DiscreteAliasDistribution {
+  public:
+    using param_type = detail::ParamDiscreteAlias<IntType, RealType>;
+    using result_type = IntType;
+
+  private:
+    param_type _p;
+
+  public:
+    /**@name Constructor
+     *@{
+     */
+    /// Single category with probability one
+    DiscreteAliasDistribution() = default;
+    /// Weights from the range [first, last)
+    template <class InputIt>
+    DiscreteAliasDistribution(InputIt first, InputIt last) : _p(first, last) {}
+    DiscreteAliasDistribution(std::initializer_list<RealType> weights)
+        : _p(weights) {}
+    explicit DiscreteAliasDistribution(const param_type& p) : _p(p) {}
+    /**@}
+     */
+
+    /**@name Parameter
+     *@{
+     */
+    param_type param() const { return _p; }
+    void param(const param_type& p) { _p = p; }
+    void reset() {}
+    std::vector<RealType> probabilities() const { return _p._prob; }
+    /**@}*/
+
+    ///@name Get random numbers
+    /**@{*/
+    template <class UniformRandomBitGenerator>
+    result_type operator()(UniformRandomBitGenerator& g,
+                           const param_type& p) const {
+        return detail::alias_sample(g, p._table.data(), p._table.size());
+    }
+    template <class UniformRandomBitGenerator>
+    result_type operator()(UniformRandomBitGenerator& g) const {
+        return operator()(g, _p);
+    }
+    /**@brief Draw `count` samples into `out_first`
+     *
+     * Returns the iterator past the last sample.
+     */
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count, const param_type& p) const {
+        const auto* table = p._table.data();
+        std::size_t n = p._table.size();
+        for (std::size_t k = 0; k != count; ++k, ++out_first) {
+            *out_first = detail::alias_sample(g, table, n);
+        }
+        return out_first;
+    }
+    /// Same as above with the parameters of the class
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count) const {
+        return generate(g, out_first, count, _p);
+    }
+    /**@}*/
+
+    /**@name Characteristics
+     * @{
+     */
+    result_type min() const { return 0; }
+    result_type max() const {
+        return static_cast<result_type>(_p._prob.size() - 1);
+    }
+    /**@}
+     */
+
+    /**@name Comparators
+     * @{
+     */
+    friend bool operator==(const DiscreteAliasDistribution& dist1,
+                           const DiscreteAliasDistribution& dist2) {
+        return dist1._p == dist2._p;
+    }
+    friend bool operator!=(const DiscreteAliasDistribution& dist1,
+                           const DiscreteAliasDistribution& dist2) {
+        return dist1._p != dist2._p;
+    }
+    /**@}
+     */
+
+    /**@name Streamoperator
+     * @{
+     */
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os,
+        const DiscreteAliasDistribution& dist) {
+        os << dist._p;
+        return os;
+    }
+    template <class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>& operator>>(
+        std::basic_istream<CharT, Traits>& is,
+        DiscreteAliasDistribution& dist) {
+        is >> dist._p;
+        return is;
+    }
+    /**@}
+     */
+};
+
+}  // end namespace js
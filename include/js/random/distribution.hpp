@@ -18,9 +18,20 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "binomial.hpp"
+#include "discrete_alias.hpp"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstddef>
+#include <initializer_list>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <random>
+#include <utility>
+#include <vector>
 
 namespace js {
 
@@ -29,18 +40,103 @@ class MultinomialDistribution;
 
 namespace detail {
 
+/**@brief Conditional probabilities of the multinomial distribution
+ *
+ * Category `i` is drawn from a binomial distribution with the remaining
+ * trials and `prob[i] / (1 - prob[0] - ... - prob[i-1])`. The values
+ * are clamped to [0, 1].
+ */
+template <class RealType>
+void conditional_probabilities(const RealType* prob, RealType* cond,
+                               std::size_t n) {
+    RealType prob_left = 1;
+    for (std::size_t i = 0; i != n; ++i) {
+        RealType c = (prob_left > 0) ? prob[i] / prob_left : RealType(1);
+        cond[i] = std::min(RealType(1), std::max(RealType(0), c));
+        prob_left -= prob[i];
+    }
+}
+
+/**@brief Draw one multinomial sample by chained binomials
+ *
+ * Stops as soon as all trials are used up and writes zeros for the
+ * remaining categories.
+ */
+template <class IntType, class RealType, class UniformRandomBitGenerator,
+          class OutputIt>
+void multinomial_conditional(UniformRandomBitGenerator& g, IntType trials,
+                             const RealType* cond, std::size_t n,
+                             OutputIt out) {
+    std::size_t i = 0;
+    for (; i != n && trials > 0; ++i, ++out) {
+        IntType x = binomial(g, trials, static_cast<double>(cond[i]));
+        *out = x;
+        trials -= x;
+    }
+    for (; i != n; ++i, ++out) {
+        *out = 0;
+    }
+}
+
+/**@brief Draw one multinomial sample by counting categorical draws
+ *
+ * Every trial draws one category from the alias table, which is cheaper
+ * than the chained binomials if the number of trials is small.
+ */
+template <class IntType, class RealType, std::size_t N,
+          class UniformRandomBitGenerator, class OutputIt>
+void multinomial_alias(UniformRandomBitGenerator& g, IntType trials,
+                       const std::array<AliasEntry<std::size_t, RealType>, N>&
+                           table,
+                       OutputIt out) {
+    std::array<IntType, N> counts{};
+    for (IntType t = 0; t < trials; ++t) {
+        ++counts[alias_sample(g, table.data(), N)];
+    }
+    std::copy(counts.begin(), counts.end(), out);
+}
+
+/// Counting is used up to `multinomial_alias_factor * N` trials
+constexpr int multinomial_alias_factor = 2;
+
 /**@brief Parameter set for multlinomial distribution
  *
  * This class provides the parameter set for the multinomial
- * distribution.
+ * distribution. The conditional probabilities used for sampling are
+ * calculated once, when the parameters are set.
  */
 template <std::size_t N, class IntType, class RealType>
 class ParamMultinomial {
   private:
     IntType _trials;
     std::array<RealType, N> _prob;
+    std::array<RealType, N> _cond_prob;
+    std::array<AliasEntry<std::size_t, RealType>, N> _alias;
+    bool _use_alias;
     friend MultinomialDistribution<N, IntType, RealType>;
 
+    void init() {
+        conditional_probabilities(_prob.data(), _cond_prob.data(), N);
+        // Counting needs normalized probabilities to give the same result
+        RealType sum = 0;
+        for (const auto& p : _prob) sum += p;
+        _use_alias =
+            _trials <= multinomial_alias_factor * static_cast<IntType>(N) &&
+            valid_weights(_prob.data(), N) &&
+            std::abs(sum - 1) <=
+                100 * N * std::numeric_limits<RealType>::epsilon();
+        if (_use_alias) alias_table(_prob.data(), N, _alias.data());
+    }
+
+    template <class UniformRandomBitGenerator, class OutputIt>
+    void sample(UniformRandomBitGenerator& g, OutputIt out) const {
+        if (_use_alias) {
+            multinomial_alias(g, _trials, _alias, out);
+        } else {
+            multinomial_conditional(g, _trials, _cond_prob.data(), N, out);
+        }
+    }
+
   public:
     using distribution_type = MultinomialDistribution<N, IntType, RealType>;
 
@@ -54,23 +150,18 @@ class ParamMultinomial {
      * @param prob Array with probabilities
      */
     ParamMultinomial(IntType trials, const std::array<RealType, N>& prob)
-        : _trials(trials), _prob(prob) {}
+        : _trials(trials), _prob(prob) {
+        init();
+    }
     /// Copy constructor
-    template <class IntType2, class RealType2>
-    ParamMultinomial(const ParamMultinomial<N, IntType2, RealType2>& p)
-        : _trials(p._trials), _prob(p._prob) {}
+    ParamMultinomial(const ParamMultinomial& p) = default;
     /**@}
      */
     /**@name Operators
      *@{
      */
     /// Assignment operator
-    ParamMultinomial<N, IntType, RealType>& operator=(
-        ParamMultinomial<N, IntType, RealType>& p) {
-        _trials = p._trials;
-        _prob = p._prob;
-        return *this;
-    }
+    ParamMultinomial& operator=(const ParamMultinomial& p) = default;
     friend bool operator==(const ParamMultinomial& p1,
                            const ParamMultinomial& p2) {
         return p1._trials == p2._trials && p1._prob == p2._prob;
@@ -95,6 +186,7 @@ class ParamMultinomial {
         for (std::size_t i = 0; i != N; ++i) {
             is >> std::ws >> p._prob[i];
         }
+        p.init();
         return is;
     }
     /**@}
@@ -108,6 +200,9 @@ class ParamMultinomial {
  *
  * Implementation follows "A review on MC simulation methods [...]" Mode et. al.
  * 2008, Math. Biosci 211 http://dx.doi.org/10.1016/j.mbs.2007.05.015
+ * For at most `2 * N` trials the categories of the single trials are
+ * drawn from an alias table and counted instead, see
+ * DiscreteAliasDistribution.
  *
  * This is supposed to fulfill the random number distribution concept.
  * http://en.cppreference.com/w/cpp/concept/RandomNumberDistribution
@@ -125,6 +220,12 @@ class MultinomialDistribution {
   private:
     param_type _p;
 
+    static std::array<RealType, N> uniform_prob() {
+        std::array<RealType, N> prob;
+        prob.fill(1 / static_cast<RealType>(N));
+        return prob;
+    }
+
   public:
     /**@name Constructor
      *@{
@@ -132,11 +233,8 @@ class MultinomialDistribution {
     /// Construct via trials and probability array
     MultinomialDistribution(IntType trials, const std::array<RealType, N>& prob)
         : _p(trials, prob) {}
-    /// Default constructor
-    MultinomialDistribution()
-        : MultinomialDistribution(
-              1, std::array<RealType, N>{}.fill(1 / static_cast<RealType>(N))) {
-    }
+    /// Default constructor, one trial and equal probabilities
+    MultinomialDistribution() : MultinomialDistribution(1, uniform_prob()) {}
     MultinomialDistribution(const param_type& p) : _p(p) {}
     /// Copy constructor
     MultinomialDistribution(const MultinomialDistribution& dist2)
@@ -171,15 +269,7 @@ class MultinomialDistribution {
     result_type operator()(UniformRandomBitGenerator& g,
                            const param_type& p) const {
         result_type output;
-        IntType trials_next = p._trials;
-        RealType prob_used = 1;
-        for (std::size_t i = 0; i != N; ++i) {
-            std::binomial_distribution<IntType> binom_dist(
-                trials_next, p._prob[i] / prob_used);
-            output[i] = binom_dist(g);
-            prob_used -= p._prob[i];
-            trials_next -= output[i];
-        }
+        p.sample(g, output.begin());
         return output;
     }
     /**@brief Get random numbers from generator
@@ -192,6 +282,31 @@ class MultinomialDistribution {
     result_type operator()(UniformRandomBitGenerator& g) {
         return operator()(g, _p);
     }
+    /**@brief Draw `count` samples in one go
+     *
+     * @param g Random number generator
+     * @param out_first Output iterator to `result_type`, e.g. pointer into
+     * a `std::vector<result_type>`
+     * @param count Number of samples
+     * @param p Parameters
+     *
+     * The samples are written element wise into the output, no temporary
+     * arrays are created. Returns the iterator past the last sample.
+     */
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count, const param_type& p) const {
+        for (std::size_t k = 0; k != count; ++k, ++out_first) {
+            p.sample(g, std::begin(*out_first));
+        }
+        return out_first;
+    }
+    /// Same as above with the parameters of the class
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count) const {
+        return generate(g, out_first, count, _p);
+    }
     /**@}*/
 
     /**@name Characteristics
@@ -266,4 +381,371 @@ class MultinomialDistribution {
      */
 };
 
+
+template <class, class>
+class DynamicMultinomialDistribution;
+
+namespace detail {
+
+/**@brief Parameter set for the runtime sized multinomial distribution
+ *
+ * All tables are computed once when the parameters are set:
+ * - the categories sorted by descending probability,
+ * - the remaining probability mass `prob[i] + ... + prob[N-1]` of the
+ *   sorted categories, summed from the back so the small tail keeps its
+ *   precision,
+ * - the conditional probabilities derived from it,
+ * - an alias table if the number of trials is at most twice the
+ *   number of categories the chain is expected to visit.
+ *
+ * The tail sums are not normalized, but the conditional probabilities
+ * and the alias table only use ratios of weights and the expected
+ * number of visited categories compares the tail to the total mass
+ * `_tail[0]`, so the probabilities are relative weights and need not
+ * sum to one.
+ */
+template <class IntType, class RealType>
+class ParamDynamicMultinomial {
+  private:
+    IntType _trials;
+    std::vector<RealType> _prob;
+    /// Categories by descending probability
+    std::vector<std::size_t> _order;
+    /// Remaining probability mass in sorted order
+    std::vector<RealType> _tail;
+    /// Conditional probabilities in sorted order
+    std::vector<RealType> _cond_prob;
+    std::vector<AliasEntry<std::size_t, RealType>> _alias;
+    bool _use_alias;
+    friend DynamicMultinomialDistribution<IntType, RealType>;
+
+    void init() {
+        std::size_t n = _prob.size();
+        _order.resize(n);
+        std::iota(_order.begin(), _order.end(), std::size_t(0));
+        std::stable_sort(
+            _order.begin(), _order.end(),
+            [this](std::size_t i, std::size_t j) {
+                return _prob[i] > _prob[j];
+            });
+        _tail.resize(n + 1);
+        _tail[n] = 0;
+        for (std::size_t i = n; i-- != 0;) {
+            _tail[i] = _tail[i + 1] + _prob[_order[i]];
+        }
+        _cond_prob.resize(n);
+        for (std::size_t i = 0; i != n; ++i) {
+            RealType c = (_tail[i] > 0) ? _prob[_order[i]] / _tail[i]
+                                        : RealType(1);
+            _cond_prob[i] = std::min(RealType(1), std::max(RealType(0), c));
+        }
+        // The chain stops about where less than one trial is expected
+        std::size_t visited = n;
+        for (std::size_t i = 0; i != n; ++i) {
+            if (_tail[i] * _trials < _tail[0]) {
+                visited = i + 1;
+                break;
+            }
+        }
+        // Both paths normalize, so unlike ParamMultinomial the sum of the
+        // probabilities does not matter here
+        _use_alias =
+            n > 0 &&
+            _trials <=
+                multinomial_alias_factor * static_cast<IntType>(visited) &&
+            valid_weights(_prob.data(), n);
+        _alias.resize(_use_alias ? n : 0);
+        if (_use_alias) alias_table(_prob.data(), n, _alias.data());
+    }
+
+  public:
+    using distribution_type = DynamicMultinomialDistribution<IntType, RealType>;
+
+    /**@name Constructor
+     *@{
+     */
+    ParamDynamicMultinomial() = delete;
+    /**@brief Create parameters
+     *
+     * @param trials Number of trials
+     * @param first, last Range of probabilities
+     */
+    template <class InputIt>
+    ParamDynamicMultinomial(IntType trials, InputIt first, InputIt last)
+        : _trials(trials), _prob(first, last) {
+        init();
+    }
+    ParamDynamicMultinomial(IntType trials, std::vector<RealType> prob)
+        : _trials(trials), _prob(std::move(prob)) {
+        init();
+    }
+    ParamDynamicMultinomial(IntType trials,
+                            std::initializer_list<RealType> prob)
+        : ParamDynamicMultinomial(trials, prob.begin(), prob.end()) {}
+    /**@}
+     */
+
+    IntType trials() const noexcept { return _trials; }
+    const std::vector<RealType>& probabilities() const noexcept {
+        return _prob;
+    }
+    /// Number of categories
+    std::size_t size() const noexcept { return _prob.size(); }
+
+    /**@name Operators
+     *@{
+     */
+    friend bool operator==(const ParamDynamicMultinomial& p1,
+                           const ParamDynamicMultinomial& p2) {
+        return p1._trials == p2._trials && p1._prob == p2._prob;
+    }
+    friend bool operator!=(const ParamDynamicMultinomial& p1,
+                           const ParamDynamicMultinomial& p2) {
+        return !(p1 == p2);
+    }
+    /// Writes trials, number of categories and probabilities
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os,
+        const ParamDynamicMultinomial& p) {
+        os << p._trials << " " << p._prob.size();
+        for (const auto& x : p._prob) {
+            os << " " << x;
+        }
+        return os;
+    }
+    template <class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>& operator>>(
+        std::basic_istream<CharT, Traits>& is, ParamDynamicMultinomial& p) {
+        IntType trials;
+        std::size_t n;
+        is >> trials >> n;
+        std::vector<RealType> prob(n);
+        for (auto& x : prob) {
+            is >> std::ws >> x;
+        }
+        if (is) {
+            p._trials = trials;
+            p._prob = std::move(prob);
+            p.init();
+        }
+        return is;
+    }
+    /**@}
+     */
+};
+
+}  // end namespace detail
+
+/**@ingroup random
+ * @brief Multinomial distribution with the number of categories set at
+ * runtime
+ *
+ * Multinomial distribution like MultinomialDistribution, with the
+ * probabilities stored in a contiguous buffer. Unlike there, the
+ * probabilities are relative weights and are divided by their sum, so
+ * both classes agree only for probabilities summing to one. Negative
+ * weights and a zero sum are not allowed. The binomial chain visits the
+ * categories by descending probability and stops as soon as all trials
+ * are used up, so categories with small probabilities usually cost
+ * nothing. If the chain would visit more than half as many categories
+ * as there are trials, categorical draws from an alias table are
+ * counted instead.
+ *
+ * `operator()` returns all counts. `sparse()` writes only the non zero
+ * counts as pairs of category and count, which for many categories and
+ * few trials saves the O(N) output.
+ */
+template <class IntType = int, class RealType = double>
+class DynamicMultinomialDistribution {
+  public:
+    using param_type = detail::ParamDynamicMultinomial<IntType, RealType>;
+    using result_type = std::vector<IntType>;
+    /// Element of the sparse output
+    using sparse_type = std::pair<std::size_t, IntType>;
+
+  private:
+    param_type _p;
+
+    /// Most alias draws collected on the stack by `sample()`
+    static constexpr std::size_t sparse_draws = 64;
+
+    /**
+     * Calls `f(category, count)` for categories with non zero count. The
+     * binomial chain reports the categories by descending probability.
+     * Up to `sparse_draws` trials of the alias path are sorted in a
+     * stack buffer and reported by ascending category, more trials use
+     * the chain.
+     */
+    template <class UniformRandomBitGenerator, class Function>
+    static void sample(UniformRandomBitGenerator& g, const param_type& p,
+                       Function f) {
+        IntType trials = p._trials;
+        std::size_t n = p._prob.size();
+        if (p._use_alias && trials >= 0 &&
+            trials <= static_cast<IntType>(sparse_draws)) {
+            std::array<std::size_t, sparse_draws> draws;
+            auto end = draws.begin() + trials;
+            for (auto it = draws.begin(); it != end; ++it) {
+                *it = detail::alias_sample(g, p._alias.data(), n);
+            }
+            std::sort(draws.begin(), end);
+            for (auto it = draws.begin(); it != end;) {
+                auto next = std::upper_bound(it, end, *it);
+                f(*it, static_cast<IntType>(next - it));
+                it = next;
+            }
+            return;
+        }
+        for (std::size_t i = 0; i != n && trials > 0; ++i) {
+            IntType x = detail::binomial(
+                g, trials, static_cast<double>(p._cond_prob[i]));
+            if (x > 0) f(p._order[i], x);
+            trials -= x;
+        }
+    }
+
+    /// Adds the counts to the zero initialized `row`
+    template <class UniformRandomBitGenerator, class RandomIt>
+    static void sample_dense(UniformRandomBitGenerator& g,
+                             const param_type& p, RandomIt row) {
+        if (p._use_alias) {
+            for (IntType t = 0; t < p._trials; ++t) {
+                ++row[detail::alias_sample(g, p._alias.data(), p.size())];
+            }
+        } else {
+            sample(g, p, [row](std::size_t i, IntType x) { row[i] = x; });
+        }
+    }
+
+  public:
+    /**@name Constructor
+     *@{
+     */
+    /// Construct via trials and probabilities
+    template <class InputIt>
+    DynamicMultinomialDistribution(IntType trials, InputIt first,
+                                   InputIt last)
+        : _p(trials, first, last) {}
+    DynamicMultinomialDistribution(IntType trials, std::vector<RealType> prob)
+        : _p(trials, std::move(prob)) {}
+    DynamicMultinomialDistribution(IntType trials,
+                                   std::initializer_list<RealType> prob)
+        : _p(trials, prob) {}
+    explicit DynamicMultinomialDistribution(const param_type& p) : _p(p) {}
+    /**@}
+     */
+
+    /**@name Parameter
+     *@{
+     */
+    const param_type& param() const noexcept { return _p; }
+    void param(const param_type& p) { _p = p; }
+    void reset() {}
+    /// Number of categories
+    std::size_t size() const noexcept { return _p.size(); }
+    /**@}*/
+
+    ///@name Get random numbers
+    /**@{*/
+    /// Counts of all categories
+    template <class UniformRandomBitGenerator>
+    result_type operator()(UniformRandomBitGenerator& g,
+                           const param_type& p) const {
+        result_type output(p.size());
+        sample_dense(g, p, output.begin());
+        return output;
+    }
+    template <class UniformRandomBitGenerator>
+    result_type operator()(UniformRandomBitGenerator& g) const {
+        return operator()(g, _p);
+    }
+    /**@brief Draw `count` samples into existing rows
+     *
+     * Every `*out_first` must be a range of `size()` elements, e.g. a
+     * `std::vector<IntType>` of that size. No memory is allocated.
+     * Returns the iterator past the last sample.
+     */
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count, const param_type& p) const {
+        for (std::size_t k = 0; k != count; ++k, ++out_first) {
+            auto row = std::begin(*out_first);
+            std::fill_n(row, p.size(), IntType(0));
+            sample_dense(g, p, row);
+        }
+        return out_first;
+    }
+    /// Same as above with the parameters of the class
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt generate(UniformRandomBitGenerator& g, OutputIt out_first,
+                      std::size_t count) const {
+        return generate(g, out_first, count, _p);
+    }
+    /**@brief Writes the non zero counts as `sparse_type` pairs
+     *
+     * The order of the categories is unspecified. Returns the iterator
+     * past the last pair.
+     */
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt sparse(UniformRandomBitGenerator& g, OutputIt out,
+                    const param_type& p) const {
+        sample(g, p, [&out](std::size_t i, IntType x) {
+            *out = sparse_type(i, x);
+            ++out;
+        });
+        return out;
+    }
+    /// Same as above with the parameters of the class
+    template <class UniformRandomBitGenerator, class OutputIt>
+    OutputIt sparse(UniformRandomBitGenerator& g, OutputIt out) const {
+        return sparse(g, out, _p);
+    }
+    /**@}*/
+
+    /**@name Characteristics
+     * @{
+     */
+    result_type min() const { return result_type(_p.size(), min_val()); }
+    IntType min_val() const { return 0; }
+    result_type max() const { return result_type(_p.size(), max_val()); }
+    IntType max_val() const { return _p._trials; }
+    /**@}
+     */
+
+    /**@name Comparators
+     * @{
+     */
+    friend bool operator==(const DynamicMultinomialDistribution& dist1,
+                           const DynamicMultinomialDistribution& dist2) {
+        return dist1._p == dist2._p;
+    }
+    friend bool operator!=(const DynamicMultinomialDistribution& dist1,
+                           const DynamicMultinomialDistribution& dist2) {
+        return dist1._p != dist2._p;
+    }
+    /**@}
+     */
+
+    /**@name Streamoperator
+     * @{
+     */
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os,
+        const DynamicMultinomialDistribution& dist) {
+        os << dist._p;
+        return os;
+    }
+    template <class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>& operator>>(
+        std::basic_istream<CharT, Traits>& is,
+        DynamicMultinomialDistribution& dist) {
+        is >> dist._p;
+        return is;
+    }
+    /**@}
+     */
+};
+
 }  // End namespace js
@@ -0,0 +1,282 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+namespace js {
+namespace detail {
+
+/// Multipliers and Weyl constants of Philox4x32
+constexpr std::uint32_t philox_m0 = 0xD2511F53;
+constexpr std::uint32_t philox_m1 = 0xCD9E8D57;
+constexpr std::uint32_t philox_w0 = 0x9E3779B9;
+constexpr std::uint32_t philox_w1 = 0xBB67AE85;
+
+/**@brief Philox4x32-10 block for `Lanes` counters at once
+ *
+ * The counters are stored as structure of arrays, `ctr[i][l]` is word `i`
+ * of lane `l`. All lanes run the same instructions, and the 32x32 bit
+ * multiplications are written as 64 bit products, so the compiler turns
+ * the loops over the lanes into vector code.
+ */
+template <std::size_t Lanes>
+void philox4x32_10(std::uint32_t (&ctr)[4][Lanes], std::uint32_t key0,
+                   std::uint32_t key1) {
+    for (int round = 0; round != 10; ++round) {
+        for (std::size_t l = 0; l != Lanes; ++l) {
+            std::uint64_t p0 = std::uint64_t(philox_m0) * ctr[0][l];
+            std::uint64_t p1 = std::uint64_t(philox_m1) * ctr[2][l];
+            std::uint32_t x0 =
+                static_cast<std::uint32_t>(p1 >> 32) ^ ctr[1][l] ^ key0;
+            std::uint32_t x2 =
+                static_cast<std::uint32_t>(p0 >> 32) ^ ctr[3][l] ^ key1;
+            ctr[0][l] = x0;
+            ctr[1][l] = static_cast<std::uint32_t>(p1);
+            ctr[2][l] = x2;
+            ctr[3][l] = static_cast<std::uint32_t>(p0);
+        }
+        key0 += philox_w0;
+        key1 += philox_w1;
+    }
+}
+
+/// Philox4x32-10 of a single counter, see Salmon et al. SC'11
+inline std::array<std::uint32_t, 4> philox4x32_10(
+    const std::array<std::uint32_t, 4>& counter,
+    const std::array<std::uint32_t, 2>& key) {
+    std::uint32_t ctr[4][1] = {
+        {counter[0]}, {counter[1]}, {counter[2]}, {counter[3]}};
+    philox4x32_10(ctr, key[0], key[1]);
+    return {{ctr[0][0], ctr[1][0], ctr[2][0], ctr[3][0]}};
+}
+
+}  // end namespace detail
+
+/**@ingroup random
+ * @brief Counter based random number engine Philox4x32-10
+ *
+ * Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", SC'11.
+ * The n-th block of four 32 bit words is a bijection of the counter
+ * `(n, stream)` under the key `seed`, so the engine has no state besides
+ * its position. Every pair of seed and stream id is an independent
+ * sequence of 2^65 64 bit numbers, e.g. one per thread or per task:
+ *
+ *     js::Philox4x32 g(seed, task_id);
+ *
+ * `discard()` takes constant time. `fill()` produces many numbers at
+ * once by computing several blocks in parallel SIMD lanes.
+ *
+ * Fulfills the random number engine concept,
+ * http://en.cppreference.com/w/cpp/concept/RandomNumberEngine
+ */
+class Philox4x32 {
+  public:
+    using result_type = std::uint64_t;
+    static constexpr std::uint64_t default_seed = 20111115u;
+
+  private:
+    /// Number of blocks computed at once in `fill()`
+    static constexpr std::size_t lanes = 8;
+
+    std::uint64_t _key;
+    std::uint64_t _stream;
+    /// Next block to compute
+    std::uint64_t _block;
+    /// Outputs of block `_block - 1`
+    std::array<result_type, 2> _buffer;
+    /// Next output in `_buffer`, 2 if empty
+    unsigned _index;
+
+    /**@brief Position of the next output as block and word in the block
+     *
+     * The position `2 * block + word` needs 65 bits, so it is kept as
+     * pair. The block counter wraps after 2^64 blocks.
+     */
+    std::pair<std::uint64_t, unsigned> position() const noexcept {
+        if (_index == 2) return {_block, 0};
+        return {_block - 1, _index};
+    }
+    /// Continues at word `word` of block `block`
+    void set_position(std::uint64_t block, unsigned word) {
+        _block = block;
+        _index = 2;
+        if (word == 1) {
+            generate_block();
+            _index = 1;
+        }
+    }
+
+    void generate_block() {
+        std::uint32_t ctr[4][1] = {{static_cast<std::uint32_t>(_block)},
+                                   {static_cast<std::uint32_t>(_block >> 32)},
+                                   {static_cast<std::uint32_t>(_stream)},
+                                   {static_cast<std::uint32_t>(_stream >> 32)}};
+        detail::philox4x32_10(ctr, static_cast<std::uint32_t>(_key),
+                              static_cast<std::uint32_t>(_key >> 32));
+        _buffer[0] = ctr[0][0] | (std::uint64_t(ctr[1][0]) << 32);
+        _buffer[1] = ctr[2][0] | (std::uint64_t(ctr[3][0]) << 32);
+        ++_block;
+        _index = 0;
+    }
+
+    template <class Sseq>
+    using enable_seed_seq =
+        std::enable_if_t<!std::is_convertible<Sseq, std::uint64_t>::value>;
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    /// Default seed and stream 0
+    Philox4x32() : Philox4x32(default_seed) {}
+    /// Sequence `stream` of key `seed`
+    explicit Philox4x32(std::uint64_t seed, std::uint64_t stream = 0) {
+        this->seed(seed, stream);
+    }
+    /// Key and stream from seed sequence
+    template <class Sseq, class = enable_seed_seq<Sseq>>
+    explicit Philox4x32(Sseq& q) {
+        seed(q);
+    }
+    ///@}
+
+    /**@name Seeding
+     */
+    ///@{
+    void seed() { seed(default_seed); }
+    /// Restarts sequence `stream` of key `seed`
+    void seed(std::uint64_t seed, std::uint64_t stream = 0) {
+        _key = seed;
+        _stream = stream;
+        _block = 0;
+        _index = 2;
+    }
+    /// Takes key and stream from four 32 bit words of `q`
+    template <class Sseq, class = enable_seed_seq<Sseq>>
+    void seed(Sseq& q) {
+        std::uint32_t words[4];
+        q.generate(words, words + 4);
+        seed(words[0] | (std::uint64_t(words[1]) << 32),
+             words[2] | (std::uint64_t(words[3]) << 32));
+    }
+    /// Restarts the current key with another stream
+    void stream(std::uint64_t stream) { seed(_key, stream); }
+    std::uint64_t stream() const noexcept { return _stream; }
+    std::uint64_t key() const noexcept { return _key; }
+    ///@}
+
+    /**@name Generation
+     */
+    ///@{
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        if (_index == 2) generate_block();
+        return _buffer[_index++];
+    }
+
+    /// Advances the sequence by `z` numbers in constant time
+    void discard(unsigned long long z) {
+        auto pos = position();
+        unsigned word = pos.second + static_cast<unsigned>(z % 2);
+        set_position(pos.first + z / 2 + word / 2, word % 2);
+    }
+
+    /**@brief Writes the next `n` numbers to `out`
+     *
+     * Same numbers as `n` calls of `operator()`, but full blocks are
+     * computed `lanes` at a time.
+     */
+    void fill(result_type* out, std::size_t n) {
+        for (; n != 0 && _index != 2; --n) *out++ = operator()();
+        for (; n >= 2 * lanes; n -= 2 * lanes, out += 2 * lanes) {
+            std::uint32_t ctr[4][lanes];
+            for (std::size_t l = 0; l != lanes; ++l) {
+                std::uint64_t block = _block + l;
+                ctr[0][l] = static_cast<std::uint32_t>(block);
+                ctr[1][l] = static_cast<std::uint32_t>(block >> 32);
+                ctr[2][l] = static_cast<std::uint32_t>(_stream);
+                ctr[3][l] = static_cast<std::uint32_t>(_stream >> 32);
+            }
+            detail::philox4x32_10(ctr, static_cast<std::uint32_t>(_key),
+                                  static_cast<std::uint32_t>(_key >> 32));
+            for (std::size_t l = 0; l != lanes; ++l) {
+                out[2 * l] = ctr[0][l] | (std::uint64_t(ctr[1][l]) << 32);
+                out[2 * l + 1] = ctr[2][l] | (std::uint64_t(ctr[3][l]) << 32);
+            }
+            _block += lanes;
+        }
+        for (; n != 0; --n) *out++ = operator()();
+    }
+    ///@}
+
+    /**@name Comparators
+     */
+    ///@{
+    friend bool operator==(const Philox4x32& g1, const Philox4x32& g2) {
+        return g1._key == g2._key && g1._stream == g2._stream &&
+               g1.position() == g2.position();
+    }
+    friend bool operator!=(const Philox4x32& g1, const Philox4x32& g2) {
+        return !(g1 == g2);
+    }
+    ///@}
+
+    /**@name Streamoperator
+     */
+    ///@{
+    /// Writes key, stream, block and word in the block
+    template <class CharT, class Traits>
+    friend std::basic_ostream<CharT, Traits>& operator<<(
+        std::basic_ostream<CharT, Traits>& os, const Philox4x32& g) {
+        auto pos = g.position();
+        os << g._key << ' ' << g._stream << ' ' << pos.first << ' '
+           << pos.second;
+        return os;
+    }
+    template <class CharT, class Traits>
+    friend std::basic_istream<CharT, Traits>& operator>>(
+        std::basic_istream<CharT, Traits>& is, Philox4x32& g) {
+        std::uint64_t key, stream, block;
+        unsigned word;
+        if (is >> key >> stream >> block >> word) {
+            if (word > 1) {
+                is.setstate(std::ios::failbit);
+                return is;
+            }
+            g.seed(key, stream);
+            g.set_position(block, word);
+        }
+        return is;
+    }
+    ///@}
+};
+
+}  // end namespace js
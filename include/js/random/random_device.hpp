@@ -18,51 +18,226 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <algorithm>
+#include <cerrno>
 #include <chrono>
-#include <fstream>
-#include <functional>
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+// <sys/random.h> declares getrandom only on Linux with glibc 2.25 or later,
+// on macOS and the BSDs it declares getentropy
+#if defined(__linux__) && defined(__GLIBC__) && \
+    (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 25))
+#include <sys/random.h>
+#define JS_HAVE_GETRANDOM 1
+#elif (defined(__APPLE__) || defined(__FreeBSD__)) && defined(__has_include)
+#if __has_include(<sys/random.h>)
+#include <sys/random.h>
+#define JS_HAVE_GETENTROPY 1
+#endif
+#endif
 
 namespace js {
 
 /// @addtogroup random
 /// @{
 
-/**@brief Template for returning randomnumbers
+/**@brief One step of the SplitMix64 generator
  *
- * Function will be specialized to either 32 of 64 bit random numbers
- * drawn from the non blocking entropy pool `/dev/urandom` of the system.
+ * Advances `state` by a Weyl increment and returns the mixed value. Used
+ * to expand one seed into many, see Steele et al., "Fast splittable
+ * pseudorandom number generators", OOPSLA 2014.
+ */
+inline std::uint64_t splitmix64(std::uint64_t& state) noexcept {
+    std::uint64_t z = (state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+namespace detail {
+
+/// Reads from `/dev/urandom`, returns false on failure
+inline bool urandom_bytes(unsigned char* data, std::size_t size) {
+    int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    while (size > 0) {
+        ssize_t n = ::read(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    ::close(fd);
+    return size == 0;
+}
+
+/**@brief Fills `data` with `size` bytes from the entropy pool of the system
  *
- * Note this was supposed to be used on a system where
- * std::random_device did not work... or the user (me) was too stupid to
- * use is.
+ * Uses `getrandom(2)` on Linux and `getentropy(2)` on macOS and FreeBSD,
+ * which need no file descriptor, and `/dev/urandom` otherwise. If both fail, the bytes are derived from
+ * the clock, which is not suitable for anything but seeding simulations.
+ */
+inline void system_entropy(unsigned char* data, std::size_t size) {
+#ifdef JS_HAVE_GETRANDOM
+    while (size > 0) {
+        ssize_t n = ::getrandom(data, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    if (size == 0) return;
+#elif defined(JS_HAVE_GETENTROPY)
+    // getentropy returns at most 256 bytes per call
+    while (size > 0) {
+        std::size_t n = size < 256 ? size : 256;
+        if (::getentropy(data, n) != 0) break;
+        data += n;
+        size -= n;
+    }
+    if (size == 0) return;
+#endif
+    if (urandom_bytes(data, size)) return;
+    std::uint64_t state = static_cast<std::uint64_t>(
+        std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    state ^= reinterpret_cast<std::uintptr_t>(data);
+    while (size > 0) {
+        std::uint64_t x = splitmix64(state);
+        std::size_t n = size < sizeof(x) ? size : sizeof(x);
+        std::memcpy(data, &x, n);
+        data += n;
+        size -= n;
+    }
+}
+}  // end namespace detail
+
+/**@brief Random seed from the entropy pool of the system
+ *
+ * Every call reads the entropy pool of the system, see
+ * `detail::system_entropy`. To seed many
+ * engines use `fill_seeds()` or a SeedExpander.
  */
 template <class S>
 S seed() {
+    static_assert(std::is_trivially_copyable<S>::value,
+                  "seed requires a trivially copyable type");
     S random_seed;
-    std::ifstream rand_dev("/dev/urandom", std::ios::binary);
-    if (rand_dev.is_open()) {
-        char* memblock;
-        memblock = new char[sizeof(S)];
-        rand_dev.read(memblock, sizeof(S));
-        rand_dev.close();
-        random_seed = *reinterpret_cast<S*>(memblock);
-        delete[] memblock;
-    } else {
-        std::cerr << "Chrono" << std::endl;
-        auto seed_chrono = std::chrono::high_resolution_clock::now()
-                               .time_since_epoch()
-                               .count();
-        random_seed = std::hash<S>{}(seed_chrono);
-    }
+    detail::system_entropy(reinterpret_cast<unsigned char*>(&random_seed),
+                           sizeof(S));
     return random_seed;
 }
 
 /// Specialization for 64 bit numbers
-std::uint64_t seed64() { return seed<std::uint64_t>(); }
+inline std::uint64_t seed64() { return seed<std::uint64_t>(); }
 
 /// Specialization for 32 bit numbers
-std::uint32_t seed32() { return seed<std::uint32_t>(); }
+inline std::uint32_t seed32() { return seed<std::uint32_t>(); }
+
+/**@brief Fills [first, last) with random seeds in one system call
+ *
+ * The value type must be an integral type. For example
+ *
+ *     std::vector<std::uint32_t> words(624);
+ *     js::fill_seeds(words.begin(), words.end());
+ *     std::seed_seq seq(words.begin(), words.end());
+ *     std::mt19937 g(seq);
+ */
+template <class ForwardIt>
+void fill_seeds(ForwardIt first, ForwardIt last) {
+    using value_type = typename std::iterator_traits<ForwardIt>::value_type;
+    static_assert(std::is_integral<value_type>::value,
+                  "fill_seeds requires integral values");
+    std::vector<value_type> buffer(std::distance(first, last));
+    detail::system_entropy(reinterpret_cast<unsigned char*>(buffer.data()),
+                           buffer.size() * sizeof(value_type));
+    std::copy(buffer.begin(), buffer.end(), first);
+}
+
+/**@brief Seed sequence expanding one seed into many with SplitMix64
+ *
+ * Fulfills the SeedSequence concept, so it can seed standard engines
+ * directly. Unlike std::seed_seq every call of `generate()` continues the
+ * sequence, so consecutive engines get different states:
+ *
+ *     js::SeedExpander seeds = js::SeedExpander::from_entropy();
+ *     std::vector<std::mt19937_64> engines;
+ *     for (std::size_t i = 0; i != workers; ++i) engines.emplace_back(seeds);
+ *
+ * `operator()` returns 64 bit seeds, e.g. for Philox4x32. A pool of
+ * workers is seeded with a single read of system entropy, and the seeds
+ * are reproducible from the initial values.
+ */
+class SeedExpander {
+  public:
+    using result_type = std::uint32_t;
+
+  private:
+    std::vector<result_type> _values;
+    std::uint64_t _state;
+
+    void init() {
+        _state = 0;
+        for (auto v : _values) {
+            _state = splitmix64(_state) ^ v;
+        }
+    }
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    SeedExpander() { init(); }
+    /// Sequence determined by the 32 bit values in [first, last)
+    template <class InputIt>
+    SeedExpander(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            _values.push_back(static_cast<result_type>(*first));
+        }
+        init();
+    }
+    template <class T>
+    SeedExpander(std::initializer_list<T> values)
+        : SeedExpander(values.begin(), values.end()) {}
+    /// Sequence started from 64 bit of system entropy
+    static SeedExpander from_entropy() {
+        std::uint64_t s = seed64();
+        return {static_cast<result_type>(s),
+                static_cast<result_type>(s >> 32)};
+    }
+    ///@}
+
+    /// Next 64 bit seed
+    std::uint64_t operator()() noexcept { return splitmix64(_state); }
+
+    /// Fills [first, last) with the next 32 bit values
+    template <class RandomIt>
+    void generate(RandomIt first, RandomIt last) {
+        while (first != last) {
+            std::uint64_t x = splitmix64(_state);
+            *first = static_cast<result_type>(x);
+            if (++first == last) break;
+            *first = static_cast<result_type>(x >> 32);
+            ++first;
+        }
+    }
+
+    /// Number of initial values
+    std::size_t size() const noexcept { return _values.size(); }
+
+    /// Copies the initial values to `dest`
+    template <class OutputIt>
+    void param(OutputIt dest) const {
+        std::copy(_values.begin(), _values.end(), dest);
+    }
+};
 
 ///@}
 
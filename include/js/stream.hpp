@@ -1,6 +1,13 @@
 #pragma once
 
 #include "stream/basic_file_handler.hpp"
+#include "stream/async_file_handler.hpp"
+#include "stream/binary_file_handler.hpp"
+#include "stream/compressed_file.hpp"
+#include "stream/mapped_file.hpp"
+#include "stream/number_format.hpp"
+#include "stream/rotating_file_handler.hpp"
+#include "stream/table_reader.hpp"
 
 /**\defgroup stream Stream
  * \brief All stream related stuff here...
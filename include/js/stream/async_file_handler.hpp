@@ -0,0 +1,374 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "basic_file_handler.hpp"
+#include "number_format.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace js {
+namespace detail {
+
+/**\ingroup stream
+ * \brief Stream buffer handing full buffers to a writer thread
+ *
+ * The buffer owns `no_buffers` blocks of `buffer_size` bytes. The
+ * producer formats into the current block. Full blocks are queued and
+ * written by a background thread with `write(2)`. If no free block is
+ * left, the producer waits until the writer returns one.
+ *
+ * `sync()` does nothing, so `std::flush` does not cause small writes.
+ * Use `flush()` to write out all data.
+ */
+class AsyncStreamBuf : public std::streambuf {
+  private:
+    using Block = std::pair<char*, std::size_t>;
+
+    std::size_t _buffer_size;
+    std::vector<std::unique_ptr<char[]>> _storage;
+    std::vector<char*> _free;
+    std::deque<Block> _full;
+    std::size_t _in_flight;
+    int _fd;
+    int _error;
+    bool _stop;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    std::thread _writer;
+
+    void writer_loop();
+    void hand_over();
+
+  protected:
+    int_type overflow(int_type c) override;
+    int sync() override { return 0; }
+
+  public:
+    AsyncStreamBuf(std::size_t buffer_size, std::size_t no_buffers);
+    AsyncStreamBuf(const AsyncStreamBuf&) = delete;
+    AsyncStreamBuf& operator=(const AsyncStreamBuf&) = delete;
+    ~AsyncStreamBuf();
+
+    /// Copies `size` bytes to the buffer, bypassing the stream
+    void append(const char* data, std::size_t size);
+    /// Takes ownership of `fd` and starts the writer thread
+    void start(int fd);
+    /// Writes all buffered data and waits for the writer
+    void flush();
+    /// Flushes, stops the writer thread and closes the file descriptor
+    void stop();
+    bool running() const noexcept { return _fd != -1; }
+};
+
+/**\ingroup stream
+ * \brief File handler writing on a background thread
+ *
+ * Same interface as BasicFileHandler, but `operator<<` only formats into
+ * memory. Full buffers are written by a background thread, so the
+ * producing thread does not wait for the disk unless all buffers are
+ * in use.
+ *
+ * Numbers are formatted by `format_number` directly into the buffer,
+ * see BasicFileHandler for the format, for manipulators and for
+ * `shortest_floats`.
+ *
+ * `flush()` returns after all data is written. Errors of the writer
+ * thread are reported as std::runtime_error by `flush()` and `close()`.
+ * The destructor closes the file but ignores errors.
+ */
+class AsyncFileHandler {
+  protected:
+    std::string _filename;
+    std::string _file_extension;
+    AsyncStreamBuf _buffer;
+    std::ostream _file;
+    bool _file_open;
+    int _writing_attempts;
+    bool _shortest_floats;
+
+    template <class T>
+    std::enable_if_t<is_fast_formatted<T>::value> put(T t) {
+        if ((std::is_floating_point<T>::value && !_shortest_floats) ||
+            !detail::default_number_format(_file)) {
+            _file << t;
+            return;
+        }
+        char number[max_number_size];
+        _buffer.append(number, js::format_number(number, t) - number);
+    }
+    template <class T>
+    std::enable_if_t<!is_fast_formatted<T>::value> put(const T& t) {
+        _file << t;
+    }
+
+  public:
+    /// Default size of a single buffer
+    static constexpr std::size_t default_buffer_size = 1 << 20;
+    /// Default number of buffers
+    static constexpr std::size_t default_no_buffers = 4;
+
+    /**@name Constructors
+     */
+    ///@{
+    /// Default constructor. Sets infinite writing attempts as default.
+    AsyncFileHandler()
+        : AsyncFileHandler(-42, default_buffer_size, default_no_buffers) {}
+    /// Opens no file, sets writing attempts and buffers
+    AsyncFileHandler(int writing_attempts, std::size_t buffer_size,
+                     std::size_t no_buffers)
+        : _buffer(buffer_size, no_buffers),
+          _file(&_buffer),
+          _file_open(false),
+          _writing_attempts(writing_attempts),
+          _shortest_floats(true) {}
+    /// Opens file with filename
+    AsyncFileHandler(std::string filename) : AsyncFileHandler() {
+        open(filename);
+    }
+    /// Open file with filename.extension
+    AsyncFileHandler(std::string filename, std::string file_extension)
+        : AsyncFileHandler() {
+        open(filename, file_extension);
+    }
+    ///@}
+    ~AsyncFileHandler();
+
+    /**@name open and close
+     */
+    ///@{
+    /// Opens file with given name, see BasicFileHandler
+    void open(std::string filename) { open(filename, std::string()); }
+    /// Opens file with given name and extension
+    void open(std::string, std::string);
+    /// Writes all buffered data to the file
+    void flush();
+    /// Flushes and closes the file
+    void close();
+    ///@}
+
+    /**@name settings
+     */
+    ///@{
+    /// Set how many writing attempts will be made
+    void writingAttempts(int writing) noexcept { _writing_attempts = writing; }
+    /// Get how many writing attempts will be made
+    int writingAttempts() noexcept { return _writing_attempts; }
+    /// Get Filename
+    std::string getFilename() noexcept { return _filename; }
+    /// Set whether floats are written with the shortest digits, default true
+    void shortest_floats(bool b) noexcept { _shortest_floats = b; }
+    /// Get whether floats are written with the shortest digits
+    bool shortest_floats() const noexcept { return _shortest_floats; }
+    ///@}
+
+    /// Write raw bytes
+    void write(const char* data, std::size_t size) {
+        _file.write(data, static_cast<std::streamsize>(size));
+    }
+
+    template <class T>
+    friend AsyncFileHandler& operator<<(AsyncFileHandler&, const T&);
+};
+
+template <class T>
+AsyncFileHandler& operator<<(AsyncFileHandler& in, const T& t) {
+    in.put(t);
+    return in;
+}
+
+/*
+ * Functions implementations
+ */
+
+inline AsyncStreamBuf::AsyncStreamBuf(std::size_t buffer_size,
+                                      std::size_t no_buffers)
+    : _buffer_size(buffer_size > 0 ? buffer_size : 1),
+      _in_flight(0),
+      _fd(-1),
+      _error(0),
+      _stop(false) {
+    if (no_buffers < 2) no_buffers = 2;
+    for (std::size_t i = 0; i != no_buffers; ++i) {
+        _storage.emplace_back(new char[_buffer_size]);
+        _free.push_back(_storage.back().get());
+    }
+}
+
+inline AsyncStreamBuf::~AsyncStreamBuf() {
+    try {
+        stop();
+    } catch (...) {
+    }
+}
+
+inline void AsyncStreamBuf::start(int fd) {
+    _fd = fd;
+    _error = 0;
+    _stop = false;
+    char* current = _free.back();
+    _free.pop_back();
+    setp(current, current + _buffer_size);
+    _writer = std::thread([this]() { writer_loop(); });
+}
+
+inline void AsyncStreamBuf::hand_over() {
+    std::size_t size = pptr() - pbase();
+    if (size == 0) return;
+    std::unique_lock<std::mutex> lock(_mutex);
+    _full.emplace_back(pbase(), size);
+    _cv.notify_all();
+    // Backpressure: wait for the writer to return a buffer
+    _cv.wait(lock, [this]() { return !_free.empty(); });
+    char* current = _free.back();
+    _free.pop_back();
+    setp(current, current + _buffer_size);
+}
+
+inline void AsyncStreamBuf::append(const char* data, std::size_t size) {
+    if (_fd == -1) return;
+    while (size > 0) {
+        if (pptr() == epptr()) hand_over();
+        std::size_t n = std::min<std::size_t>(size, epptr() - pptr());
+        std::memcpy(pptr(), data, n);
+        pbump(static_cast<int>(n));
+        data += n;
+        size -= n;
+    }
+}
+
+inline AsyncStreamBuf::int_type AsyncStreamBuf::overflow(int_type c) {
+    if (_fd == -1) return traits_type::eof();
+    hand_over();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+inline void AsyncStreamBuf::writer_loop() {
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _cv.wait(lock, [this]() { return _stop || !_full.empty(); });
+        if (_full.empty()) return;
+        Block block = _full.front();
+        _full.pop_front();
+        ++_in_flight;
+        bool failed = _error != 0;
+        lock.unlock();
+        // After an error the remaining data is dropped
+        int error = 0;
+        std::size_t written = 0;
+        while (!failed && written < block.second) {
+            ssize_t n = ::write(_fd, block.first + written,
+                                block.second - written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = errno;
+                break;
+            }
+            written += static_cast<std::size_t>(n);
+        }
+        lock.lock();
+        if (error != 0 && _error == 0) _error = error;
+        _free.push_back(block.first);
+        --_in_flight;
+        _cv.notify_all();
+    }
+}
+
+inline void AsyncStreamBuf::flush() {
+    if (_fd == -1) return;
+    hand_over();
+    std::unique_lock<std::mutex> lock(_mutex);
+    _cv.wait(lock, [this]() { return _full.empty() && _in_flight == 0; });
+    if (_error != 0) {
+        throw std::runtime_error(std::string("Writing file failed: ") +
+                                 std::strerror(_error));
+    }
+}
+
+inline void AsyncStreamBuf::stop() {
+    if (_fd == -1) return;
+    int error = 0;
+    try {
+        flush();
+    } catch (std::runtime_error&) {
+        error = _error;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _cv.notify_all();
+    _writer.join();
+    _free.push_back(pbase());
+    setp(nullptr, nullptr);
+    if (::close(_fd) != 0 && error == 0) error = errno;
+    _fd = -1;
+    if (error != 0) {
+        throw std::runtime_error(std::string("Writing file failed: ") +
+                                 std::strerror(error));
+    }
+}
+
+inline AsyncFileHandler::~AsyncFileHandler() {
+    try {
+        _buffer.stop();
+    } catch (...) {
+    }
+}
+
+inline void AsyncFileHandler::open(std::string filename,
+                                   std::string file_extension) {
+    if (_file_open) close();
+    _file_extension = file_extension;
+    int fd = create_free_file(filename, file_extension, _writing_attempts,
+                              _filename);
+    _file.clear();
+    _buffer.start(fd);
+    _file_open = true;
+}
+
+inline void AsyncFileHandler::flush() { _buffer.flush(); }
+
+inline void AsyncFileHandler::close() {
+    _file_open = false;
+    _filename.clear();
+    _file_extension.clear();
+    _buffer.stop();
+}
+
+}  // end namespace detail
+}  // END namespace js
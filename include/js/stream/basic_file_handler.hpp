@@ -19,14 +19,130 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include "../tuple/tuple_functions.hpp"
+#include "number_format.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
 #include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <sys/stat.h>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
 
 namespace js {
 namespace detail {
+/// `filename.extension` for index 0, `filename-index.extension` otherwise
+inline std::string numbered_filename(const std::string& filename,
+                                     const std::string& file_extension,
+                                     std::size_t index) {
+    std::string name = filename;
+    if (index > 0) name += "-" + std::to_string(index);
+    if (!file_extension.empty()) name += "." + file_extension;
+    return name;
+}
+
+inline bool file_exists(const std::string& name) {
+    struct stat buffer;
+    return stat(name.c_str(), &buffer) == 0;
+}
+
+/**\ingroup stream
+ * \brief Smallest free index not below `start`
+ *
+ * Probes the indices `start + 1, start + 2, start + 4, ...` until a name
+ * is free, then bisects between the last used and the first free index.
+ * This takes O(log k) `stat` calls for k existing files instead of k. If
+ * the used indices have gaps, a free index after a gap may be returned.
+ */
+inline std::size_t free_file_index(const std::string& filename,
+                                   const std::string& file_extension,
+                                   std::size_t start) {
+    auto used = [&](std::size_t index) {
+        return file_exists(numbered_filename(filename, file_extension, index));
+    };
+    if (!used(start)) return start;
+    std::size_t last_used = start;
+    std::size_t step = 1;
+    while (used(start + step)) {
+        last_used = start + step;
+        step *= 2;
+    }
+    std::size_t first_free = start + step;
+    while (first_free - last_used > 1) {
+        std::size_t mid = last_used + (first_free - last_used) / 2;
+        (used(mid) ? last_used : first_free) = mid;
+    }
+    return first_free;
+}
+
+/// Throws if `index` exceeds positive `writing_attempts`
+inline void check_writing_attempts(std::size_t index, int writing_attempts) {
+    if (writing_attempts > 0 &&
+        index >= static_cast<std::size_t>(writing_attempts)) {
+        throw std::runtime_error("Could not open file after " +
+                                 std::to_string(writing_attempts) +
+                                 " attempts.\n");
+    }
+}
+
+/**\ingroup stream
+ * \brief Find a filename that is not used yet
+ *
+ * Returns `filename.extension`, `filename-1.extension`, ... whichever
+ * does not exist, see `free_file_index`. Throws std::runtime_error if
+ * the index reaches `writing_attempts`, if `writing_attempts` is
+ * positive.
+ */
+inline std::string free_filename(const std::string& filename,
+                                 const std::string& file_extension,
+                                 int writing_attempts) {
+    std::size_t index = free_file_index(filename, file_extension, 0);
+    check_writing_attempts(index, writing_attempts);
+    return numbered_filename(filename, file_extension, index);
+}
+
+/**\ingroup stream
+ * \brief Creates a new file with the first free name from index `index`
+ *
+ * Like `free_filename`, but the file is created with `O_EXCL`, so two
+ * writers never get the same file. If another process takes the name
+ * first, the next index is tried. Returns the file descriptor for
+ * writing and sets `name` and `index` to the created file. Throws
+ * std::runtime_error on errors.
+ */
+inline int create_free_file(const std::string& filename,
+                            const std::string& file_extension,
+                            int writing_attempts, std::string& name,
+                            std::size_t& index) {
+    while (true) {
+        index = free_file_index(filename, file_extension, index);
+        check_writing_attempts(index, writing_attempts);
+        name = numbered_filename(filename, file_extension, index);
+        int fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                        0644);
+        if (fd != -1) return fd;
+        if (errno == EEXIST) {
+            ++index;
+        } else if (errno != EINTR) {
+            throw std::runtime_error("Could not open file " + name + ": " +
+                                     std::strerror(errno));
+        }
+    }
+}
+
+/// Same as above starting at index 0
+inline int create_free_file(const std::string& filename,
+                            const std::string& file_extension,
+                            int writing_attempts, std::string& name) {
+    std::size_t index = 0;
+    return create_free_file(filename, file_extension, writing_attempts, name,
+                            index);
+}
+
 /**\ingroup stream
  * \brief Basic file out handling class
  * Basic class for writing to data files. Class contains only the
@@ -39,6 +155,20 @@ namespace detail {
  * If number of tries excedes the previous set number of tries, an
  * exception of class std::runtime_error is thrown. The number of
  * apptemts can be set.
+ *
+ * Numbers (see `is_fast_formatted`), strings and characters are
+ * formatted into an internal buffer without the stream, integers two
+ * digits at a time and floating point numbers with the shortest digits
+ * that read back as the same value. Note that by default floating point
+ * numbers are therefore no longer rounded to 6 significant digits,
+ * `0.1 + 0.2` is written as `0.30000000000000004` and `1234567.0` as
+ * `1234567`. `shortest_floats(false)` restores the 6 significant digits
+ * of the stream, e.g. for existing data pipelines. After manipulators
+ * like `std::setprecision`, `std::fixed`, `std::hex` or `std::setw`
+ * changed the format of the stream, values are written by the stream
+ * with that format. Other types are written with the stream after the
+ * buffer. `write_row` and `write_column` write tuples and ranges with
+ * the separators set by `separator` and `lineEnd`.
  */
 class BasicFileHandler {
   protected:
@@ -47,8 +177,63 @@ class BasicFileHandler {
     std::ofstream _file;
     bool _file_open;
     int _writing_attempts;
+    std::string _buffer;
+    std::string _separator;
+    std::string _line_end;
+    bool _shortest_floats;
+
+    /// Appends to the buffer, which is written to the stream when full
+    void append(const char* data, std::size_t size) {
+        if (_buffer.size() + size > buffer_size) flush_buffer();
+        if (size >= buffer_size) {
+            _file.write(data, static_cast<std::streamsize>(size));
+        } else {
+            _buffer.append(data, size);
+        }
+    }
+    void flush_buffer() {
+        _file.write(_buffer.data(),
+                    static_cast<std::streamsize>(_buffer.size()));
+        _buffer.clear();
+    }
+
+    /// Writes `t` with the stream, after the buffer
+    template <class T>
+    void put_stream(const T& t) {
+        flush_buffer();
+        _file << t;
+    }
+
+    template <class T>
+    std::enable_if_t<is_fast_formatted<T>::value> put(T t) {
+        if ((std::is_floating_point<T>::value && !_shortest_floats) ||
+            !detail::default_number_format(_file)) {
+            return put_stream(t);
+        }
+        char number[max_number_size];
+        append(number, js::format_number(number, t) - number);
+    }
+    void put(const std::string& s) {
+        if (_file.width() != 0) return put_stream(s);
+        append(s.data(), s.size());
+    }
+    void put(const char* s) {
+        if (_file.width() != 0) return put_stream(s);
+        append(s, std::strlen(s));
+    }
+    void put(char c) {
+        if (_file.width() != 0) return put_stream(c);
+        append(&c, 1);
+    }
+    template <class T>
+    std::enable_if_t<!is_fast_formatted<T>::value> put(const T& t) {
+        put_stream(t);
+    }
 
   public:
+    /// Size of the internal buffer
+    static constexpr std::size_t buffer_size = 1 << 16;
+
     /**@name Constructors
      */
     ///@{
@@ -56,7 +241,13 @@ class BasicFileHandler {
     BasicFileHandler() : BasicFileHandler(-42){};
     /// Constructor. Opens no file, sets writing attempts
     BasicFileHandler(int writing_attempts)
-        : _file_open(false), _writing_attempts(writing_attempts){};
+        : _file_open(false),
+          _writing_attempts(writing_attempts),
+          _separator("\t"),
+          _line_end("\n"),
+          _shortest_floats(true) {
+        _buffer.reserve(buffer_size);
+    };
     /// Opens file with filname
     BasicFileHandler(std::string);
     /// Opens file with filename and sets writing attempts
@@ -79,6 +270,8 @@ class BasicFileHandler {
     void open(std::string);
     /// Opens file with given name and extension
     void open(std::string, std::string);
+    /// Writes the buffer and flushes the stream
+    void flush();
     /// Closes file
     void close() noexcept;
     ///@}
@@ -91,6 +284,34 @@ class BasicFileHandler {
     int writingAttempts() noexcept;
     /// Get Filename
     std::string getFilename() noexcept;
+    /// Set separator between the values of rows, default tab
+    void separator(std::string s) { _separator = std::move(s); }
+    /// Get separator between the values of rows
+    const std::string& separator() const noexcept { return _separator; }
+    /// Set end of rows and column values, default newline
+    void lineEnd(std::string s) { _line_end = std::move(s); }
+    /// Get end of rows and column values
+    const std::string& lineEnd() const noexcept { return _line_end; }
+    /**\brief Set whether floating point numbers are written with the
+     * shortest round trip digits, default true
+     *
+     * If false, they are written by the stream with its precision, 6
+     * significant digits unless changed by `std::setprecision`.
+     */
+    void shortest_floats(bool b) noexcept { _shortest_floats = b; }
+    /// Get whether floating point numbers are written with the shortest digits
+    bool shortest_floats() const noexcept { return _shortest_floats; }
+    ///@}
+
+    /**@name bulk output
+     */
+    ///@{
+    /// Writes the elements of `row` separated by `separator()` as a line
+    template <class... T>
+    void write_row(const std::tuple<T...>& row);
+    /// Writes every element of `column` in its own line
+    template <class Range>
+    void write_column(const Range& column);
     ///@}
 
     template<class T>
@@ -99,7 +320,7 @@ class BasicFileHandler {
 
 template<class T>
 BasicFileHandler& operator<<(BasicFileHandler& in, const T& t) {
-    in._file << t;
+    in.put(t);
     return in;
 }
 
@@ -144,36 +365,25 @@ inline void BasicFileHandler::open(std::string filename) {
 
 inline void BasicFileHandler::open(std::string filename,
                                    std::string file_extension) {
-    std::stringstream filename_new;
+    if (_file_open) close();
     _file_extension = file_extension;
-    if (!file_extension.empty()) {  // If file_extension is not empty, insert
-                                    // '.' at the beginning.
-        file_extension.insert(0, 1, '.');
-    }
-    filename_new << filename;
-
-    struct stat buffer;
-    int count = 0;
-    while (stat(filename_new.str().append(file_extension).c_str(), &buffer) !=
-           -1) {
-        count++;
-        if (count == _writing_attempts) {
-            std::string errorstring(std::string("Could not open file after ") +
-                                    std::to_string(_writing_attempts) +
-                                    std::string(" attempts.\n"));
-            throw std::runtime_error(errorstring);
-        }
-        filename_new.str(std::string());
-        filename_new << filename << "-" << count;
-    }
-    _filename = filename_new.str();
-    _file.open(_filename.append(file_extension).c_str());
+    ::close(create_free_file(filename, file_extension, _writing_attempts,
+                             _filename));
+    // The file is new and empty. Truncating it again would make some file
+    // systems (ext4 auto_da_alloc) write it back at close.
+    _file.open(_filename.c_str(), std::ios::in | std::ios::out);
     _file_open = true;
 }
 
-inline BasicFileHandler::~BasicFileHandler() { _file.close(); }
+inline BasicFileHandler::~BasicFileHandler() { close(); }
+
+inline void BasicFileHandler::flush() {
+    flush_buffer();
+    _file.flush();
+}
 
 inline void BasicFileHandler::close() noexcept {
+    flush_buffer();
     _file.close();
     _file_open = false;
     _filename = std::string();
@@ -193,5 +403,24 @@ inline int BasicFileHandler::writingAttempts() noexcept {
 inline std::string BasicFileHandler::getFilename() noexcept {
     return _filename;
 }
+
+template <class... T>
+void BasicFileHandler::write_row(const std::tuple<T...>& row) {
+    bool first = true;
+    for_each_tuple(row, [this, &first](const auto& value) {
+        if (!first) this->put(_separator);
+        first = false;
+        this->put(value);
+    });
+    put(_line_end);
+}
+
+template <class Range>
+void BasicFileHandler::write_column(const Range& column) {
+    for (const auto& value : column) {
+        put(value);
+        put(_line_end);
+    }
+}
 }
 }  // END namespace js
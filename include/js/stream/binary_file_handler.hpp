@@ -0,0 +1,527 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../tuple/taggedtuple.hpp"
+#include "../type_traits/std_extension.hpp"
+#include "basic_file_handler.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace js {
+
+/**\ingroup stream
+ * \brief Type codes of the fields in binary record files
+ */
+enum class BinaryType : std::uint8_t {
+    raw = 0,
+    int8 = 1,
+    int16 = 2,
+    int32 = 3,
+    int64 = 4,
+    uint8 = 5,
+    uint16 = 6,
+    uint32 = 7,
+    uint64 = 8,
+    float32 = 9,
+    float64 = 10,
+    boolean = 11
+};
+
+namespace detail {
+
+/// Type code of T. Types without a code are stored as raw bytes.
+template <class T>
+constexpr BinaryType binary_type() {
+    if (std::is_same<T, bool>::value) return BinaryType::boolean;
+    if (std::is_floating_point<T>::value) {
+        if (sizeof(T) == 4) return BinaryType::float32;
+        if (sizeof(T) == 8) return BinaryType::float64;
+        return BinaryType::raw;
+    }
+    if (std::is_integral<T>::value) {
+        bool is_signed = std::is_signed<T>::value;
+        switch (sizeof(T)) {
+            case 1:
+                return is_signed ? BinaryType::int8 : BinaryType::uint8;
+            case 2:
+                return is_signed ? BinaryType::int16 : BinaryType::uint16;
+            case 4:
+                return is_signed ? BinaryType::int32 : BinaryType::uint32;
+            case 8:
+                return is_signed ? BinaryType::int64 : BinaryType::uint64;
+        }
+    }
+    return BinaryType::raw;
+}
+
+/// Endianness marker of the header
+constexpr std::uint8_t binary_little_endian = 1;
+constexpr std::uint8_t binary_big_endian = 2;
+
+inline std::uint8_t native_endianness() {
+    const std::uint16_t probe = 1;
+    std::uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1 ? binary_little_endian : binary_big_endian;
+}
+
+/// Magic bytes at the beginning of binary record files
+constexpr char binary_magic[8] = {'J', 'S', 'B', 'I', 'N', 'R', 'E', 'C'};
+/// Version of the file format
+constexpr std::uint16_t binary_version = 1;
+/// The records start at a multiple of this
+constexpr std::size_t binary_data_alignment = 64;
+
+/// Detects `Tag::name`
+template <class Tag, class = void>
+struct has_tag_name : std::false_type {};
+
+template <class Tag>
+struct has_tag_name<Tag, decltype((void)Tag::name)> : std::true_type {};
+
+template <class Tag>
+std::string tag_name(std::size_t, std::true_type) {
+    return std::string(Tag::name);
+}
+
+template <class Tag>
+std::string tag_name(std::size_t i, std::false_type) {
+    return "field" + std::to_string(i);
+}
+
+template <class... Tags, std::size_t... I>
+std::vector<std::string> tag_names(std::index_sequence<I...>) {
+    return {tag_name<Tags>(I, has_tag_name<Tags>{})...};
+}
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief Description of one field of a binary record
+ */
+struct BinaryField {
+    std::string name;
+    BinaryType type;
+    std::uint32_t size;
+    std::uint32_t offset;
+};
+
+namespace detail {
+/**\ingroup stream
+ * \brief Writes rows of trivially copyable values as binary records
+ *
+ * The file starts with a self describing header:
+ *
+ * | Bytes        | Content                                       |
+ * |--------------|-----------------------------------------------|
+ * | 8            | magic `JSBINREC`                              |
+ * | 2            | format version                                |
+ * | 1            | endianness, 1 little, 2 big                   |
+ * | 1            | reserved                                      |
+ * | 4            | number of fields                              |
+ * | 4            | record size                                   |
+ * | 8            | offset of the first record                    |
+ * | per field    | type (1), reserved (1), name length (2),      |
+ * |              | size (4), offset in record (4), name          |
+ *
+ * All numbers are in the byte order of the writing machine. The records
+ * start at a multiple of 64 bytes. Every field is aligned to its
+ * alignment inside the record, like in a struct, so the records can be
+ * used in place.
+ *
+ * Field names are given at construction. For tagged tuples, use
+ * `TaggedBinaryFileHandler`, which takes the names from `Tag::name` if
+ * present.
+ */
+template <class... T>
+class BinaryFileHandler {
+    static_assert(sizeof...(T) > 0, "At least one field is needed");
+    static_assert(conjugation_v<std::is_trivially_copyable<T>...>,
+                  "Fields have to be trivially copyable");
+
+  public:
+    using row_type = std::tuple<T...>;
+
+  private:
+    std::string _filename;
+    std::ofstream _file;
+    std::vector<BinaryField> _fields;
+    std::vector<char> _record;
+    std::size_t _no_records;
+    int _writing_attempts;
+
+    void write_header();
+
+    template <std::size_t... I>
+    void write_impl(const row_type& row, std::index_sequence<I...>) {
+        int dummy[] = {0, (std::memcpy(_record.data() + _fields[I].offset,
+                                       &std::get<I>(row), sizeof(T)),
+                           0)...};
+        (void)dummy;
+        _file.write(_record.data(),
+                    static_cast<std::streamsize>(_record.size()));
+        ++_no_records;
+    }
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    /// Fields are named field0, field1, ...
+    BinaryFileHandler()
+        : BinaryFileHandler(detail::tag_names<T...>(
+              std::index_sequence_for<T...>{})) {}
+    /// Sets the names of the fields
+    explicit BinaryFileHandler(const std::vector<std::string>& names);
+    /// Opens file with filename.extension
+    BinaryFileHandler(std::string filename, std::string file_extension,
+                      const std::vector<std::string>& names)
+        : BinaryFileHandler(names) {
+        open(filename, file_extension);
+    }
+    ///@}
+    ~BinaryFileHandler() { close(); }
+
+    /**@name open and close
+     */
+    ///@{
+    /**\brief Opens file and writes the header
+     *
+     * The name is chosen as in BasicFileHandler.
+     */
+    void open(std::string filename, std::string file_extension);
+    /// Closes file
+    void close() noexcept { _file.close(); }
+    ///@}
+
+    /// Set how many writing attempts will be made
+    void writingAttempts(int writing) noexcept { _writing_attempts = writing; }
+    /// Get Filename
+    std::string getFilename() const noexcept { return _filename; }
+    /// Field description
+    const std::vector<BinaryField>& fields() const noexcept { return _fields; }
+    /// Size of a record in bytes
+    std::size_t record_size() const noexcept { return _record.size(); }
+    /// Number of records written since opening
+    std::size_t size() const noexcept { return _no_records; }
+
+    /**@name Write records
+     */
+    ///@{
+    void write(const row_type& row) {
+        write_impl(row, std::index_sequence_for<T...>{});
+    }
+    void write(const T&... values) { write(std::tie(values...)); }
+    /// Writes all rows of the range [begin, end)
+    template <class Iterator>
+    std::enable_if_t<detail::is_iterator<Iterator>::value> write(
+        Iterator begin, Iterator end) {
+        for (; begin != end; ++begin) {
+            write(static_cast<const row_type&>(*begin));
+        }
+    }
+    friend BinaryFileHandler& operator<<(BinaryFileHandler& out,
+                                         const row_type& row) {
+        out.write(row);
+        return out;
+    }
+    ///@}
+};
+
+template <class... T>
+BinaryFileHandler<T...>::BinaryFileHandler(
+    const std::vector<std::string>& names)
+    : _no_records(0), _writing_attempts(-42) {
+    if (names.size() != sizeof...(T)) {
+        throw std::invalid_argument("Number of names and fields differ");
+    }
+    const std::size_t sizes[] = {sizeof(T)...};
+    const std::size_t alignments[] = {alignof(T)...};
+    const BinaryType types[] = {detail::binary_type<T>()...};
+    std::size_t offset = 0;
+    std::size_t max_alignment = 1;
+    for (std::size_t i = 0; i != sizeof...(T); ++i) {
+        offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+        _fields.push_back(BinaryField{names[i], types[i],
+                                      static_cast<std::uint32_t>(sizes[i]),
+                                      static_cast<std::uint32_t>(offset)});
+        offset += sizes[i];
+        max_alignment = std::max(max_alignment, alignments[i]);
+    }
+    offset = (offset + max_alignment - 1) / max_alignment * max_alignment;
+    _record.assign(offset, 0);
+}
+
+template <class... T>
+void BinaryFileHandler<T...>::open(std::string filename,
+                                   std::string file_extension) {
+    close();
+    ::close(create_free_file(filename, file_extension, _writing_attempts,
+                             _filename));
+    // Not truncated, see BasicFileHandler::open
+    _file.open(_filename.c_str(),
+               std::ios::binary | std::ios::in | std::ios::out);
+    if (!_file.is_open()) {
+        throw std::runtime_error("Could not open file " + _filename);
+    }
+    _no_records = 0;
+    write_header();
+}
+
+template <class... T>
+void BinaryFileHandler<T...>::write_header() {
+    std::vector<char> header;
+    auto put = [&header](const void* data, std::size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        header.insert(header.end(), bytes, bytes + size);
+    };
+    std::uint8_t endianness = detail::native_endianness();
+    std::uint8_t reserved = 0;
+    std::uint32_t no_fields = sizeof...(T);
+    std::uint32_t record_size = static_cast<std::uint32_t>(_record.size());
+    put(detail::binary_magic, sizeof(detail::binary_magic));
+    put(&detail::binary_version, sizeof(detail::binary_version));
+    put(&endianness, 1);
+    put(&reserved, 1);
+    put(&no_fields, sizeof(no_fields));
+    put(&record_size, sizeof(record_size));
+    std::size_t data_offset_pos = header.size();
+    std::uint64_t data_offset = 0;
+    put(&data_offset, sizeof(data_offset));
+    for (const auto& f : _fields) {
+        std::uint16_t name_length = static_cast<std::uint16_t>(f.name.size());
+        put(&f.type, 1);
+        put(&reserved, 1);
+        put(&name_length, sizeof(name_length));
+        put(&f.size, sizeof(f.size));
+        put(&f.offset, sizeof(f.offset));
+        put(f.name.data(), f.name.size());
+    }
+    const std::size_t align = detail::binary_data_alignment;
+    data_offset = (header.size() + align - 1) / align * align;
+    header.resize(data_offset, 0);
+    std::memcpy(header.data() + data_offset_pos, &data_offset,
+                sizeof(data_offset));
+    _file.write(header.data(), static_cast<std::streamsize>(header.size()));
+}
+
+/**\ingroup stream
+ * \brief Binary file handler for rows of TaggedTuple<Tags...>
+ *
+ * The field names are taken from `Tag::name`, if the tag has a static
+ * member `name` convertible to std::string, e.g.
+ * \code
+ * struct Position {
+ *     using type = double;
+ *     static constexpr const char* name = "position";
+ * };
+ * \endcode
+ */
+template <class... Tags>
+class TaggedBinaryFileHandler : public BinaryFileHandler<tag_t<Tags>...> {
+    using base = BinaryFileHandler<tag_t<Tags>...>;
+
+  public:
+    TaggedBinaryFileHandler()
+        : base(detail::tag_names<Tags...>(std::index_sequence_for<Tags...>{})) {
+    }
+    TaggedBinaryFileHandler(std::string filename, std::string file_extension)
+        : TaggedBinaryFileHandler() {
+        base::open(filename, file_extension);
+    }
+    using base::write;
+    void write(const TaggedTuple<Tags...>& row) {
+        base::write(static_cast<const tuple_t<Tags...>&>(row));
+    }
+    friend TaggedBinaryFileHandler& operator<<(
+        TaggedBinaryFileHandler& out, const TaggedTuple<Tags...>& row) {
+        out.write(row);
+        return out;
+    }
+};
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief Zero copy reader of binary record files
+ *
+ * The file is mapped into memory read only. Values are accessed in
+ * place, nothing is parsed except the header. Files written on a machine
+ * with different byte order are rejected.
+ */
+class BinaryFileReader {
+  private:
+    MappedFile _file;
+    std::vector<BinaryField> _fields;
+    std::size_t _record_size;
+    std::size_t _data_offset;
+    std::size_t _no_records;
+
+    void parse_header();
+    void check_field(std::size_t field, std::size_t size,
+                     BinaryType type) const {
+        if (field >= _fields.size()) {
+            throw std::out_of_range("Field index out of range");
+        }
+        if (_fields[field].size != size ||
+            (type != BinaryType::raw && _fields[field].type != type)) {
+            throw std::invalid_argument("Field " + _fields[field].name +
+                                        " has a different type");
+        }
+    }
+
+  public:
+    /// Maps the file `filename` and reads the header
+    explicit BinaryFileReader(const std::string& filename,
+                              AccessHint hint = AccessHint::normal);
+
+    /// Number of records
+    std::size_t size() const noexcept { return _no_records; }
+    /// Size of a record in bytes
+    std::size_t record_size() const noexcept { return _record_size; }
+    /// Field description
+    const std::vector<BinaryField>& fields() const noexcept { return _fields; }
+    /// Index of the field with the given name
+    std::size_t field_index(const std::string& name) const {
+        for (std::size_t i = 0; i != _fields.size(); ++i) {
+            if (_fields[i].name == name) return i;
+        }
+        throw std::out_of_range("No field " + name);
+    }
+    /// Pointer to the first record
+    const char* data() const noexcept { return _file.data() + _data_offset; }
+    /// Pointer to record `row`
+    const char* record(std::size_t row) const noexcept {
+        return data() + row * _record_size;
+    }
+
+    /**\brief Value of field `field` in record `row`
+     *
+     * Throws std::invalid_argument if T does not match the field.
+     */
+    template <class T>
+    T get(std::size_t row, std::size_t field) const {
+        check_field(field, sizeof(T), detail::binary_type<T>());
+        T value;
+        std::memcpy(&value, record(row) + _fields[field].offset, sizeof(T));
+        return value;
+    }
+
+    /// Record `row` as tuple
+    template <class... T>
+    std::tuple<T...> row(std::size_t row) const {
+        return row_impl<T...>(row, std::index_sequence_for<T...>{});
+    }
+
+    /// Copies field `field` of all records into `out`
+    template <class T, class OutputIt>
+    OutputIt column(std::size_t field, OutputIt out) const {
+        check_field(field, sizeof(T), detail::binary_type<T>());
+        const char* ptr = data() + _fields[field].offset;
+        for (std::size_t i = 0; i != _no_records; ++i, ++out) {
+            T value;
+            std::memcpy(&value, ptr, sizeof(T));
+            *out = value;
+            ptr += _record_size;
+        }
+        return out;
+    }
+
+  private:
+    template <class... T, std::size_t... I>
+    std::tuple<T...> row_impl(std::size_t r, std::index_sequence<I...>) const {
+        return std::tuple<T...>(get<T>(r, I)...);
+    }
+};
+
+inline BinaryFileReader::BinaryFileReader(const std::string& filename,
+                                          AccessHint hint)
+    : _file(filename, MappedFile::Mode::read, hint),
+      _record_size(0),
+      _data_offset(0),
+      _no_records(0) {
+    parse_header();
+}
+
+inline void BinaryFileReader::parse_header() {
+    std::size_t pos = 0;
+    auto take = [this, &pos](void* out, std::size_t size) {
+        if (pos + size > _file.size()) {
+            throw std::runtime_error("Binary file header truncated");
+        }
+        std::memcpy(out, _file.data() + pos, size);
+        pos += size;
+    };
+    char magic[sizeof(detail::binary_magic)];
+    take(magic, sizeof(magic));
+    if (std::memcmp(magic, detail::binary_magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a binary record file");
+    }
+    std::uint16_t version;
+    std::uint8_t endianness, reserved;
+    std::uint32_t no_fields, record_size;
+    std::uint64_t data_offset;
+    take(&version, sizeof(version));
+    take(&endianness, 1);
+    take(&reserved, 1);
+    if (endianness != detail::native_endianness()) {
+        throw std::runtime_error("Binary file has foreign byte order");
+    }
+    if (version != detail::binary_version) {
+        throw std::runtime_error("Unknown binary file version");
+    }
+    take(&no_fields, sizeof(no_fields));
+    take(&record_size, sizeof(record_size));
+    take(&data_offset, sizeof(data_offset));
+    for (std::uint32_t i = 0; i != no_fields; ++i) {
+        BinaryField field;
+        std::uint16_t name_length;
+        take(&field.type, 1);
+        take(&reserved, 1);
+        take(&name_length, sizeof(name_length));
+        take(&field.size, sizeof(field.size));
+        take(&field.offset, sizeof(field.offset));
+        field.name.resize(name_length);
+        take(&field.name[0], name_length);
+        _fields.push_back(field);
+    }
+    if (data_offset > _file.size() || record_size == 0) {
+        throw std::runtime_error("Binary file header corrupted");
+    }
+    for (const auto& field : _fields) {
+        if (field.offset > record_size ||
+            field.size > record_size - field.offset) {
+            throw std::runtime_error("Binary file header corrupted");
+        }
+    }
+    _record_size = record_size;
+    _data_offset = static_cast<std::size_t>(data_offset);
+    _no_records = (_file.size() - _data_offset) / _record_size;
+}
+
+}  // end namespace js
@@ -0,0 +1,731 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../algorithm/parallel_algorithm.hpp"
+#include "../thread/thread_pool.hpp"
+#include "basic_file_handler.hpp"
+#include "mapped_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#ifdef JS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace js {
+
+/**\ingroup stream
+ * \brief Compression of the blocks in compressed files
+ *
+ * `zlib` is only available if the library was found at configure time,
+ * which defines `JS_HAVE_ZLIB`. `lz` is a built in LZ77 codec in the
+ * style of LZ4, fast but with a lower ratio.
+ */
+enum class Codec : std::uint8_t { stored = 0, lz = 1, zlib = 2 };
+
+namespace detail {
+
+/// Magic at the start of compressed files
+constexpr char compressed_magic[8] = {'J', 'S', 'B', 'L', 'K', 'Z', '0', '1'};
+/// Magic at the end of compressed files, after the block index
+constexpr char compressed_index_magic[8] = {'J', 'S', 'B', 'L',
+                                            'K', 'I', 'D', 'X'};
+
+/// Best codec available
+constexpr Codec default_codec() {
+#ifdef JS_HAVE_ZLIB
+    return Codec::zlib;
+#else
+    return Codec::lz;
+#endif
+}
+
+/// Writes `x` to `p` as little endian, independent of the host
+template <class T>
+void store_le(char* p, T x) noexcept {
+    for (std::size_t i = 0; i != sizeof(T); ++i) {
+        p[i] = static_cast<char>(static_cast<std::uint8_t>(x >> (8 * i)));
+    }
+}
+
+/// Reads the little endian `T` at `p`
+template <class T>
+T load_le(const char* p) noexcept {
+    T x = 0;
+    for (std::size_t i = 0; i != sizeof(T); ++i) {
+        x |= static_cast<T>(static_cast<std::uint8_t>(p[i])) << (8 * i);
+    }
+    return x;
+}
+
+inline std::uint32_t read32(const unsigned char* p) {
+    std::uint32_t x;
+    std::memcpy(&x, p, sizeof(x));
+    return x;
+}
+
+/// Writes a length continuation of the lz format: 255 ... 255 rest
+inline void lz_put_length(std::vector<char>& out, std::size_t length) {
+    for (; length >= 255; length -= 255) out.push_back(char(255));
+    out.push_back(static_cast<char>(length));
+}
+
+/**\brief Compresses `size` bytes with the built in LZ codec
+ *
+ * Sequences of a token (literal length and match length in 4 bits
+ * each), optional length bytes, the literals, a 16 bit offset and
+ * optional match length bytes, as in LZ4. Matches of at least four bytes
+ * are found with a hash table of the last positions of 4 byte strings.
+ * The last sequence has literals only. Appends to `out`.
+ */
+inline void lz_compress(const char* data, std::size_t size,
+                        std::vector<char>& out) {
+    constexpr int hash_bits = 14;
+    constexpr std::size_t max_offset = 65535;
+    const auto* in = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* end = in + size;
+    const unsigned char* anchor = in;
+    const unsigned char* ip = in;
+    std::vector<std::uint32_t> table(std::size_t(1) << hash_bits, 0);
+    auto emit = [&](const unsigned char* match, std::size_t match_length) {
+        std::size_t literals = ip - anchor;
+        std::size_t ml = match ? match_length - 4 : 0;
+        out.push_back(static_cast<char>(
+            (std::min<std::size_t>(literals, 15) << 4) |
+            std::min<std::size_t>(ml, 15)));
+        if (literals >= 15) lz_put_length(out, literals - 15);
+        out.insert(out.end(), anchor, ip);
+        if (!match) return;
+        std::size_t offset = ip - match;
+        out.push_back(static_cast<char>(offset & 0xff));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (ml >= 15) lz_put_length(out, ml - 15);
+    };
+    while (size >= 4 && ip + 4 <= end) {
+        std::uint32_t sequence = read32(ip);
+        std::uint32_t h = (sequence * 2654435761u) >> (32 - hash_bits);
+        const unsigned char* ref = in + table[h];
+        table[h] = static_cast<std::uint32_t>(ip - in);
+        if (ref < ip && std::size_t(ip - ref) <= max_offset &&
+            read32(ref) == sequence) {
+            std::size_t length = 4;
+            while (ip + length < end && ref[length] == ip[length]) ++length;
+            emit(ref, length);
+            ip += length;
+            anchor = ip;
+        } else {
+            ++ip;
+        }
+    }
+    ip = end;
+    emit(nullptr, 0);
+}
+
+/// Decompresses the LZ codec, throws std::runtime_error if corrupted
+inline void lz_decompress(const char* data, std::size_t size, char* out,
+                          std::size_t out_size) {
+    const auto* ip = reinterpret_cast<const unsigned char*>(data);
+    const unsigned char* iend = ip + size;
+    auto* op = reinterpret_cast<unsigned char*>(out);
+    auto* const ostart = op;
+    auto* const oend = op + out_size;
+    auto corrupted = []() {
+        throw std::runtime_error("Compressed block corrupted");
+    };
+    auto get_length = [&](std::size_t length) {
+        if (length != 15) return length;
+        unsigned char b;
+        do {
+            if (ip == iend) corrupted();
+            b = *ip++;
+            length += b;
+        } while (b == 255);
+        return length;
+    };
+    while (ip < iend) {
+        unsigned token = *ip++;
+        std::size_t literals = get_length(token >> 4);
+        if (literals > std::size_t(iend - ip) ||
+            literals > std::size_t(oend - op)) {
+            corrupted();
+        }
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+        if (ip == iend) break;
+        if (iend - ip < 2) corrupted();
+        std::size_t offset = ip[0] | (std::size_t(ip[1]) << 8);
+        ip += 2;
+        std::size_t length = get_length(token & 15) + 4;
+        if (offset == 0 || offset > std::size_t(op - ostart) ||
+            length > std::size_t(oend - op)) {
+            corrupted();
+        }
+        const unsigned char* match = op - offset;
+        if (offset >= length) {
+            std::memcpy(op, match, length);
+            op += length;
+        } else {
+            // Overlapping match repeats the last `offset` bytes
+            for (std::size_t i = 0; i != length; ++i) *op++ = *match++;
+        }
+    }
+    if (op != oend) corrupted();
+}
+
+/**\brief Compresses a block, appends to `out` and returns the codec used
+ *
+ * Blocks that do not get smaller are stored.
+ */
+inline Codec compress_block(Codec codec, const char* data, std::size_t size,
+                            std::vector<char>& out) {
+    std::size_t start = out.size();
+    switch (codec) {
+        case Codec::lz:
+            lz_compress(data, size, out);
+            break;
+        case Codec::zlib: {
+#ifdef JS_HAVE_ZLIB
+            uLongf length = compressBound(static_cast<uLong>(size));
+            out.resize(start + length);
+            if (compress2(reinterpret_cast<Bytef*>(&out[start]), &length,
+                          reinterpret_cast<const Bytef*>(data),
+                          static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK) {
+                throw std::runtime_error("zlib compression failed");
+            }
+            out.resize(start + length);
+            break;
+#else
+            throw std::runtime_error("zlib is not available");
+#endif
+        }
+        case Codec::stored:
+            break;
+    }
+    if (codec == Codec::stored || out.size() - start >= size) {
+        out.resize(start);
+        out.insert(out.end(), data, data + size);
+        return Codec::stored;
+    }
+    return codec;
+}
+
+/// Decompresses a block into `out_size` bytes at `out`
+inline void decompress_block(Codec codec, const char* data, std::size_t size,
+                             char* out, std::size_t out_size) {
+    switch (codec) {
+        case Codec::stored:
+            if (size != out_size) {
+                throw std::runtime_error("Compressed block corrupted");
+            }
+            std::memcpy(out, data, size);
+            return;
+        case Codec::lz:
+            lz_decompress(data, size, out, out_size);
+            return;
+        case Codec::zlib: {
+#ifdef JS_HAVE_ZLIB
+            uLongf length = static_cast<uLongf>(out_size);
+            if (uncompress(reinterpret_cast<Bytef*>(out), &length,
+                           reinterpret_cast<const Bytef*>(data),
+                           static_cast<uLong>(size)) != Z_OK ||
+                length != out_size) {
+                throw std::runtime_error("Compressed block corrupted");
+            }
+            return;
+#else
+            throw std::runtime_error("File needs zlib, which is not available");
+#endif
+        }
+    }
+    throw std::runtime_error("Unknown codec of compressed block");
+}
+
+/// Position of a block in a compressed file
+struct BlockEntry {
+    std::uint64_t offset;
+    std::uint32_t compressed_size;
+    std::uint32_t size;
+    Codec codec;
+};
+
+/// Bytes of a block header and of an index entry
+constexpr std::size_t block_header_size = 12;
+constexpr std::size_t index_entry_size = 17;
+/// Bytes of the file header and trailer
+constexpr std::size_t compressed_header_size = 16;
+constexpr std::size_t compressed_trailer_size = 24;
+
+/**\ingroup stream
+ * \brief Stream buffer compressing full blocks on a thread pool
+ *
+ * The put area is the current block. Full blocks are compressed by pool
+ * tasks and written in order by the producing thread. At most two
+ * blocks per worker are in flight, so memory stays bounded.
+ */
+class CompressingStreamBuf : public std::streambuf {
+  private:
+    struct Job {
+        std::future<Codec> codec;
+        std::vector<char> raw;
+        std::vector<char> compressed;
+    };
+
+    std::size_t _block_size;
+    Codec _codec;
+    ThreadPool* _pool;
+    int _fd;
+    std::uint64_t _offset;
+    std::vector<char> _block;
+    std::deque<std::unique_ptr<Job>> _jobs;
+    std::vector<std::unique_ptr<Job>> _spare;
+    std::vector<BlockEntry> _index;
+
+    void write_all(const char* data, std::size_t size);
+    void submit();
+    void write_front();
+
+  protected:
+    int_type overflow(int_type c) override;
+    int sync() override { return 0; }
+
+  public:
+    CompressingStreamBuf(std::size_t block_size, Codec codec, ThreadPool& pool)
+        : _block_size(block_size > 0 ? block_size : 1),
+          _codec(codec),
+          _pool(&pool),
+          _fd(-1),
+          _offset(0) {}
+    CompressingStreamBuf(const CompressingStreamBuf&) = delete;
+    CompressingStreamBuf& operator=(const CompressingStreamBuf&) = delete;
+    ~CompressingStreamBuf() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /// Takes ownership of `fd` and writes the file header
+    void open(int fd);
+    /// Compresses and writes all buffered data
+    void flush();
+    /// Flushes, writes the block index and closes the file
+    void close();
+    bool is_open() const noexcept { return _fd != -1; }
+};
+
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief File handler writing a block compressed file
+ *
+ * Same usage as BasicFileHandler. The output is cut into blocks of
+ * `block_size` bytes, which are compressed independently by the workers
+ * of a thread pool, so compression scales with the number of cores.
+ *
+ * File layout, all numbers little endian:
+ *
+ * | Bytes        | Content                                          |
+ * |--------------|--------------------------------------------------|
+ * | 8            | magic `JSBLKZ01`                                 |
+ * | 4            | block size                                       |
+ * | 4            | reserved                                         |
+ * | per block    | codec (1), reserved (3), size (4), compressed    |
+ * |              | size (4), compressed data                        |
+ * | per block    | index: offset (8), compressed size (4), size (4),|
+ * |              | codec (1)                                        |
+ * | 8            | offset of the index                              |
+ * | 8            | number of blocks                                 |
+ * | 8            | magic `JSBLKIDX`                                 |
+ *
+ * The numbers are encoded byte by byte, so files are portable between
+ * hosts of any byte order. The index at the end makes the file
+ * seekable by block, see CompressedFileReader. Every block header
+ * repeats codec and sizes of the index, which the reader checks.
+ */
+class CompressedFileHandler {
+  private:
+    std::string _filename;
+    detail::CompressingStreamBuf _buffer;
+    std::ostream _file;
+    int _writing_attempts;
+
+  public:
+    /// Default block size
+    static constexpr std::size_t default_block_size = 1 << 20;
+
+    /**@name Constructors
+     */
+    ///@{
+    /// Opens no file
+    explicit CompressedFileHandler(
+        std::size_t block_size = default_block_size,
+        Codec codec = detail::default_codec(),
+        ThreadPool& pool = ThreadPool::global())
+        : _buffer(block_size, codec, pool),
+          _file(&_buffer),
+          _writing_attempts(-42) {}
+    /// Opens the first free file `filename.extension`, `filename-1...`
+    CompressedFileHandler(std::string filename, std::string file_extension,
+                          std::size_t block_size = default_block_size,
+                          Codec codec = detail::default_codec(),
+                          ThreadPool& pool = ThreadPool::global())
+        : CompressedFileHandler(block_size, codec, pool) {
+        open(filename, file_extension);
+    }
+    ~CompressedFileHandler() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+    ///@}
+
+    /**@name open and close
+     */
+    ///@{
+    void open(std::string filename, std::string file_extension) {
+        close();
+        int fd = detail::create_free_file(filename, file_extension,
+                                          _writing_attempts, _filename);
+        _file.clear();
+        _buffer.open(fd);
+    }
+    /// Compresses and writes buffered data, the last block may be short
+    void flush() { _buffer.flush(); }
+    /// Writes the remaining data and the block index
+    void close() {
+        _buffer.close();
+        _filename.clear();
+    }
+    ///@}
+
+    /// Set how many writing attempts will be made
+    void writingAttempts(int writing) noexcept { _writing_attempts = writing; }
+    /// Get Filename
+    std::string getFilename() const { return _filename; }
+
+    /// Write raw bytes
+    void write(const char* data, std::size_t size) {
+        _file.write(data, static_cast<std::streamsize>(size));
+    }
+
+    template <class T>
+    friend CompressedFileHandler& operator<<(CompressedFileHandler& out,
+                                             const T& t) {
+        out._file << t;
+        return out;
+    }
+};
+
+/**\ingroup stream
+ * \brief Random access reader of files of CompressedFileHandler
+ *
+ * The file is mapped into memory and the block index read at
+ * construction. Any byte range can be read by decompressing only the
+ * blocks it touches. `read_all` decompresses the blocks in parallel.
+ */
+class CompressedFileReader {
+  private:
+    MappedFile _file;
+    std::vector<detail::BlockEntry> _index;
+    /// Uncompressed offset of every block and the total size at the end
+    std::vector<std::uint64_t> _starts;
+
+    void parse_index();
+
+  public:
+    explicit CompressedFileReader(const std::string& filename)
+        : _file(filename, MappedFile::Mode::read, AccessHint::random) {
+        parse_index();
+    }
+
+    /// Uncompressed size
+    std::uint64_t size() const noexcept { return _starts.back(); }
+    /// Size of the file
+    std::uint64_t compressed_size() const noexcept { return _file.size(); }
+    std::size_t blocks() const noexcept { return _index.size(); }
+    /// Uncompressed offset of block `i`
+    std::uint64_t block_start(std::size_t i) const { return _starts.at(i); }
+    /// Uncompressed size of block `i`
+    std::size_t block_size(std::size_t i) const { return _index.at(i).size; }
+
+    /// Decompresses block `i` to `out`, which holds `block_size(i)` bytes
+    void read_block(std::size_t i, char* out) const {
+        const auto& entry = _index.at(i);
+        detail::decompress_block(
+            entry.codec,
+            _file.data() + entry.offset + detail::block_header_size,
+            entry.compressed_size, out, entry.size);
+    }
+
+    /// Reads `size` bytes from uncompressed position `offset` to `out`
+    void read(std::uint64_t offset, std::size_t size, char* out) const;
+
+    /// Decompresses the whole file to `out` on the workers of `pool`
+    void read_all(char* out, ThreadPool& pool = ThreadPool::global()) const {
+        auto chunk = [this, out](std::size_t start, std::size_t stop) {
+            for (std::size_t i = start; i != stop; ++i) {
+                read_block(i, out + _starts[i]);
+            }
+        };
+        detail::for_each_chunk(_index.size(), pool, dynamic_schedule(1),
+                               chunk);
+    }
+    /// Whole file as string
+    std::string str(ThreadPool& pool = ThreadPool::global()) const {
+        std::string content(static_cast<std::size_t>(size()), '\0');
+        if (!content.empty()) read_all(&content[0], pool);
+        return content;
+    }
+};
+
+/*
+ * Functions implementations
+ */
+
+namespace detail {
+
+inline void CompressingStreamBuf::write_all(const char* data,
+                                            std::size_t size) {
+    _offset += size;
+    while (size > 0) {
+        ssize_t n = ::write(_fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Writing file failed: ") +
+                                     std::strerror(errno));
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+inline void CompressingStreamBuf::open(int fd) {
+    close();
+    _fd = fd;
+    _offset = 0;
+    _index.clear();
+    char header[compressed_header_size] = {};
+    std::memcpy(header, compressed_magic, sizeof(compressed_magic));
+    store_le(header + 8, static_cast<std::uint32_t>(_block_size));
+    write_all(header, sizeof(header));
+    _block.resize(_block_size);
+    setp(_block.data(), _block.data() + _block.size());
+}
+
+inline void CompressingStreamBuf::submit() {
+    std::size_t size = pptr() - pbase();
+    if (size == 0) return;
+    std::unique_ptr<Job> job;
+    if (_spare.empty()) {
+        job.reset(new Job);
+    } else {
+        job = std::move(_spare.back());
+        _spare.pop_back();
+    }
+    // The full block goes to the job, the job's old buffer is reused
+    _block.resize(size);
+    std::swap(job->raw, _block);
+    _block.resize(_block_size);
+    setp(_block.data(), _block.data() + _block.size());
+    Job* j = job.get();
+    Codec codec = _codec;
+    j->codec = _pool->submit([j, codec]() {
+        j->compressed.clear();
+        return compress_block(codec, j->raw.data(), j->raw.size(),
+                              j->compressed);
+    });
+    _jobs.push_back(std::move(job));
+    while (_jobs.size() > 2 * _pool->size() ||
+           (!_jobs.empty() &&
+            _jobs.front()->codec.wait_for(std::chrono::seconds(0)) ==
+                std::future_status::ready)) {
+        write_front();
+    }
+}
+
+inline void CompressingStreamBuf::write_front() {
+    std::unique_ptr<Job> job = std::move(_jobs.front());
+    _jobs.pop_front();
+    std::future<Codec>& result = job->codec;
+    _pool->wait_until([&result]() {
+        return result.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+    });
+    Codec codec = result.get();
+    BlockEntry entry{_offset,
+                     static_cast<std::uint32_t>(job->compressed.size()),
+                     static_cast<std::uint32_t>(job->raw.size()), codec};
+    char header[block_header_size] = {};
+    header[0] = static_cast<char>(codec);
+    store_le(header + 4, entry.size);
+    store_le(header + 8, entry.compressed_size);
+    write_all(header, sizeof(header));
+    write_all(job->compressed.data(), job->compressed.size());
+    _index.push_back(entry);
+    _spare.push_back(std::move(job));
+}
+
+inline CompressingStreamBuf::int_type CompressingStreamBuf::overflow(
+    int_type c) {
+    if (_fd == -1) return traits_type::eof();
+    try {
+        submit();
+    } catch (...) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+inline void CompressingStreamBuf::flush() {
+    if (_fd == -1) return;
+    submit();
+    while (!_jobs.empty()) write_front();
+}
+
+inline void CompressingStreamBuf::close() {
+    if (_fd == -1) return;
+    std::string error;
+    try {
+        flush();
+        std::uint64_t index_offset = _offset;
+        std::vector<char> index;
+        for (const auto& entry : _index) {
+            char bytes[index_entry_size];
+            store_le(bytes, entry.offset);
+            store_le(bytes + 8, entry.compressed_size);
+            store_le(bytes + 12, entry.size);
+            bytes[16] = static_cast<char>(entry.codec);
+            index.insert(index.end(), bytes, bytes + sizeof(bytes));
+        }
+        std::uint64_t no_blocks = _index.size();
+        char trailer[compressed_trailer_size];
+        store_le(trailer, index_offset);
+        store_le(trailer + 8, no_blocks);
+        std::memcpy(trailer + 16, compressed_index_magic, 8);
+        index.insert(index.end(), trailer, trailer + sizeof(trailer));
+        write_all(index.data(), index.size());
+    } catch (std::exception& e) {
+        error = e.what();
+        // Wait for running tasks, they reference the jobs
+        for (auto& job : _jobs) job->codec.wait();
+        _jobs.clear();
+    }
+    if (::close(_fd) != 0 && error.empty()) {
+        error = std::string("Closing file failed: ") + std::strerror(errno);
+    }
+    _fd = -1;
+    setp(nullptr, nullptr);
+    if (!error.empty()) throw std::runtime_error(error);
+}
+
+}  // end namespace detail
+
+inline void CompressedFileReader::parse_index() {
+    const char* data = _file.data();
+    std::size_t size = _file.size();
+    if (size < detail::compressed_header_size +
+                   detail::compressed_trailer_size ||
+        std::memcmp(data, detail::compressed_magic,
+                    sizeof(detail::compressed_magic)) != 0) {
+        throw std::runtime_error("Not a compressed file: " +
+                                 _file.filename());
+    }
+    const char* trailer = data + size - detail::compressed_trailer_size;
+    auto index_offset = detail::load_le<std::uint64_t>(trailer);
+    auto no_blocks = detail::load_le<std::uint64_t>(trailer + 8);
+    if (std::memcmp(trailer + 16, detail::compressed_index_magic, 8) != 0 ||
+        index_offset > size - detail::compressed_trailer_size ||
+        no_blocks != (size - detail::compressed_trailer_size - index_offset) /
+                         detail::index_entry_size) {
+        throw std::runtime_error("Compressed file has no valid index: " +
+                                 _file.filename());
+    }
+    _starts.push_back(0);
+    const char* entry = data + index_offset;
+    for (std::uint64_t i = 0; i != no_blocks; ++i) {
+        detail::BlockEntry block;
+        block.offset = detail::load_le<std::uint64_t>(entry);
+        block.compressed_size = detail::load_le<std::uint32_t>(entry + 8);
+        block.size = detail::load_le<std::uint32_t>(entry + 12);
+        block.codec = static_cast<Codec>(entry[16]);
+        entry += detail::index_entry_size;
+        const char* header = data + block.offset;
+        if (block.offset < detail::compressed_header_size ||
+            block.offset > index_offset ||
+            detail::block_header_size + block.compressed_size >
+                index_offset - block.offset ||
+            header[0] != static_cast<char>(block.codec) ||
+            detail::load_le<std::uint32_t>(header + 4) != block.size ||
+            detail::load_le<std::uint32_t>(header + 8) !=
+                block.compressed_size) {
+            throw std::runtime_error("Compressed file index corrupted: " +
+                                     _file.filename());
+        }
+        _index.push_back(block);
+        _starts.push_back(_starts.back() + block.size);
+    }
+}
+
+inline void CompressedFileReader::read(std::uint64_t offset, std::size_t size,
+                                       char* out) const {
+    if (offset > this->size() || size > this->size() - offset) {
+        throw std::out_of_range("Read beyond end of compressed file");
+    }
+    // First block containing offset
+    std::size_t i = std::upper_bound(_starts.begin(), _starts.end(), offset) -
+                    _starts.begin() - 1;
+    std::vector<char> block;
+    while (size > 0) {
+        std::size_t skip = static_cast<std::size_t>(offset - _starts[i]);
+        std::size_t n = std::min(size, block_size(i) - skip);
+        if (skip == 0 && n == block_size(i)) {
+            read_block(i, out);
+        } else {
+            block.resize(block_size(i));
+            read_block(i, block.data());
+            std::memcpy(out, block.data() + skip, n);
+        }
+        out += n;
+        offset += n;
+        size -= n;
+        ++i;
+    }
+}
+
+}  // end namespace js
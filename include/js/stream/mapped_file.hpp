@@ -0,0 +1,392 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+namespace js {
+
+/**\ingroup stream
+ * \brief Non owning view of `size()` contiguous objects
+ */
+template <class T>
+class Span {
+  private:
+    T* _data;
+    std::size_t _size;
+
+  public:
+    using value_type = std::remove_cv_t<T>;
+    using iterator = T*;
+
+    Span() noexcept : _data(nullptr), _size(0) {}
+    Span(T* data, std::size_t size) noexcept : _data(data), _size(size) {}
+    /// Read only view of a mutable span
+    template <class U, class = std::enable_if_t<
+                           std::is_same<const U, T>::value>>
+    Span(const Span<U>& other) noexcept
+        : _data(other.data()), _size(other.size()) {}
+
+    T* data() const noexcept { return _data; }
+    std::size_t size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+    T& operator[](std::size_t i) const noexcept { return _data[i]; }
+    iterator begin() const noexcept { return _data; }
+    iterator end() const noexcept { return _data + _size; }
+    T& front() const noexcept { return _data[0]; }
+    T& back() const noexcept { return _data[_size - 1]; }
+
+    /// View of the elements [offset, offset + count)
+    Span subspan(std::size_t offset,
+                 std::size_t count = std::size_t(-1)) const noexcept {
+        if (offset > _size) offset = _size;
+        if (count > _size - offset) count = _size - offset;
+        return Span(_data + offset, count);
+    }
+};
+
+/**\ingroup stream
+ * \brief Access pattern hints for MappedFile, see `madvise(2)`
+ */
+enum class AccessHint { normal, sequential, random, will_need, dont_need };
+
+/**\ingroup stream
+ * \brief File mapped into memory
+ *
+ * In `read` mode the file is mapped read only. Reading goes straight to
+ * the page cache, there are no intermediate buffers and no copies.
+ * `span<T>()` views the bytes as objects of a trivially copyable type.
+ *
+ * In `read_write` mode the file is created if it does not exist. Its
+ * size can be changed with `resize()` or `append()`. Growing reserves
+ * space geometrically with `ftruncate` and remaps the file, so all
+ * pointers and spans are invalidated. The file is truncated to `size()`
+ * by `sync()` and `close()`, only `sync()` waits for the disk.
+ *
+ * Errors throw std::runtime_error, invalid views std::out_of_range or
+ * std::invalid_argument. The destructor ignores errors.
+ */
+class MappedFile {
+  public:
+    enum class Mode { read, read_write };
+
+  private:
+    std::string _filename;
+    int _fd;
+    Mode _mode;
+    char* _data;
+    /// Used bytes
+    std::size_t _size;
+    /// Mapped bytes, equal to the file size
+    std::size_t _capacity;
+
+    /// Maps the first `capacity` bytes of the file, nullptr on failure
+    char* map_bytes(std::size_t capacity) const noexcept;
+    void map(std::size_t capacity);
+    void unmap() noexcept;
+    /// Shrinks the file to the used bytes
+    void truncate();
+    void check_writable() const {
+        if (_mode != Mode::read_write) {
+            throw std::runtime_error("File " + _filename +
+                                     " is mapped read only");
+        }
+    }
+    [[noreturn]] void fail(const std::string& what) const {
+        throw std::runtime_error(what + " " + _filename + ": " +
+                                 std::strerror(errno));
+    }
+    template <class T>
+    void check_view(std::size_t offset, std::size_t count) const {
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Span of mapped file needs trivially copyable type");
+        if (offset > _size || count > (_size - offset) / sizeof(T)) {
+            throw std::out_of_range("View exceeds mapped file " + _filename);
+        }
+        if ((reinterpret_cast<std::uintptr_t>(_data) + offset) % alignof(T)) {
+            throw std::invalid_argument("View of mapped file " + _filename +
+                                        " is misaligned");
+        }
+    }
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    /// No file open
+    MappedFile() noexcept
+        : _fd(-1), _mode(Mode::read), _data(nullptr), _size(0), _capacity(0) {}
+    /// Maps `filename`, see `open()`
+    explicit MappedFile(const std::string& filename, Mode mode = Mode::read,
+                        AccessHint hint = AccessHint::normal)
+        : MappedFile() {
+        open(filename, mode, hint);
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept : MappedFile() { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        MappedFile tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+    ~MappedFile();
+    ///@}
+
+    /**@name open and close
+     */
+    ///@{
+    /// Maps the whole file, closes the current one first
+    void open(const std::string& filename, Mode mode = Mode::read,
+              AccessHint hint = AccessHint::normal);
+    /**\brief Truncates the file to `size()` and unmaps it
+     *
+     * Changes stay in the page cache and are written by the kernel, use
+     * `sync()` before to wait for the disk.
+     */
+    void close();
+    /// Writes changes to the disk and truncates the file to `size()`
+    void sync();
+    bool is_open() const noexcept { return _fd != -1; }
+    ///@}
+
+    /// Hint the kernel about the access pattern of [offset, offset + length)
+    void advise(AccessHint hint, std::size_t offset = 0,
+                std::size_t length = std::size_t(-1));
+
+    /**@name Size
+     */
+    ///@{
+    std::size_t size() const noexcept { return _size; }
+    bool empty() const noexcept { return _size == 0; }
+    std::size_t capacity() const noexcept { return _capacity; }
+    /// Grows the file to at least `capacity` bytes
+    void reserve(std::size_t capacity);
+    /// Sets the size, new bytes are zero
+    void resize(std::size_t size);
+    /// Appends `bytes` bytes, returns the offset where they start
+    std::size_t append(const void* data, std::size_t bytes);
+    ///@}
+
+    /**@name Data access
+     */
+    ///@{
+    const std::string& filename() const noexcept { return _filename; }
+    const char* data() const noexcept { return _data; }
+    /// Mutable data, throws in read mode
+    char* writable_data() {
+        check_writable();
+        return _data;
+    }
+
+    /**\brief View of `count` objects of type T starting at byte `offset`
+     *
+     * By default the view extends to the end of the file. Throws if the
+     * view exceeds the file or is not aligned for T.
+     */
+    template <class T>
+    Span<const T> span(std::size_t offset = 0,
+                       std::size_t count = std::size_t(-1)) const {
+        if (count == std::size_t(-1) && offset <= _size) {
+            count = (_size - offset) / sizeof(T);
+        }
+        check_view<T>(offset, count);
+        return Span<const T>(reinterpret_cast<const T*>(_data + offset),
+                             count);
+    }
+    /// Mutable view, throws in read mode
+    template <class T>
+    Span<T> writable_span(std::size_t offset = 0,
+                          std::size_t count = std::size_t(-1)) {
+        check_writable();
+        if (count == std::size_t(-1) && offset <= _size) {
+            count = (_size - offset) / sizeof(T);
+        }
+        check_view<T>(offset, count);
+        return Span<T>(reinterpret_cast<T*>(_data + offset), count);
+    }
+    ///@}
+
+    void swap(MappedFile& other) noexcept {
+        std::swap(_filename, other._filename);
+        std::swap(_fd, other._fd);
+        std::swap(_mode, other._mode);
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+        std::swap(_capacity, other._capacity);
+    }
+};
+
+/*
+ * Functions implementations
+ */
+
+inline MappedFile::~MappedFile() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+inline char* MappedFile::map_bytes(std::size_t capacity) const noexcept {
+    int prot = PROT_READ | (_mode == Mode::read_write ? PROT_WRITE : 0);
+    void* map = ::mmap(nullptr, capacity, prot, MAP_SHARED, _fd, 0);
+    return map == MAP_FAILED ? nullptr : static_cast<char*>(map);
+}
+
+inline void MappedFile::map(std::size_t capacity) {
+    _data = capacity == 0 ? nullptr : map_bytes(capacity);
+    _capacity = _data ? capacity : 0;
+    if (capacity != 0 && !_data) fail("Could not map file");
+}
+
+inline void MappedFile::unmap() noexcept {
+    if (_data) ::munmap(_data, _capacity);
+    _data = nullptr;
+    _capacity = 0;
+}
+
+inline void MappedFile::open(const std::string& filename, Mode mode,
+                             AccessHint hint) {
+    close();
+    _filename = filename;
+    _mode = mode;
+    int flags = (mode == Mode::read) ? O_RDONLY : (O_RDWR | O_CREAT);
+    _fd = ::open(filename.c_str(), flags | O_CLOEXEC, 0644);
+    if (_fd == -1) fail("Could not open file");
+    struct stat info;
+    try {
+        if (::fstat(_fd, &info) != 0) fail("Could not stat file");
+        map(static_cast<std::size_t>(info.st_size));
+    } catch (...) {
+        ::close(_fd);
+        _fd = -1;
+        throw;
+    }
+    _size = _capacity;
+    if (hint != AccessHint::normal) advise(hint);
+}
+
+inline void MappedFile::sync() {
+    if (_fd == -1 || _mode != Mode::read_write) return;
+    if (_data && ::msync(_data, _capacity, MS_SYNC) != 0) {
+        fail("Could not sync file");
+    }
+    truncate();
+}
+
+inline void MappedFile::truncate() {
+    if (_size != _capacity) {
+        unmap();
+        if (::ftruncate(_fd, static_cast<off_t>(_size)) != 0) {
+            fail("Could not truncate file");
+        }
+        map(_size);
+    }
+}
+
+inline void MappedFile::close() {
+    if (_fd == -1) return;
+    int error = 0;
+    try {
+        if (_mode == Mode::read_write) truncate();
+    } catch (std::runtime_error&) {
+        error = errno;
+    }
+    unmap();
+    ::close(_fd);
+    _fd = -1;
+    _size = 0;
+    if (error != 0) {
+        errno = error;
+        fail("Could not write file");
+    }
+}
+
+inline void MappedFile::advise(AccessHint hint, std::size_t offset,
+                               std::size_t length) {
+    if (!_data || offset >= _capacity) return;
+    // madvise needs a page aligned start
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t start = offset / page * page;
+    length = std::min(length, _capacity - offset) + (offset - start);
+    int advice = MADV_NORMAL;
+    switch (hint) {
+        case AccessHint::normal: advice = MADV_NORMAL; break;
+        case AccessHint::sequential: advice = MADV_SEQUENTIAL; break;
+        case AccessHint::random: advice = MADV_RANDOM; break;
+        case AccessHint::will_need: advice = MADV_WILLNEED; break;
+        case AccessHint::dont_need: advice = MADV_DONTNEED; break;
+    }
+    // Only a hint, errors are ignored
+    ::madvise(_data + start, length, advice);
+}
+
+inline void MappedFile::reserve(std::size_t capacity) {
+    check_writable();
+    if (capacity <= _capacity) return;
+    // The old mapping stays valid while the file grows and is only
+    // replaced once the new one exists, so on errors nothing changes
+    if (::ftruncate(_fd, static_cast<off_t>(capacity)) != 0) {
+        fail("Could not grow file");
+    }
+    char* data = map_bytes(capacity);
+    if (!data) {
+        int error = errno;
+        // Best effort to restore the file size, the old mapping is intact
+        int restored = ::ftruncate(_fd, static_cast<off_t>(_capacity));
+        (void)restored;
+        errno = error;
+        fail("Could not map file");
+    }
+    unmap();
+    _data = data;
+    _capacity = capacity;
+}
+
+inline void MappedFile::resize(std::size_t size) {
+    check_writable();
+    // Bytes between size and capacity may hold data of an earlier resize,
+    // bytes added by ftruncate are zero
+    std::size_t dirty_end = std::min(size, _capacity);
+    if (dirty_end > _size) std::memset(_data + _size, 0, dirty_end - _size);
+    if (size > _capacity) reserve(std::max(size, 2 * _capacity));
+    _size = size;
+}
+
+inline std::size_t MappedFile::append(const void* data, std::size_t bytes) {
+    std::size_t offset = _size;
+    resize(_size + bytes);
+    if (bytes > 0) std::memcpy(_data + offset, data, bytes);
+    return offset;
+}
+
+}  // end namespace js
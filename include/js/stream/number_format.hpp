@@ -0,0 +1,579 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ios>
+#include <limits>
+#include <string>
+#include <type_traits>
+
+namespace js {
+
+/**\ingroup stream
+ * \brief Numbers formatted by `format_number` instead of streams
+ *
+ * Integers and float and double. Character types and bool keep the
+ * stream formatting, as does long double, which has no shortest
+ * round trip algorithm here.
+ */
+template <class T>
+struct is_fast_formatted
+    : std::integral_constant<
+          bool, (std::is_integral<T>::value &&
+                 !std::is_same<T, bool>::value &&
+                 !std::is_same<T, char>::value &&
+                 !std::is_same<T, signed char>::value &&
+                 !std::is_same<T, unsigned char>::value &&
+                 !std::is_same<T, wchar_t>::value &&
+                 !std::is_same<T, char16_t>::value &&
+                 !std::is_same<T, char32_t>::value) ||
+                    std::is_same<T, float>::value ||
+                    std::is_same<T, double>::value> {};
+
+/// Buffer size needed by `format_number`
+constexpr std::size_t max_number_size = 32;
+
+namespace detail {
+
+/**\brief True if `stream` has the default format state
+ *
+ * File handlers only take the fast path if no manipulator changed the
+ * flags, the precision or the width, so manipulators keep working.
+ */
+inline bool default_number_format(const std::ios_base& stream) noexcept {
+    return stream.flags() == (std::ios_base::skipws | std::ios_base::dec) &&
+           stream.precision() == 6 && stream.width() == 0;
+}
+
+constexpr char digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+inline int count_digits(std::uint64_t x) noexcept {
+    int n = 1;
+    while (true) {
+        if (x < 10) return n;
+        if (x < 100) return n + 1;
+        if (x < 1000) return n + 2;
+        if (x < 10000) return n + 3;
+        x /= 10000;
+        n += 4;
+    }
+}
+
+/// Writes the decimal digits of `x`, two at a time, and returns the end
+inline char* format_uint(char* out, std::uint64_t x) noexcept {
+    char* end = out + count_digits(x);
+    char* p = end;
+    while (x >= 100) {
+        std::size_t i = static_cast<std::size_t>(x % 100) * 2;
+        x /= 100;
+        p -= 2;
+        std::memcpy(p, digit_pairs + i, 2);
+    }
+    if (x >= 10) {
+        std::memcpy(p - 2, digit_pairs + x * 2, 2);
+    } else {
+        p[-1] = static_cast<char>('0' + x);
+    }
+    return end;
+}
+
+/// 64 bit floating point number `f * 2^e` of the Grisu algorithm
+struct DiyFp {
+    std::uint64_t f;
+    int e;
+
+    DiyFp operator-(const DiyFp& rhs) const noexcept {
+        return {f - rhs.f, e};
+    }
+    /// Product rounded to the upper 64 bits
+    DiyFp operator*(const DiyFp& rhs) const noexcept {
+        const std::uint64_t m32 = 0xffffffffu;
+        std::uint64_t a = f >> 32, b = f & m32;
+        std::uint64_t c = rhs.f >> 32, d = rhs.f & m32;
+        std::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+        std::uint64_t tmp = (bd >> 32) + (ad & m32) + (bc & m32);
+        tmp += std::uint64_t(1) << 31;
+        return {ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64};
+    }
+    DiyFp normalize() const noexcept {
+        DiyFp x = *this;
+        while (!(x.f & (std::uint64_t(1) << 63))) {
+            x.f <<= 1;
+            --x.e;
+        }
+        return x;
+    }
+};
+
+/// Normalized `10^k` for `k = -348, -340, ..., 340`
+inline DiyFp cached_power(int index) noexcept {
+    static constexpr std::uint64_t f[] = {
+        0xfa8fd5a0081c0288, 0xbaaee17fa23ebf76, 0x8b16fb203055ac76,
+        0xcf42894a5dce35ea, 0x9a6bb0aa55653b2d, 0xe61acf033d1a45df,
+        0xab70fe17c79ac6ca, 0xff77b1fcbebcdc4f, 0xbe5691ef416bd60c,
+        0x8dd01fad907ffc3c, 0xd3515c2831559a83, 0x9d71ac8fada6c9b5,
+        0xea9c227723ee8bcb, 0xaecc49914078536d, 0x823c12795db6ce57,
+        0xc21094364dfb5637, 0x9096ea6f3848984f, 0xd77485cb25823ac7,
+        0xa086cfcd97bf97f4, 0xef340a98172aace5, 0xb23867fb2a35b28e,
+        0x84c8d4dfd2c63f3b, 0xc5dd44271ad3cdba, 0x936b9fcebb25c996,
+        0xdbac6c247d62a584, 0xa3ab66580d5fdaf6, 0xf3e2f893dec3f126,
+        0xb5b5ada8aaff80b8, 0x87625f056c7c4a8b, 0xc9bcff6034c13053,
+        0x964e858c91ba2655, 0xdff9772470297ebd, 0xa6dfbd9fb8e5b88f,
+        0xf8a95fcf88747d94, 0xb94470938fa89bcf, 0x8a08f0f8bf0f156b,
+        0xcdb02555653131b6, 0x993fe2c6d07b7fac, 0xe45c10c42a2b3b06,
+        0xaa242499697392d3, 0xfd87b5f28300ca0e, 0xbce5086492111aeb,
+        0x8cbccc096f5088cc, 0xd1b71758e219652c, 0x9c40000000000000,
+        0xe8d4a51000000000, 0xad78ebc5ac620000, 0x813f3978f8940984,
+        0xc097ce7bc90715b3, 0x8f7e32ce7bea5c70, 0xd5d238a4abe98068,
+        0x9f4f2726179a2245, 0xed63a231d4c4fb27, 0xb0de65388cc8ada8,
+        0x83c7088e1aab65db, 0xc45d1df942711d9a, 0x924d692ca61be758,
+        0xda01ee641a708dea, 0xa26da3999aef774a, 0xf209787bb47d6b85,
+        0xb454e4a179dd1877, 0x865b86925b9bc5c2, 0xc83553c5c8965d3d,
+        0x952ab45cfa97a0b3, 0xde469fbd99a05fe3, 0xa59bc234db398c25,
+        0xf6c69a72a3989f5c, 0xb7dcbf5354e9bece, 0x88fcf317f22241e2,
+        0xcc20ce9bd35c78a5, 0x98165af37b2153df, 0xe2a0b5dc971f303a,
+        0xa8d9d1535ce3b396, 0xfb9b7cd9a4a7443c, 0xbb764c4ca7a44410,
+        0x8bab8eefb6409c1a, 0xd01fef10a657842c, 0x9b10a4e5e9913129,
+        0xe7109bfba19c0c9d, 0xac2820d9623bf429, 0x80444b5e7aa7cf85,
+        0xbf21e44003acdd2d, 0x8e679c2f5e44ff8f, 0xd433179d9c8cb841,
+        0x9e19db92b4e31ba9, 0xeb96bf6ebadf77d9, 0xaf87023b9bf0ee6b
+    };
+    static constexpr std::int16_t e[] = {
+        -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+        -954, -927, -901, -874, -847, -821, -794, -768, -741, -715, -688, -661,
+        -635, -608, -582, -555, -529, -502, -475, -449, -422, -396, -369, -343,
+        -316, -289, -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3,
+        30, 56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348, 375, 402,
+        428, 455, 481, 508, 534, 561, 588, 614, 641, 667, 694, 720, 747, 774,
+        800, 827, 853, 880, 907, 933, 960, 986, 1013, 1039, 1066
+    };
+    return {f[index], e[index]};
+}
+
+/// Cached power `c = 10^-K` that brings `w * c` to exponents [-60, -32]
+inline DiyFp cached_power_for(int e, int& K) noexcept {
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0) ++k;
+    int index = (k >> 3) + 1;
+    K = -(-348 + index * 8);
+    return cached_power(index);
+}
+
+/// Moves the last digit towards `w` while it stays in the interval
+inline void grisu_round(char* digits, int length, std::uint64_t delta,
+                        std::uint64_t rest, std::uint64_t ten_kappa,
+                        std::uint64_t wp_w) noexcept {
+    while (rest < wp_w && delta - rest >= ten_kappa &&
+           (rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w)) {
+        --digits[length - 1];
+        rest += ten_kappa;
+    }
+}
+
+/// Shortest digits in `(Mp - delta, Mp)`, the Grisu2 digit generation
+inline void grisu_digits(const DiyFp& W, const DiyFp& Mp, std::uint64_t delta,
+                         char* digits, int& length, int& K) noexcept {
+    static constexpr std::uint64_t pow10[] = {1u,
+                                              10u,
+                                              100u,
+                                              1000u,
+                                              10000u,
+                                              100000u,
+                                              1000000u,
+                                              10000000u,
+                                              100000000u,
+                                              1000000000u,
+                                              10000000000u,
+                                              100000000000u,
+                                              1000000000000u,
+                                              10000000000000u,
+                                              100000000000000u,
+                                              1000000000000000u,
+                                              10000000000000000u,
+                                              100000000000000000u,
+                                              1000000000000000000u,
+                                              10000000000000000000u};
+    const DiyFp one{std::uint64_t(1) << -Mp.e, Mp.e};
+    const DiyFp wp_w = Mp - W;
+    std::uint32_t p1 = static_cast<std::uint32_t>(Mp.f >> -one.e);
+    std::uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = count_digits(p1);
+    length = 0;
+    // Integral part
+    while (kappa > 0) {
+        std::uint32_t divisor = static_cast<std::uint32_t>(pow10[kappa - 1]);
+        std::uint32_t d = p1 / divisor;
+        p1 %= divisor;
+        if (d || length) digits[length++] = static_cast<char>('0' + d);
+        --kappa;
+        std::uint64_t rest = (static_cast<std::uint64_t>(p1) << -one.e) + p2;
+        if (rest <= delta) {
+            K += kappa;
+            grisu_round(digits, length, delta, rest, pow10[kappa] << -one.e,
+                        wp_w.f);
+            return;
+        }
+    }
+    // Fractional part
+    while (true) {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if (d || length) digits[length++] = static_cast<char>('0' + d);
+        p2 &= one.f - 1;
+        --kappa;
+        if (p2 < delta) {
+            K += kappa;
+            int index = -kappa;
+            grisu_round(digits, length, delta, p2, one.f,
+                        wp_w.f * (index < 20 ? pow10[index] : 0));
+            return;
+        }
+    }
+}
+
+/**\brief Grisu2 of Loitsch, "Printing floating-point numbers quickly
+ * and accurately with integers", PLDI 2010
+ *
+ * Writes at most 17 digits with `value = digits * 10^K`. The digits
+ * always read back as `value` and are the shortest such digits in
+ * almost all cases. `value` must be finite and positive.
+ */
+template <class T>
+void grisu2(T value, char* digits, int& length, int& K) noexcept {
+    using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t,
+                                    std::uint32_t>;
+    constexpr int significand_bits = std::numeric_limits<T>::digits - 1;
+    constexpr int exponent_bits = sizeof(T) * 8 - 1 - significand_bits;
+    constexpr int bias =
+        std::numeric_limits<T>::max_exponent - 1 + significand_bits;
+    constexpr std::uint64_t hidden = std::uint64_t(1) << significand_bits;
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    std::uint64_t significand = bits & (hidden - 1);
+    int biased = static_cast<int>((bits >> significand_bits) &
+                                  ((Bits(1) << exponent_bits) - 1));
+    DiyFp v = (biased != 0) ? DiyFp{significand + hidden, biased - bias}
+                            : DiyFp{significand, 1 - bias};
+
+    // Boundaries halfway to the neighbouring floating point numbers
+    DiyFp plus = DiyFp{(v.f << 1) + 1, v.e - 1}.normalize();
+    DiyFp minus = (v.f == hidden) ? DiyFp{(v.f << 2) - 1, v.e - 2}
+                                  : DiyFp{(v.f << 1) - 1, v.e - 1};
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+
+    const DiyFp c_mk = cached_power_for(plus.e, K);
+    const DiyFp W = v.normalize() * c_mk;
+    DiyFp Wp = plus * c_mk;
+    DiyFp Wm = minus * c_mk;
+    ++Wm.f;
+    --Wp.f;
+    grisu_digits(W, Wp, Wp.f - Wm.f, digits, length, K);
+}
+
+/// Writes `e+XX` or `e-XX` with at least two digits, as printf
+inline char* format_exponent(char* out, int exponent) noexcept {
+    *out++ = 'e';
+    *out++ = exponent < 0 ? '-' : '+';
+    unsigned x = static_cast<unsigned>(exponent < 0 ? -exponent : exponent);
+    if (x < 10) *out++ = '0';
+    return format_uint(out, x);
+}
+
+/**\brief Places `digits * 10^K` like `%.17g`
+ *
+ * Fixed notation for decimal exponents from -4 to 16, scientific
+ * otherwise. No trailing zeros after the point and no point for
+ * integers.
+ */
+inline char* format_decimal(char* out, const char* digits, int length,
+                            int K) noexcept {
+    int exponent = length + K - 1;
+    if (exponent < -4 || exponent >= 17) {
+        *out++ = digits[0];
+        if (length > 1) {
+            *out++ = '.';
+            std::memcpy(out, digits + 1, length - 1);
+            out += length - 1;
+        }
+        return format_exponent(out, exponent);
+    }
+    if (K >= 0) {
+        std::memcpy(out, digits, length);
+        out += length;
+        std::memset(out, '0', K);
+        return out + K;
+    }
+    if (exponent >= 0) {
+        std::memcpy(out, digits, exponent + 1);
+        out += exponent + 1;
+        *out++ = '.';
+        std::memcpy(out, digits + exponent + 1, length - exponent - 1);
+        return out + length - exponent - 1;
+    }
+    *out++ = '0';
+    *out++ = '.';
+    std::memset(out, '0', -exponent - 1);
+    out += -exponent - 1;
+    std::memcpy(out, digits, length);
+    return out + length;
+}
+
+template <class T>
+char* format_number(char* out, T value, std::true_type /*is_integral*/) {
+    using U = std::make_unsigned_t<T>;
+    U x = static_cast<U>(value);
+    if (value < 0) {
+        *out++ = '-';
+        x = static_cast<U>(U(0) - x);
+    }
+    return format_uint(out, x);
+}
+
+template <class T>
+char* format_number(char* out, T value, std::false_type /*is_integral*/) {
+    if (std::signbit(value)) *out++ = '-';
+    if (std::isnan(value)) {
+        std::memcpy(out, "nan", 3);
+        return out + 3;
+    }
+    if (std::isinf(value)) {
+        std::memcpy(out, "inf", 3);
+        return out + 3;
+    }
+    if (value == 0) {
+        *out = '0';
+        return out + 1;
+    }
+    char digits[20];
+    int length, K;
+    grisu2(std::fabs(value), digits, length, K);
+    return format_decimal(out, digits, length, K);
+}
+
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief Writes `value` in decimal to `out` and returns the end
+ *
+ * `out` needs `max_number_size` chars, no null character is written.
+ * Integers are written two digits at a time. Floating point numbers
+ * are written with the shortest digits that read back as the same
+ * value (Grisu2), in fixed notation for decimal exponents from -4 to 16
+ * and in scientific notation otherwise, as `%.17g` without the trailing
+ * noise: `0.1`, `1e+20`, `-0`, `nan`, `inf`.
+ */
+template <class T,
+          class = std::enable_if_t<is_fast_formatted<T>::value>>
+char* format_number(char* out, T value) {
+    return detail::format_number(out, value, std::is_integral<T>{});
+}
+
+/// `format_number` as string
+template <class T,
+          class = std::enable_if_t<is_fast_formatted<T>::value>>
+std::string format_number(T value) {
+    char buffer[max_number_size];
+    return std::string(buffer, format_number(buffer, value));
+}
+
+namespace detail {
+
+inline bool is_digit(char c) noexcept {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+template <class T>
+bool parse_number(const char* first, const char* last, T& value,
+                  std::true_type /*is_integral*/) {
+    bool negative = false;
+    if (first != last && (*first == '-' || *first == '+')) {
+        negative = (*first++ == '-');
+    }
+    if (first == last) return false;
+    const std::uint64_t max = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t x = 0;
+    for (; first != last; ++first) {
+        if (!is_digit(*first)) return false;
+        unsigned d = static_cast<unsigned>(*first - '0');
+        if (x > (max - d) / 10) return false;
+        x = x * 10 + d;
+    }
+    const std::uint64_t limit =
+        static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+    if (negative) {
+        if (!std::is_signed<T>::value && x != 0) return false;
+        if (x > limit + 1) return false;
+        // Two's complement negation without signed overflow
+        value = static_cast<T>(0 - static_cast<std::uint64_t>(x));
+        return true;
+    }
+    if (x > limit) return false;
+    value = static_cast<T>(x);
+    return true;
+}
+
+inline bool parse_number(const char* first, const char* last, bool& value,
+                         std::true_type /*is_integral*/) {
+    if (last - first != 1 || (*first != '0' && *first != '1')) return false;
+    value = (*first == '1');
+    return true;
+}
+
+inline float strto(const char* s, char** end, float) {
+    return std::strtof(s, end);
+}
+inline double strto(const char* s, char** end, double) {
+    return std::strtod(s, end);
+}
+inline long double strto(const char* s, char** end, long double) {
+    return std::strtold(s, end);
+}
+
+/// Library conversion for all cases the fast path does not cover
+template <class T>
+bool parse_float_slow(const char* first, const char* last, T& value) {
+    // strtod skips leading white space
+    if (first == last || std::strchr(" \t\n\v\f\r", *first)) return false;
+    char buffer[64];
+    std::string long_token;
+    const char* s = buffer;
+    std::size_t length = last - first;
+    if (length < sizeof(buffer)) {
+        std::memcpy(buffer, first, length);
+        buffer[length] = '\0';
+    } else {
+        long_token.assign(first, last);
+        s = long_token.c_str();
+    }
+    char* end;
+    value = strto(s, &end, T());
+    return end == s + length;
+}
+
+/**\brief Clinger's fast path
+ *
+ * Up to 19 significant digits are collected in an integer `m`. If
+ * `m < 2^digits` and `10^|e|` is exact in T, `m * 10^e` is a single
+ * correctly rounded operation. Everything else, including `nan` and
+ * `inf`, goes to `strtod`.
+ */
+template <class T>
+bool parse_number(const char* first, const char* last, T& value,
+                  std::false_type /*is_integral*/) {
+    static constexpr double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                       1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                       1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                       1e18, 1e19, 1e20, 1e21, 1e22};
+    // Largest exact power of ten, 10^22 for double and 10^10 for float
+    constexpr int max_exp10 = std::numeric_limits<T>::digits >= 53 ? 22 : 10;
+    constexpr std::uint64_t max_mantissa = std::uint64_t(1)
+                                           << std::numeric_limits<T>::digits;
+    const char* p = first;
+    bool negative = false;
+    if (p != last && (*p == '-' || *p == '+')) negative = (*p++ == '-');
+    std::uint64_t m = 0;
+    int digits = 0;
+    int exp10 = 0;
+    bool exact = true;
+    bool any = false;
+    auto digit = [&](unsigned d) {
+        any = true;
+        if (digits < 19) {
+            m = m * 10 + d;
+            if (m != 0) ++digits;
+            return true;
+        }
+        if (d != 0) exact = false;
+        return false;
+    };
+    for (; p != last && is_digit(*p); ++p) {
+        if (!digit(static_cast<unsigned>(*p - '0'))) ++exp10;
+    }
+    if (p != last && *p == '.') {
+        for (++p; p != last && is_digit(*p); ++p) {
+            if (digit(static_cast<unsigned>(*p - '0'))) --exp10;
+        }
+    }
+    if (any && p != last && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negative_exp = false;
+        if (p != last && (*p == '-' || *p == '+')) {
+            negative_exp = (*p++ == '-');
+        }
+        if (p == last) return false;
+        int e = 0;
+        for (; p != last && is_digit(*p); ++p) {
+            if (e < 100000) e = e * 10 + (*p - '0');
+        }
+        exp10 += negative_exp ? -e : e;
+    }
+    if (!any || p != last) return parse_float_slow(first, last, value);
+    if (m == 0 && exact) {
+        value = negative ? -T(0) : T(0);
+        return true;
+    }
+    if (!exact || m > max_mantissa || exp10 < -max_exp10 ||
+        exp10 > max_exp10 || std::numeric_limits<T>::digits > 53) {
+        return parse_float_slow(first, last, value);
+    }
+    T x = static_cast<T>(m);
+    if (exp10 < 0) {
+        x /= static_cast<T>(pow10[-exp10]);
+    } else {
+        x *= static_cast<T>(pow10[exp10]);
+    }
+    value = negative ? -x : x;
+    return true;
+}
+
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief Parses the number in `[first, last)` without locale
+ *
+ * The whole range must be the number, without blanks. Integers take an
+ * optional sign and decimal digits and fail if out of range of T, bool
+ * takes `0` or `1`. Floating point numbers are parsed with Clinger's
+ * fast path if possible and with `strtod` otherwise, so the result is
+ * always correctly rounded. Returns false on errors.
+ */
+template <class T>
+bool parse_number(const char* first, const char* last, T& value) {
+    static_assert(std::is_arithmetic<T>::value, "Only numbers are parsed");
+    return detail::parse_number(first, last, value, std::is_integral<T>{});
+}
+
+}  // end namespace js
@@ -0,0 +1,400 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "basic_file_handler.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace js {
+
+/**\ingroup stream
+ * \brief When RotatingFileHandler starts a new file
+ *
+ * A limit of zero means no limit.
+ */
+struct RotationPolicy {
+    /// Maximal size of a file in bytes
+    std::uint64_t max_bytes = 0;
+    /// Maximal time a file is written to
+    std::chrono::steady_clock::duration max_age =
+        std::chrono::steady_clock::duration::zero();
+};
+
+namespace detail {
+
+/**\ingroup stream
+ * \brief Stream buffer writing to a file descriptor
+ *
+ * Counts the written bytes, so the file size is known without system
+ * calls.
+ */
+class FdStreamBuf : public std::streambuf {
+  private:
+    std::vector<char> _buffer;
+    int _fd;
+    std::uint64_t _written;
+
+    bool write_buffer();
+
+  protected:
+    int_type overflow(int_type c) override;
+    int sync() override { return write_buffer() ? 0 : -1; }
+
+  public:
+    explicit FdStreamBuf(std::size_t buffer_size)
+        : _buffer(buffer_size > 0 ? buffer_size : 1), _fd(-1), _written(0) {}
+    FdStreamBuf(const FdStreamBuf&) = delete;
+    FdStreamBuf& operator=(const FdStreamBuf&) = delete;
+    ~FdStreamBuf() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    /// Takes ownership of `fd`
+    void open(int fd);
+    /// Writes the buffer and closes the file, throws on errors
+    void close();
+    bool is_open() const noexcept { return _fd != -1; }
+    /// Bytes written to the current file including the buffer
+    std::uint64_t size() const noexcept {
+        return _written + static_cast<std::uint64_t>(pptr() - pbase());
+    }
+};
+
+/// True if the item ends a line, only then files are rotated
+inline bool ends_line(char c) noexcept { return c == '\n'; }
+inline bool ends_line(const char* s) noexcept {
+    std::size_t n = std::strlen(s);
+    return n > 0 && s[n - 1] == '\n';
+}
+inline bool ends_line(const std::string& s) noexcept {
+    return !s.empty() && s.back() == '\n';
+}
+template <class T>
+bool ends_line(const T&) noexcept {
+    return false;
+}
+inline bool ends_line(std::ostream& (*)(std::ostream&)) noexcept {
+    // std::endl; other manipulators are rare in output of rows
+    return true;
+}
+
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief File handler starting a new file when a limit is reached
+ *
+ * Writes `filename.extension`, then `filename-1.extension`,
+ * `filename-2.extension`, ... Each file is started when the previous
+ * one exceeds `max_bytes` or is older than `max_age`. Files only change
+ * after an item ending with a newline (a string or char ending in '\n',
+ * or `std::endl`), so lines are never split between files. The check
+ * costs a comparison per line and a clock read if `max_age` is set.
+ *
+ * New files are created with `O_EXCL` at the index after the previous
+ * file, so a rotation usually costs a single `open` call. Existing
+ * files are skipped with exponential probing, see `free_file_index`.
+ */
+class RotatingFileHandler {
+  private:
+    std::string _filename;
+    std::string _file_extension;
+    RotationPolicy _policy;
+    detail::FdStreamBuf _buffer;
+    std::ostream _file;
+    std::size_t _index;
+    std::chrono::steady_clock::time_point _opened;
+    bool _rotate_pending;
+    std::vector<std::string> _files;
+
+    void open_next();
+    bool rotation_due() const {
+        if (_policy.max_bytes > 0 && _buffer.size() >= _policy.max_bytes) {
+            return true;
+        }
+        return _policy.max_age > std::chrono::steady_clock::duration::zero() &&
+               std::chrono::steady_clock::now() - _opened >= _policy.max_age;
+    }
+
+  public:
+    /// Default size of the write buffer
+    static constexpr std::size_t default_buffer_size = 1 << 16;
+
+    /**@name Constructors
+     */
+    ///@{
+    /// Opens no file
+    explicit RotatingFileHandler(RotationPolicy policy = RotationPolicy(),
+                                 std::size_t buffer_size = default_buffer_size)
+        : _policy(policy),
+          _buffer(buffer_size),
+          _file(&_buffer),
+          _index(0),
+          _rotate_pending(false) {}
+    /// Opens the first free file `filename.extension`, `filename-1...`
+    RotatingFileHandler(std::string filename, std::string file_extension,
+                        RotationPolicy policy = RotationPolicy())
+        : RotatingFileHandler(policy) {
+        open(filename, file_extension);
+    }
+    ///@}
+
+    /**@name open and close
+     */
+    ///@{
+    void open(std::string filename, std::string file_extension);
+    /// Closes the current file now and continues in the next one
+    void rotate();
+    /// Writes buffered data to the file
+    void flush() {
+        if (_buffer.pubsync() != 0) {
+            throw std::runtime_error("Writing file " + getFilename() +
+                                     " failed");
+        }
+    }
+    void close();
+    ///@}
+
+    /// Current file
+    std::string getFilename() const {
+        return _files.empty() ? std::string() : _files.back();
+    }
+    /// All files written since `open()`, in order
+    const std::vector<std::string>& files() const noexcept { return _files; }
+    const RotationPolicy& policy() const noexcept { return _policy; }
+
+    template <class T>
+    friend RotatingFileHandler& operator<<(RotatingFileHandler&, const T&);
+    friend RotatingFileHandler& operator<<(RotatingFileHandler& out,
+                                           std::ostream& (*f)(std::ostream&)) {
+        if (out._rotate_pending) out.rotate();
+        out._file << f;
+        out._rotate_pending = detail::ends_line(f) && out.rotation_due();
+        return out;
+    }
+};
+
+template <class T>
+RotatingFileHandler& operator<<(RotatingFileHandler& out, const T& t) {
+    // Rotate lazily, so no empty file is left behind on close
+    if (out._rotate_pending) out.rotate();
+    out._file << t;
+    out._rotate_pending = detail::ends_line(t) && out.rotation_due();
+    return out;
+}
+
+/**\ingroup stream
+ * \brief One RotatingFileHandler per writing thread
+ *
+ * `local()` returns the handler of the calling thread. It is created at
+ * the first call of a thread as `filename-t<k>.extension`, where `k`
+ * counts the threads. The shards are looked up by thread id under a
+ * mutex. A thread local cache of the last hit makes repeated calls of
+ * the same thread lock free, so writing threads rarely wait for each
+ * other. Cache entries are tagged with a handler id that is never
+ * reused, so a cache entry of a destroyed handler is never used.
+ *
+ * A thread that reuses the id of a finished thread continues its shard.
+ * `shards()` is safe at any time, `close()` and `files()` must not run
+ * concurrently with writers.
+ */
+class ShardedFileHandler {
+  private:
+    struct CacheEntry {
+        std::uint64_t id;
+        RotatingFileHandler* shard;
+    };
+
+    std::string _filename;
+    std::string _file_extension;
+    RotationPolicy _policy;
+    std::uint64_t _id;
+    mutable std::mutex _mutex;
+    std::vector<std::unique_ptr<RotatingFileHandler>> _shards;
+    std::unordered_map<std::thread::id, RotatingFileHandler*> _by_thread;
+
+    static CacheEntry& cache() noexcept {
+        static thread_local CacheEntry last{0, nullptr};
+        return last;
+    }
+    static std::uint64_t next_id() {
+        static std::atomic<std::uint64_t> id(0);
+        return ++id;
+    }
+
+  public:
+    ShardedFileHandler(std::string filename, std::string file_extension,
+                       RotationPolicy policy = RotationPolicy())
+        : _filename(std::move(filename)),
+          _file_extension(std::move(file_extension)),
+          _policy(policy),
+          _id(next_id()) {}
+    ShardedFileHandler(const ShardedFileHandler&) = delete;
+    ShardedFileHandler& operator=(const ShardedFileHandler&) = delete;
+
+    /// Handler of the calling thread
+    RotatingFileHandler& local() {
+        CacheEntry& last = cache();
+        if (last.id == _id) return *last.shard;
+        RotatingFileHandler* shard;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto& entry = _by_thread[std::this_thread::get_id()];
+            if (!entry) {
+                std::string name =
+                    _filename + "-t" + std::to_string(_shards.size());
+                _shards.emplace_back(
+                    new RotatingFileHandler(name, _file_extension, _policy));
+                entry = _shards.back().get();
+            }
+            shard = entry;
+        }
+        last = CacheEntry{_id, shard};
+        return *shard;
+    }
+
+    /// Number of threads that wrote
+    std::size_t shards() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _shards.size();
+    }
+    /// Files of all shards
+    std::vector<std::string> files() const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::vector<std::string> names;
+        for (const auto& shard : _shards) {
+            names.insert(names.end(), shard->files().begin(),
+                         shard->files().end());
+        }
+        return names;
+    }
+    /// Flushes and closes the files of all shards
+    void close() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto& shard : _shards) shard->close();
+    }
+};
+
+/*
+ * Functions implementations
+ */
+
+namespace detail {
+
+inline bool FdStreamBuf::write_buffer() {
+    const char* data = pbase();
+    std::size_t size = pptr() - pbase();
+    while (size > 0) {
+        ssize_t n = ::write(_fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+        _written += static_cast<std::uint64_t>(n);
+    }
+    setp(_buffer.data(), _buffer.data() + _buffer.size());
+    return true;
+}
+
+inline FdStreamBuf::int_type FdStreamBuf::overflow(int_type c) {
+    if (_fd == -1 || !write_buffer()) return traits_type::eof();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+inline void FdStreamBuf::open(int fd) {
+    close();
+    _fd = fd;
+    _written = 0;
+    setp(_buffer.data(), _buffer.data() + _buffer.size());
+}
+
+inline void FdStreamBuf::close() {
+    if (_fd == -1) return;
+    bool ok = write_buffer();
+    int error = ok ? 0 : errno;
+    if (::close(_fd) != 0 && ok) {
+        ok = false;
+        error = errno;
+    }
+    _fd = -1;
+    setp(nullptr, nullptr);
+    if (!ok) {
+        throw std::runtime_error(std::string("Writing file failed: ") +
+                                 std::strerror(error));
+    }
+}
+
+}  // end namespace detail
+
+inline void RotatingFileHandler::open_next() {
+    std::string name;
+    int fd = detail::create_free_file(_filename, _file_extension, -42, name,
+                                      _index);
+    _buffer.open(fd);
+    _file.clear();
+    _files.push_back(name);
+    _opened = std::chrono::steady_clock::now();
+    _rotate_pending = false;
+}
+
+inline void RotatingFileHandler::open(std::string filename,
+                                      std::string file_extension) {
+    close();
+    _filename = filename;
+    _file_extension = file_extension;
+    _index = 0;
+    _files.clear();
+    open_next();
+}
+
+inline void RotatingFileHandler::rotate() {
+    if (!_buffer.is_open()) return;
+    _buffer.close();
+    ++_index;
+    open_next();
+}
+
+inline void RotatingFileHandler::close() {
+    _rotate_pending = false;
+    _buffer.close();
+}
+
+}  // end namespace js
@@ -0,0 +1,382 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../algorithm/parallel_algorithm.hpp"
+#include "../container/soa_vector.hpp"
+#include "../thread/thread_pool.hpp"
+#include "../tuple/taggedtuple.hpp"
+#include "binary_file_handler.hpp"
+#include "mapped_file.hpp"
+#include "number_format.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace js {
+
+/**\ingroup stream
+ * \brief Layout of text tables read by TableReader
+ */
+struct TableFormat {
+    /// Field separator, `'\0'` for runs of blanks (spaces and tabs)
+    char delimiter = '\0';
+    /// Lines starting with this character are skipped, `'\0'` for none
+    char comment = '#';
+    /// First line, after comments, holds the column names
+    bool header = false;
+};
+
+namespace detail {
+
+inline bool is_blank(char c) noexcept { return c == ' ' || c == '\t'; }
+
+inline const char* skip_blanks(const char* p, const char* end) noexcept {
+    while (p != end && is_blank(*p)) ++p;
+    return p;
+}
+
+/// End of the line starting at `p`, the newline or `end`
+inline const char* line_end(const char* p, const char* end) noexcept {
+    const void* newline = std::memchr(p, '\n', end - p);
+    return newline ? static_cast<const char*>(newline) : end;
+}
+
+/// End of the field starting at `p`, with trailing blanks removed
+inline const char* field_end(const char* p, const char* end,
+                             char delimiter) noexcept {
+    if (delimiter == '\0') {
+        while (p != end && !is_blank(*p)) ++p;
+        return p;
+    }
+    const char* stop = p;
+    while (stop != end && *stop != delimiter) ++stop;
+    while (stop != p && is_blank(stop[-1])) --stop;
+    return stop;
+}
+
+/// Start of the next field after the field ending at `p`, or `end`
+inline const char* next_field(const char* p, const char* end,
+                              char delimiter) noexcept {
+    if (delimiter != '\0') {
+        while (p != end && *p != delimiter) ++p;
+        if (p == end) return end;
+        ++p;
+    }
+    return skip_blanks(p, end);
+}
+
+/// Splits a line into its trimmed fields
+inline std::vector<std::string> split_fields(const char* p, const char* end,
+                                             char delimiter) {
+    std::vector<std::string> fields;
+    p = skip_blanks(p, end);
+    while (p != end) {
+        const char* stop = field_end(p, end, delimiter);
+        fields.emplace_back(p, stop);
+        const char* next = next_field(stop, end, delimiter);
+        if (delimiter != '\0' && next == end && stop != end &&
+            std::find(stop, end, delimiter) != end) {
+            // Trailing delimiter, last field empty
+            fields.emplace_back();
+        }
+        p = next;
+    }
+    return fields;
+}
+
+/// Columns of a chunk of the table, one std::vector per tag
+template <class... Tags>
+using TableColumns = std::tuple<std::vector<tag_t<Tags>>...>;
+
+/// Requested column and the index of its tag
+struct ColumnTarget {
+    std::size_t column;
+    std::size_t tag;
+    bool operator<(const ColumnTarget& other) const noexcept {
+        return column < other.column;
+    }
+};
+
+}  // end namespace detail
+
+/**\ingroup stream
+ * \brief Parallel reader of text tables into a SoAVector
+ *
+ * Reads numeric tables separated by blanks or by a delimiter like `,`.
+ * Every tag selects one column of the file and gives its type, e.g.
+ * \code{.cpp}
+ * struct Time { using type = double; static constexpr const char* name =
+ * "time"; };
+ * struct Count { using type = int; };
+ *
+ * TableReader<Time, Count> reader("data.txt");
+ * reader.columns({0, 3});
+ * SoAVector<Time, Count> table = reader.read();
+ * \endcode
+ * By default tag `I` reads column `I`. With `TableFormat::header`,
+ * tags with a `name` read the column with this name in the header.
+ *
+ * The file is memory mapped and split at line boundaries into chunks,
+ * which the workers of a thread pool parse in parallel. Numbers are
+ * parsed with `parse_number`, without locale, and only the requested
+ * columns are parsed; the rest of a line is skipped after the last one.
+ * Empty lines and comment lines are skipped, lines may end in `\r\n`.
+ *
+ * Missing columns and invalid numbers throw std::runtime_error naming
+ * the file and line.
+ */
+template <class... Tags>
+class TableReader {
+    static_assert(sizeof...(Tags) > 0, "TableReader needs at least one tag");
+
+  public:
+    using table_type = SoAVector<Tags...>;
+    using columns_type = std::array<std::size_t, sizeof...(Tags)>;
+
+  private:
+    using index_sequence = std::index_sequence_for<Tags...>;
+    using Columns = detail::TableColumns<Tags...>;
+    using FieldParser = bool (*)(const char*, const char*, Columns&);
+
+    MappedFile _file;
+    TableFormat _format;
+    ThreadPool* _pool;
+    std::vector<std::string> _header;
+    const char* _body;
+    columns_type _columns;
+
+    template <std::size_t I>
+    static bool parse_field(const char* first, const char* last,
+                            Columns& columns) {
+        using T = std::tuple_element_t<I, std::tuple<tag_t<Tags>...>>;
+        T value;
+        if (!parse_number(first, last, value)) return false;
+        std::get<I>(columns).push_back(value);
+        return true;
+    }
+
+    template <std::size_t... I>
+    static std::array<FieldParser, sizeof...(Tags)> field_parsers(
+        std::index_sequence<I...>) {
+        return {{&parse_field<I>...}};
+    }
+
+    template <std::size_t... I>
+    static columns_type default_columns(
+        const std::vector<std::string>& header, std::index_sequence<I...>) {
+        return {{column_index<Tags>(header, I,
+                                    detail::has_tag_name<Tags>{})...}};
+    }
+
+    template <class Tag>
+    static std::size_t column_index(const std::vector<std::string>& header,
+                                    std::size_t i, std::true_type) {
+        if (header.empty()) return i;
+        // Copy, a reference to Tag::name would need its definition
+        const std::string name(Tag::name);
+        auto it = std::find(header.begin(), header.end(), name);
+        if (it == header.end()) {
+            throw std::invalid_argument("No column " + name +
+                                        " in table header");
+        }
+        return it - header.begin();
+    }
+
+    template <class Tag>
+    static std::size_t column_index(const std::vector<std::string>&,
+                                    std::size_t i, std::false_type) {
+        return i;
+    }
+
+    template <std::size_t... I>
+    static void append(table_type& table, std::size_t offset,
+                       const Columns& columns, std::index_sequence<I...>) {
+        int dummy[] = {0, (std::copy(std::get<I>(columns).begin(),
+                                     std::get<I>(columns).end(),
+                                     table.template column<Tags>().begin() +
+                                         offset),
+                           0)...};
+        (void)dummy;
+    }
+
+    bool skipped(const char* p, const char* end) const noexcept {
+        return p == end || (_format.comment != '\0' && *p == _format.comment);
+    }
+
+    void parse_chunk(const char* begin, const char* end,
+                     const std::vector<detail::ColumnTarget>& targets,
+                     Columns& columns) const;
+    [[noreturn]] void parse_error(const char* line,
+                                  const std::string& what) const;
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    /// Maps `filename`, reads the header and sets the default columns
+    explicit TableReader(const std::string& filename,
+                         TableFormat format = TableFormat(),
+                         ThreadPool& pool = ThreadPool::global());
+    ///@}
+
+    /// Names of the columns, empty without TableFormat::header
+    const std::vector<std::string>& header() const noexcept {
+        return _header;
+    }
+    /// Column of the file read for each tag
+    const columns_type& columns() const noexcept { return _columns; }
+    /// Set the column of the file read for each tag
+    void columns(const columns_type& columns) { _columns = columns; }
+
+    /// Parses the file in parallel
+    table_type read() const;
+};
+
+/*
+ * Functions implementations
+ */
+
+template <class... Tags>
+TableReader<Tags...>::TableReader(const std::string& filename,
+                                  TableFormat format, ThreadPool& pool)
+    : _file(filename, MappedFile::Mode::read, AccessHint::sequential),
+      _format(format),
+      _pool(&pool),
+      _body(_file.data()) {
+    const char* end = _file.data() + _file.size();
+    while (_format.header && _body != end) {
+        const char* stop = detail::line_end(_body, end);
+        const char* line = _body;
+        _body = (stop == end) ? end : stop + 1;
+        if (stop != line && stop[-1] == '\r') --stop;
+        if (skipped(detail::skip_blanks(line, stop), stop)) continue;
+        _header = detail::split_fields(line, stop, _format.delimiter);
+        break;
+    }
+    _columns = default_columns(_header, index_sequence{});
+}
+
+template <class... Tags>
+void TableReader<Tags...>::parse_error(const char* line,
+                                       const std::string& what) const {
+    std::size_t number = std::count(_file.data(), line, '\n') + 1;
+    throw std::runtime_error(_file.filename() + ":" +
+                             std::to_string(number) + ": " + what);
+}
+
+template <class... Tags>
+void TableReader<Tags...>::parse_chunk(
+    const char* begin, const char* end,
+    const std::vector<detail::ColumnTarget>& targets,
+    Columns& columns) const {
+    static const auto parsers = field_parsers(index_sequence{});
+    const char delimiter = _format.delimiter;
+    const std::size_t no_targets = targets.size();
+    for (const char* line = begin; line < end;) {
+        const char* stop = detail::line_end(line, end);
+        const char* next_line = stop + 1;
+        if (stop != line && stop[-1] == '\r') --stop;
+        const char* p = detail::skip_blanks(line, stop);
+        if (skipped(p, stop)) {
+            line = next_line;
+            continue;
+        }
+        std::size_t t = 0;
+        for (std::size_t field = 0; t != no_targets; ++field) {
+            if (p == stop && delimiter == '\0') {
+                parse_error(line, "missing column " +
+                                      std::to_string(targets[t].column));
+            }
+            const char* value_end = detail::field_end(p, stop, delimiter);
+            for (; t != no_targets && targets[t].column == field; ++t) {
+                if (!parsers[targets[t].tag](p, value_end, columns)) {
+                    parse_error(line, "invalid number '" +
+                                          std::string(p, value_end) + "'");
+                }
+            }
+            if (t == no_targets) break;
+            const char* next = detail::next_field(value_end, stop, delimiter);
+            if (next == stop && delimiter != '\0' &&
+                std::find(value_end, stop, delimiter) == stop) {
+                // No delimiter left, the line has no further fields
+                parse_error(line, "missing column " +
+                                      std::to_string(targets[t].column));
+            }
+            p = next;
+        }
+        line = next_line;
+    }
+}
+
+template <class... Tags>
+typename TableReader<Tags...>::table_type TableReader<Tags...>::read()
+    const {
+    std::vector<detail::ColumnTarget> targets;
+    for (std::size_t i = 0; i != _columns.size(); ++i) {
+        targets.push_back({_columns[i], i});
+    }
+    std::stable_sort(targets.begin(), targets.end());
+
+    // Chunks of at least 256 KiB starting at line beginnings
+    const char* end = _file.data() + _file.size();
+    std::size_t length = end - _body;
+    std::size_t no_chunks =
+        std::max<std::size_t>(1, std::min(length >> 18, 8 * _pool->size()));
+    std::vector<const char*> bounds{_body};
+    for (std::size_t i = 1; i != no_chunks; ++i) {
+        const char* p = std::max(bounds.back(), _body + length * i / no_chunks);
+        if (p != _body && p[-1] != '\n') {
+            const char* stop = detail::line_end(p, end);
+            p = (stop == end) ? end : stop + 1;
+        }
+        bounds.push_back(p);
+    }
+    bounds.push_back(end);
+
+    std::vector<Columns> chunks(no_chunks);
+    auto parse = [&](std::size_t start, std::size_t stop) {
+        for (std::size_t i = start; i != stop; ++i) {
+            parse_chunk(bounds[i], bounds[i + 1], targets, chunks[i]);
+        }
+    };
+    detail::for_each_chunk(no_chunks, *_pool, dynamic_schedule(1), parse);
+
+    std::vector<std::size_t> offsets{0};
+    for (const auto& chunk : chunks) {
+        offsets.push_back(offsets.back() + std::get<0>(chunk).size());
+    }
+    table_type table(offsets.back());
+    auto copy = [&](std::size_t start, std::size_t stop) {
+        for (std::size_t i = start; i != stop; ++i) {
+            append(table, offsets[i], chunks[i], index_sequence{});
+        }
+    };
+    detail::for_each_chunk(no_chunks, *_pool, dynamic_schedule(1), copy);
+    return table;
+}
+
+}  // end namespace js
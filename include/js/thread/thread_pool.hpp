@@ -0,0 +1,267 @@
+/*
+CppUtility library
+Copyright (C) 2016  Jan Schmidt
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace js {
+
+namespace detail {
+/**
+ * Move only, type erased `void()` callable. std::function cannot be
+ * used, because std::packaged_task is not copyable.
+ */
+class PoolTask {
+  private:
+    struct Base {
+        virtual ~Base() = default;
+        virtual void call() = 0;
+    };
+    template <class F>
+    struct Impl : Base {
+        F _f;
+        Impl(F&& f) : _f(std::move(f)) {}
+        void call() override { _f(); }
+    };
+    std::unique_ptr<Base> _impl;
+
+  public:
+    PoolTask() = default;
+    template <class F, class = std::enable_if_t<
+                           !std::is_same<std::decay_t<F>, PoolTask>::value>>
+    PoolTask(F&& f)
+        : _impl(new Impl<std::decay_t<F>>(
+              std::decay_t<F>(std::forward<F>(f)))) {}
+    PoolTask(PoolTask&&) = default;
+    PoolTask& operator=(PoolTask&&) = default;
+
+    void operator()() { _impl->call(); }
+    explicit operator bool() const noexcept { return bool(_impl); }
+};
+
+/**
+ * Task deque of a single worker. The owner pushes and pops at the back,
+ * other threads steal from the front.
+ */
+class WorkQueue {
+  private:
+    std::mutex _mutex;
+    std::deque<PoolTask> _tasks;
+
+  public:
+    void push(PoolTask&& task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    bool pop(PoolTask& task) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_tasks.empty()) return false;
+        task = std::move(_tasks.back());
+        _tasks.pop_back();
+        return true;
+    }
+    bool steal(PoolTask& task) {
+        std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+        if (!lock || _tasks.empty()) return false;
+        task = std::move(_tasks.front());
+        _tasks.pop_front();
+        return true;
+    }
+};
+}  // end namespace detail
+
+/**\ingroup thread
+ * \brief Work stealing thread pool
+ *
+ * Every worker owns a task deque. Tasks submitted from a worker go to
+ * its own deque, tasks submitted from outside are distributed round
+ * robin. Idle workers steal from the front of the other deques.
+ *
+ * Threads waiting for the result of pool tasks should use `wait_until()`,
+ * which executes pending tasks instead of blocking. This makes it safe
+ * to call parallel algorithms from inside of pool tasks.
+ *
+ * Tasks given to `post()` must not throw, use `submit()` if the task
+ * can throw.
+ */
+class ThreadPool {
+  private:
+    struct WorkerId {
+        const ThreadPool* pool;
+        std::size_t index;
+    };
+
+    std::vector<std::unique_ptr<detail::WorkQueue>> _queues;
+    std::vector<std::thread> _threads;
+    std::atomic<std::size_t> _pending;
+    std::atomic<std::size_t> _next_queue;
+    std::mutex _wake_mutex;
+    std::condition_variable _wake;
+    bool _done;
+
+    static WorkerId& this_worker() noexcept {
+        static thread_local WorkerId id{nullptr, 0};
+        return id;
+    }
+
+    void worker_loop(std::size_t index);
+    void push(detail::PoolTask&& task);
+
+  public:
+    /**@name Constructors
+     */
+    ///@{
+    /// Creates pool with `default_size()` workers
+    ThreadPool() : ThreadPool(default_size()) {}
+    /// Creates pool with `no_threads` workers (at least one)
+    explicit ThreadPool(std::size_t no_threads);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    /// Executes all pending tasks and joins the workers
+    ~ThreadPool();
+    ///@}
+
+    /// Number of workers
+    std::size_t size() const noexcept { return _threads.size(); }
+
+    /// Number of hardware threads, but at least two
+    static std::size_t default_size() noexcept {
+        std::size_t no_threads = std::thread::hardware_concurrency();
+        return (no_threads > 1) ? no_threads : 2;
+    }
+
+    /**\brief Process wide pool
+     *
+     * The pool is created with `default_size()` workers at first use.
+     */
+    static ThreadPool& global() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    /// Enqueue task without result
+    template <class F>
+    void post(F&& f) {
+        push(detail::PoolTask(std::forward<F>(f)));
+    }
+
+    /// Enqueue task and get future of the result
+    template <class F>
+    std::future<std::result_of_t<std::decay_t<F>()>> submit(F&& f) {
+        std::packaged_task<std::result_of_t<std::decay_t<F>()>()> task(
+            std::forward<F>(f));
+        auto future = task.get_future();
+        push(detail::PoolTask(std::move(task)));
+        return future;
+    }
+
+    /**\brief Executes one pending task on the calling thread
+     *
+     * Returns false if no task was found.
+     */
+    bool run_pending_task();
+
+    /// Executes pending tasks until `done()` returns true
+    template <class Predicate>
+    void wait_until(Predicate done) {
+        while (!done()) {
+            if (!run_pending_task()) std::this_thread::yield();
+        }
+    }
+
+    /// True if the calling thread is a worker of this pool
+    bool is_worker() const noexcept { return this_worker().pool == this; }
+};
+
+/*
+ * Functions implementations
+ */
+
+inline ThreadPool::ThreadPool(std::size_t no_threads)
+    : _pending(0), _next_queue(0), _done(false) {
+    if (no_threads == 0) no_threads = 1;
+    for (std::size_t i = 0; i != no_threads; ++i) {
+        _queues.emplace_back(new detail::WorkQueue);
+    }
+    for (std::size_t i = 0; i != no_threads; ++i) {
+        _threads.emplace_back([this, i]() { worker_loop(i); });
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        _done = true;
+    }
+    _wake.notify_all();
+    for (auto& t : _threads) {
+        t.join();
+    }
+}
+
+inline void ThreadPool::push(detail::PoolTask&& task) {
+    WorkerId& id = this_worker();
+    std::size_t index = (id.pool == this)
+                            ? id.index
+                            : _next_queue.fetch_add(1) % _queues.size();
+    {
+        // Count before pushing, so _pending never drops below zero
+        std::lock_guard<std::mutex> lock(_wake_mutex);
+        ++_pending;
+    }
+    _queues[index]->push(std::move(task));
+    _wake.notify_one();
+}
+
+inline bool ThreadPool::run_pending_task() {
+    WorkerId& id = this_worker();
+    bool worker = (id.pool == this);
+    std::size_t start = worker ? id.index : 0;
+    std::size_t no_queues = _queues.size();
+    detail::PoolTask task;
+    bool found = worker && _queues[start]->pop(task);
+    for (std::size_t i = 1; !found && i <= no_queues; ++i) {
+        found = _queues[(start + i) % no_queues]->steal(task);
+    }
+    if (!found) return false;
+    --_pending;
+    task();
+    return true;
+}
+
+inline void ThreadPool::worker_loop(std::size_t index) {
+    this_worker() = WorkerId{this, index};
+    while (true) {
+        if (run_pending_task()) continue;
+        std::unique_lock<std::mutex> lock(_wake_mutex);
+        _wake.wait(lock, [this]() { return _done || _pending > 0; });
+        if (_done && _pending == 0) return;
+    }
+}
+
+}  // end namespace js
@@ -89,8 +89,9 @@ decltype(auto) apply_tuple(Function&& f, Tuple&& tuple) {
  */
 template <class Array>
 decltype(auto) tuple_from_array(Array&& array) {
+    constexpr std::size_t size = std::tuple_size<std::decay_t<Array>>::value;
     return detail::tuple_from_array(std::forward<Array>(array),
-                                    std::make_index_sequence<array.size()>{});
+                                    std::make_index_sequence<size>{});
 }
 
 /**\ingroup tuple
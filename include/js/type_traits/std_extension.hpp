@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <iterator>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -126,4 +127,14 @@ struct is_swapable_with<
 template <class T>
 struct is_swapable : is_swapable_with<T, T> {};
 
+namespace detail {
+template <class, class = void_t<>>
+struct is_iterator : std::false_type {};
+
+template <class T>
+struct is_iterator<
+    T, void_t<typename std::iterator_traits<T>::iterator_category>>
+    : std::true_type {};
+}  // end namespace detail
+
 }  // end namespace js
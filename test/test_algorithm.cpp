@@ -1,5 +1,13 @@
 #include "catch.hpp"
 #include "js/algorithm.hpp"
+#include "js/random/distribution.hpp"
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 TEST_CASE("Sort") {
     std::vector<int> test = {3, 6, 4, 1};
@@ -8,4 +16,503 @@ TEST_CASE("Sort") {
         auto sorted_vec = js::index_sort(test.begin(), test.end());
         CHECK(sorted_vec == expected);
     }
+    SECTION("index_sort with 32 bit indices") {
+        std::vector<std::uint32_t> expected = {1, 2, 0, 3};
+        auto sorted_vec = js::index_sort<std::uint32_t>(
+            test.begin(), test.end(), std::greater<int>());
+        CHECK(sorted_vec == expected);
+    }
+}
+
+TEST_CASE("Parallel and radix index sort") {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> dist(-100, 100);
+    std::vector<double> values(5003);
+    for (auto& x : values) {
+        x = dist(rng);
+    }
+    auto expected = js::index_sort(values.begin(), values.end());
+    js::ThreadPool pool(3);
+
+    SECTION("parallel_index_sort") {
+        CHECK(js::parallel_index_sort(values.begin(), values.end(), pool) ==
+              expected);
+        auto sorted32 = js::parallel_index_sort<std::uint32_t>(
+            values.begin(), values.end(), pool);
+        CHECK(std::equal(sorted32.begin(), sorted32.end(), expected.begin()));
+    }
+
+    SECTION("radix_index_sort floating point") {
+        CHECK(js::radix_index_sort(values.begin(), values.end()) ==
+              expected);
+        std::vector<float> values_f(values.begin(), values.end());
+        auto sorted_f = js::radix_index_sort<std::uint32_t>(values_f.begin(),
+                                                            values_f.end());
+        CHECK(std::is_sorted(sorted_f.begin(), sorted_f.end(),
+                             [&](std::uint32_t i, std::uint32_t j) {
+                                 return values_f[i] < values_f[j];
+                             }));
+    }
+
+    SECTION("radix_index_sort integer is stable") {
+        std::vector<int> ints = {5, -3, 7, -3, 0, 5, -1000000, 2};
+        std::vector<std::size_t> expected_int = {6, 1, 3, 4, 7, 0, 5, 2};
+        CHECK(js::radix_index_sort(ints.begin(), ints.end()) == expected_int);
+        std::vector<double> zeros = {0.0, -0.0, 1.0, -1.0};
+        std::vector<std::size_t> expected_zeros = {3, 1, 0, 2};
+        CHECK(js::radix_index_sort(zeros.begin(), zeros.end()) ==
+              expected_zeros);
+    }
+
+    SECTION("Index type too small") {
+        std::vector<char> large(300);
+        CHECK_THROWS_AS(js::index_sort<std::uint8_t>(large.begin(),
+                                                     large.end()),
+                        std::length_error);
+    }
+}
+
+TEST_CASE("Parallel algorithms") {
+    std::vector<int> test(1000);
+    std::iota(test.begin(), test.end(), 1);
+    const int expected_sum = 500500;
+    js::ThreadPool pool(4);
+
+    SECTION("parallel_accumulate") {
+        CHECK(js::parallel_accumulate(test.begin(), test.end(), 0, 4) ==
+              expected_sum);
+        CHECK(js::parallel_accumulate(test.begin(), test.end(), 0, pool) ==
+              expected_sum);
+        CHECK(js::parallel_accumulate(test.begin(), test.end(), 0,
+                                      std::plus<int>(), pool) == expected_sum);
+        CHECK(js::parallel_accumulate_auto(test.begin(), test.end(), 0) ==
+              expected_sum);
+    }
+
+    SECTION("parallel_accumulate on short ranges") {
+        CHECK(js::parallel_accumulate(test.begin(), test.begin(), 7, pool) ==
+              7);
+        CHECK(js::parallel_accumulate(test.begin(), test.begin() + 2, 0,
+                                      pool) == 3);
+    }
+
+    SECTION("async_accumulate") {
+        CHECK(js::async_accumulate(test.begin(), test.end(), 0) ==
+              expected_sum);
+        CHECK(js::async_accumulate(test.begin(), test.end(), 0, pool) ==
+              expected_sum);
+    }
+
+    SECTION("parallel_for_each") {
+        auto twice = [](int& x) { x *= 2; };
+        js::parallel_for_each(test.begin(), test.end(), twice, pool);
+        CHECK(std::accumulate(test.begin(), test.end(), 0) ==
+              2 * expected_sum);
+        js::parallel_for_each_auto(test.begin(), test.end(), twice);
+        CHECK(std::accumulate(test.begin(), test.end(), 0) ==
+              4 * expected_sum);
+    }
+
+    SECTION("parallel_for_each with schedules") {
+        auto twice = [](int& x) { x *= 2; };
+        js::parallel_for_each(test.begin(), test.end(), twice, pool,
+                              js::static_schedule());
+        js::parallel_for_each(test.begin(), test.end(), twice, pool,
+                              js::dynamic_schedule(7));
+        js::parallel_for_each(test.begin(), test.end(), twice, pool,
+                              js::guided_schedule(3));
+        js::parallel_for_each_auto(test.begin(), test.end(), twice,
+                                   js::guided_schedule());
+        CHECK(std::accumulate(test.begin(), test.end(), 0) ==
+              16 * expected_sum);
+        std::vector<int> visits(test.size(), 0);
+        js::parallel_for_each(visits.begin(), visits.end(),
+                              [](int& x) { ++x; }, pool,
+                              js::dynamic_schedule(1000000));
+        CHECK(std::count(visits.begin(), visits.end(), 1) == 1000);
+    }
+
+    SECTION("Exceptions are rethrown") {
+        auto fail = [](int x) {
+            if (x == 999) throw std::runtime_error("fail");
+        };
+        CHECK_THROWS_AS(
+            js::parallel_for_each(test.begin(), test.end(), fail, pool),
+            std::runtime_error);
+        CHECK_THROWS_AS(js::parallel_for_each(test.begin(), test.end(), fail,
+                                              pool, js::guided_schedule(4)),
+                        std::runtime_error);
+    }
+}
+
+TEST_CASE("Parallel for each with random engines") {
+    using Counts = std::array<int, 3>;
+    const std::array<double, 3> prob{{0.2, 0.3, 0.5}};
+    js::MultinomialDistribution<3> dist(50, prob);
+    auto draw = [&dist](Counts& c, js::Philox4x32& g) { c = dist(g); };
+    const std::uint64_t seed = 2024;
+
+    std::vector<Counts> expected(1000);
+    for (std::size_t i = 0; i != expected.size(); ++i) {
+        js::Philox4x32 g(seed, i);
+        draw(expected[i], g);
+    }
+
+    for (std::size_t threads : {1, 2, 5}) {
+        js::ThreadPool pool(threads);
+        std::vector<Counts> agents(expected.size());
+        js::parallel_for_each_random(agents.begin(), agents.end(), draw, seed,
+                                     pool);
+        CHECK(agents == expected);
+        agents.assign(agents.size(), Counts{});
+        js::parallel_for_each_random(agents.begin(), agents.end(), draw, seed,
+                                     pool, js::dynamic_schedule(7));
+        CHECK(agents == expected);
+        agents.assign(agents.size(), Counts{});
+        js::parallel_for_each_random(agents.begin(), agents.end(), draw, seed,
+                                     pool, js::guided_schedule());
+        CHECK(agents == expected);
+    }
+
+    std::vector<Counts> agents(expected.size());
+    js::parallel_for_each_random_auto(agents.begin(), agents.end(), draw,
+                                      seed + 1);
+    CHECK(agents != expected);
+    for (const auto& c : agents) {
+        CHECK(c[0] + c[1] + c[2] == 50);
+    }
+}
+
+TEST_CASE("Parallel prefix scan") {
+    js::ThreadPool pool(4);
+    std::vector<int> data(1001);
+    std::iota(data.begin(), data.end(), -300);
+    std::vector<int> expected(data.size());
+    std::vector<int> result(data.size());
+
+    SECTION("Inclusive") {
+        std::partial_sum(data.begin(), data.end(), expected.begin());
+        auto out = js::parallel_inclusive_scan(data.begin(), data.end(),
+                                               result.begin(), pool);
+        CHECK(out == result.end());
+        CHECK(result == expected);
+        std::fill(result.begin(), result.end(), 0);
+        js::parallel_inclusive_scan(data.begin(), data.end(), result.begin(),
+                                    3);
+        CHECK(result == expected);
+        js::parallel_inclusive_scan_auto(data.begin(), data.end(),
+                                         data.begin());
+        CHECK(data == expected);
+    }
+
+    SECTION("Exclusive") {
+        expected[0] = 5;
+        std::partial_sum(data.begin(), data.end() - 1, expected.begin() + 1);
+        for (std::size_t i = 1; i != expected.size(); ++i) expected[i] += 5;
+        js::parallel_exclusive_scan(data.begin(), data.end(), result.begin(), 5,
+                                    pool);
+        CHECK(result == expected);
+        js::parallel_exclusive_scan(data.begin(), data.end(), result.begin(), 5,
+                                    5);
+        CHECK(result == expected);
+        js::parallel_exclusive_scan_auto(data.begin(), data.end(),
+                                         data.begin(), 5);
+        CHECK(data == expected);
+    }
+
+    SECTION("Non commutative operator") {
+        std::vector<std::string> words(37);
+        for (std::size_t i = 0; i != words.size(); ++i) {
+            words[i] = std::string(1, static_cast<char>('a' + i % 26));
+        }
+        std::vector<std::string> serial(words.size());
+        std::partial_sum(words.begin(), words.end(), serial.begin());
+        std::vector<std::string> parallel(words.size());
+        js::parallel_inclusive_scan(words.begin(), words.end(),
+                                    parallel.begin(), std::plus<std::string>(),
+                                    pool);
+        CHECK(parallel == serial);
+        js::parallel_exclusive_scan(words.begin(), words.end(),
+                                    parallel.begin(), std::string(">"),
+                                    std::plus<std::string>(), pool);
+        CHECK(parallel[0] == ">");
+        CHECK(parallel.back() == ">" + serial[serial.size() - 2]);
+    }
+
+    SECTION("Short ranges") {
+        std::vector<double> one{2.5};
+        std::vector<double> out(1);
+        js::parallel_inclusive_scan(one.begin(), one.end(), out.begin(), pool);
+        CHECK(out[0] == 2.5);
+        js::parallel_exclusive_scan(one.begin(), one.end(), out.begin(), 1.0,
+                                    pool);
+        CHECK(out[0] == 1.0);
+        std::vector<double> empty;
+        CHECK(js::parallel_inclusive_scan(empty.begin(), empty.end(),
+                                          out.begin(), pool) == out.begin());
+    }
+}
+
+namespace {
+/// Compensated sum, not default constructible
+struct KahanSum {
+    double sum;
+    double compensation;
+    explicit KahanSum(double x) : sum(x), compensation(0) {}
+};
+
+struct KahanReduce {
+    KahanSum operator()(KahanSum acc, double x) const {
+        double y = x - acc.compensation;
+        double t = acc.sum + y;
+        acc.compensation = (t - acc.sum) - y;
+        acc.sum = t;
+        return acc;
+    }
+    KahanSum operator()(KahanSum a, const KahanSum& b) const {
+        return (*this)((*this)(a, b.sum), -b.compensation);
+    }
+};
+
+struct MinIndex {
+    double value;
+    std::size_t index;
+};
+}  // end namespace
+
+TEST_CASE("Parallel transform reduce") {
+    js::ThreadPool pool(4);
+    std::vector<double> x{3, -1, 4, -1, 5, -9, 2, 6, 5};
+    std::vector<double> y{1, 2, 3, 4, 5, 6, 7, 8, 9};
+
+    SECTION("Sum of squares") {
+        auto square = [](double v) { return v * v; };
+        double expected = 0;
+        for (double v : x) expected += v * v;
+        CHECK(js::parallel_transform_reduce(x.begin(), x.end(), 0.0,
+                                            std::plus<double>(), square,
+                                            pool) == expected);
+        CHECK(js::parallel_transform_reduce(x.begin(), x.end(), 1.0,
+                                            std::plus<double>(), square,
+                                            4) == expected + 1);
+        CHECK(js::parallel_transform_reduce_auto(x.begin(), x.begin(), 7.0,
+                                                 std::plus<double>(),
+                                                 square) == 7.0);
+    }
+
+    SECTION("Dot product") {
+        double expected = std::inner_product(x.begin(), x.end(), y.begin(), 0.);
+        CHECK(js::parallel_transform_reduce(x.begin(), x.end(), y.begin(), 0.0,
+                                            pool) == expected);
+        CHECK(js::parallel_transform_reduce_auto(x.begin(), x.end(), y.begin(),
+                                                 0.0) == expected);
+        CHECK(js::parallel_transform_reduce(
+                  x.begin(), x.end(), y.begin(), 0.0, std::plus<double>(),
+                  std::multiplies<double>(), 3) == expected);
+    }
+
+    SECTION("Minimum with index") {
+        std::vector<std::size_t> index(x.size());
+        std::iota(index.begin(), index.end(), 0);
+        auto min = js::parallel_transform_reduce(
+            x.begin(), x.end(), index.begin(), MinIndex{1e300, 0},
+            [](const MinIndex& a, const MinIndex& b) {
+                return (b.value < a.value) ? b : a;
+            },
+            [](double v, std::size_t i) { return MinIndex{v, i}; }, pool);
+        CHECK(min.value == -9);
+        CHECK(min.index == 5);
+    }
+
+    SECTION("Compensated sum") {
+        std::vector<double> data(100000, 1e-16);
+        data[0] = 1;
+        CHECK(std::accumulate(data.begin(), data.end(), 0.0) == 1.0);
+        auto sum = js::parallel_transform_reduce(
+            data.begin(), data.end(), KahanSum(0), KahanReduce(),
+            [](double v) { return v; }, pool);
+        CHECK(sum.sum == Approx(1 + 99999e-16).epsilon(1e-15));
+    }
+
+    SECTION("Accumulate without zero") {
+        std::vector<std::string> words{"a", "b", "c", "d", "e"};
+        CHECK(js::parallel_accumulate(words.begin(), words.end(),
+                                      std::string(">"), 3) == ">abcde");
+        CHECK(js::parallel_accumulate(words.begin(), words.end(),
+                                      std::string(">"), 8) == ">abcde");
+        CHECK(js::parallel_accumulate(words.begin(), words.end(),
+                                      std::string(">"), pool) == ">abcde");
+    }
+}
+
+TEST_CASE("Parallel sort") {
+    js::ThreadPool pool(4);
+    std::mt19937 g(7);
+    const std::size_t n = 50000;
+    std::vector<int> random(n);
+    for (auto& x : random) x = static_cast<int>(g() % 100000);
+
+    SECTION("Sample sort") {
+        std::vector<std::vector<int>> inputs;
+        inputs.push_back(random);
+        std::vector<int> few(n);
+        for (auto& x : few) x = static_cast<int>(g() % 3);
+        inputs.push_back(few);
+        std::vector<int> sorted(random);
+        std::sort(sorted.begin(), sorted.end());
+        inputs.push_back(sorted);
+        inputs.emplace_back(sorted.rbegin(), sorted.rend());
+        inputs.push_back(std::vector<int>(n, 42));
+        inputs.emplace_back(random.begin(), random.begin() + 100);
+        for (auto& input : inputs) {
+            std::vector<int> expected(input);
+            std::sort(expected.begin(), expected.end());
+            js::parallel_sort(input.begin(), input.end(), pool);
+            CHECK(input == expected);
+        }
+        std::vector<int> descending(random);
+        js::parallel_sort_auto(descending.begin(), descending.end(),
+                               std::greater<int>());
+        CHECK(std::is_sorted(descending.begin(), descending.end(),
+                             std::greater<int>()));
+    }
+
+    SECTION("Stable sort") {
+        std::vector<std::pair<int, std::size_t>> pairs(n);
+        for (std::size_t i = 0; i != n; ++i) {
+            pairs[i] = {random[i] % 100, i};
+        }
+        auto by_key = [](const auto& a, const auto& b) {
+            return a.first < b.first;
+        };
+        auto expected = pairs;
+        std::stable_sort(expected.begin(), expected.end(), by_key);
+        js::parallel_stable_sort(pairs.begin(), pairs.end(), by_key, pool);
+        CHECK(pairs == expected);
+
+        js::ThreadPool odd_pool(3);
+        std::vector<std::string> words(n);
+        for (auto& w : words) w = std::to_string(g() % 1000);
+        auto expected_words = words;
+        std::stable_sort(expected_words.begin(), expected_words.end());
+        js::parallel_stable_sort(words.begin(), words.end(), odd_pool);
+        CHECK(words == expected_words);
+    }
+}
+
+TEST_CASE("Top k") {
+    std::mt19937 g(11);
+    std::vector<int> values(20000);
+    // Few distinct values, so ties are ordered by index
+    for (auto& x : values) x = static_cast<int>(g() % 500);
+    std::vector<std::uint32_t> full(values.size());
+    std::iota(full.begin(), full.end(), 0);
+    std::stable_sort(full.begin(), full.end(), [&](std::uint32_t a,
+                                                   std::uint32_t b) {
+        return values[a] < values[b];
+    });
+    js::ThreadPool pool(3);
+
+    for (std::size_t k : {0, 1, 7, 100, 19999, 20000, 30000}) {
+        std::size_t m = std::min(k, values.size());
+        std::vector<std::uint32_t> expected(full.begin(), full.begin() + m);
+
+        auto partial = js::index_partial_sort<std::uint32_t>(
+            values.begin(), values.end(), k);
+        CHECK(partial == expected);
+
+        auto parallel = js::parallel_index_partial_sort<std::uint32_t>(
+            values.begin(), values.end(), k, pool);
+        CHECK(parallel == expected);
+
+        auto nth = js::index_nth_element<std::uint32_t>(values.begin(),
+                                                        values.end(), k);
+        REQUIRE(nth.size() == m);
+        if (m > 0) CHECK(nth.back() == expected.back());
+        std::sort(nth.begin(), nth.end());
+        std::sort(expected.begin(), expected.end());
+        CHECK(nth == expected);
+    }
+
+    SECTION("Comparator") {
+        auto largest = js::index_partial_sort(values.begin(), values.end(), 5,
+                                              std::greater<int>());
+        std::vector<std::size_t> descending(values.size());
+        std::iota(descending.begin(), descending.end(), 0);
+        std::stable_sort(descending.begin(), descending.end(),
+                         [&](std::size_t a, std::size_t b) {
+                             return values[a] > values[b];
+                         });
+        CHECK(std::equal(largest.begin(), largest.end(),
+                         descending.begin()));
+        CHECK(js::parallel_index_partial_sort_auto(values.begin(),
+                                                   values.end(), 5,
+                                                   std::greater<int>()) ==
+              largest);
+    }
+}
+
+TEST_CASE("Permutations") {
+    std::vector<double> keys{0.5, -1, 3, 2, 0};
+    std::vector<std::string> names{"a", "b", "c", "d", "e"};
+    std::vector<int> ids{10, 11, 12, 13, 14};
+    auto index = js::index_sort(keys.begin(), keys.end());
+
+    SECTION("In place") {
+        js::apply_permutation(index.begin(), index.end(), keys.begin(),
+                              names.begin(), ids.begin());
+        CHECK(keys == (std::vector<double>{-1, 0, 0.5, 2, 3}));
+        CHECK(names == (std::vector<std::string>{"b", "e", "a", "d", "c"}));
+        CHECK(ids == (std::vector<int>{11, 14, 10, 13, 12}));
+
+        std::vector<int> not_permutation{0, 1, 1, 2, 3};
+        CHECK_THROWS_AS(js::apply_permutation(not_permutation.begin(),
+                                              not_permutation.end(),
+                                              ids.begin()),
+                        std::invalid_argument);
+        CHECK(ids == (std::vector<int>{11, 14, 10, 13, 12}));
+    }
+
+    SECTION("Large in place") {
+        std::mt19937 g(3);
+        std::vector<std::uint32_t> values(10000);
+        for (auto& v : values) v = g();
+        auto perm = js::index_sort<std::uint32_t>(values.begin(), values.end());
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        js::apply_permutation(perm.begin(), perm.end(), values.begin());
+        CHECK(values == expected);
+    }
+
+    SECTION("Out of place") {
+        js::ThreadPool pool(3);
+        std::vector<std::string> sorted_names(names.size());
+        auto end = js::apply_permutation_copy(index.begin(), index.end(),
+                                              names.begin(),
+                                              sorted_names.begin(), pool);
+        CHECK(end == sorted_names.end());
+        CHECK(sorted_names ==
+              (std::vector<std::string>{"b", "e", "a", "d", "c"}));
+
+        std::vector<double> sorted_keys(keys.size());
+        std::vector<int> sorted_ids(ids.size());
+        js::apply_permutation_copy(
+            index.begin(), index.end(),
+            js::makeIteratorTuple(keys.begin(), ids.begin()),
+            js::makeIteratorTuple(sorted_keys.begin(), sorted_ids.begin()));
+        CHECK(sorted_keys == (std::vector<double>{-1, 0, 0.5, 2, 3}));
+        CHECK(sorted_ids == (std::vector<int>{11, 14, 10, 13, 12}));
+    }
+
+    SECTION("Sort by key") {
+        js::sort_by_key(keys.begin(), keys.end(), names.begin(), ids.begin());
+        CHECK(keys == (std::vector<double>{-1, 0, 0.5, 2, 3}));
+        CHECK(names == (std::vector<std::string>{"b", "e", "a", "d", "c"}));
+        CHECK(ids == (std::vector<int>{11, 14, 10, 13, 12}));
+
+        js::sort_by_key(keys.begin(), keys.end(), std::greater<double>(),
+                        names.begin());
+        CHECK(keys == (std::vector<double>{3, 2, 0.5, 0, -1}));
+        CHECK(names == (std::vector<std::string>{"c", "d", "a", "e", "b"}));
+    }
 }
@@ -0,0 +1,117 @@
+#include "catch.hpp"
+#include "js/container.hpp"
+#include "js/memory.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+struct Id {
+    using type = int;
+};
+struct Energy {
+    using type = double;
+};
+struct Name {
+    using type = std::string;
+};
+
+struct ThrowOnCopy {
+    bool do_throw;
+    ThrowOnCopy(bool t = false) : do_throw(t) {}
+    ThrowOnCopy(const ThrowOnCopy& other) : do_throw(other.do_throw) {
+        if (do_throw) throw std::runtime_error("copy");
+    }
+    ThrowOnCopy& operator=(const ThrowOnCopy&) = default;
+};
+struct Throwing {
+    using type = ThrowOnCopy;
+};
+
+bool is_aligned(const void* ptr, std::size_t alignment) {
+    return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+}
+}  // end namespace
+
+TEST_CASE("AlignedAllocator") {
+    std::vector<char, js::AlignedAllocator<char>> vec;
+    for (int i = 0; i != 10; ++i) {
+        vec.push_back(static_cast<char>(i));
+        CHECK(is_aligned(vec.data(), js::cache_line_size));
+    }
+    std::vector<double, js::AlignedAllocator<double, 4096>> page(3);
+    CHECK(is_aligned(page.data(), 4096));
+    CHECK(js::AlignedAllocator<int>() == js::AlignedAllocator<double>());
+}
+
+TEST_CASE("SoAVector") {
+    js::SoAVector<Id, Energy, Name> soa;
+    CHECK(soa.empty());
+    soa.emplace_back(3, 0.5, "c");
+    soa.push_back(std::make_tuple(1, 1.5, std::string("a")));
+    soa.push_back(js::TaggedTuple<Id, Energy, Name>(2, 2.5, "b"));
+    REQUIRE(soa.size() == 3);
+
+    SECTION("Columns") {
+        auto& ids = js::get<Id>(soa);
+        CHECK(std::vector<int>(ids.begin(), ids.end()) ==
+              (std::vector<int>{3, 1, 2}));
+        double sum = std::accumulate(js::get<Energy>(soa).begin(),
+                                     js::get<Energy>(soa).end(), 0.0);
+        CHECK(sum == 4.5);
+        CHECK(is_aligned(soa.data<Id>(), js::cache_line_size));
+        CHECK(is_aligned(soa.data<Energy>(), js::cache_line_size));
+        const auto& csoa = soa;
+        CHECK(js::get<Name>(csoa)[2] == "b");
+    }
+
+    SECTION("Rows") {
+        auto row = soa[1];
+        CHECK(js::get<Id>(row) == 1);
+        CHECK(js::get<Name>(row) == "a");
+        js::get<Energy>(soa[1]) = 10;
+        CHECK(soa.column<Energy>()[1] == 10);
+        soa[0] = soa[2];
+        CHECK(js::get<Id>(soa[0]) == 2);
+        CHECK(js::get<Name>(soa.back()) == "b");
+        const auto& csoa = soa;
+        CHECK(std::get<0>(csoa[2]) == 2);
+    }
+
+    SECTION("Iteration and sorting") {
+        std::sort(soa.begin(), soa.end(), [](const auto& a, const auto& b) {
+            return std::get<0>(a) < std::get<0>(b);
+        });
+        CHECK(soa.end() - soa.begin() == 3);
+        std::vector<std::string> names;
+        for (auto it = soa.cbegin(); it != soa.cend(); ++it) {
+            names.push_back(std::get<2>(*it));
+        }
+        CHECK(names == (std::vector<std::string>{"a", "b", "c"}));
+        CHECK(soa.column<Energy>()[0] == 1.5);
+    }
+
+    SECTION("Capacity") {
+        soa.reserve(100);
+        CHECK(soa.capacity() >= 100);
+        soa.pop_back();
+        CHECK(soa.size() == 2);
+        soa.resize(5);
+        CHECK(js::get<Id>(soa[4]) == 0);
+        CHECK(js::get<Name>(soa[4]).empty());
+        soa.clear();
+        CHECK(soa.empty());
+    }
+}
+
+TEST_CASE("SoAVector strong exception guarantee") {
+    js::SoAVector<Id, Throwing> soa;
+    soa.emplace_back(1, ThrowOnCopy(false));
+    ThrowOnCopy bad(true);
+    CHECK_THROWS_AS(soa.emplace_back(2, bad), std::runtime_error);
+    CHECK(soa.size() == 1);
+    CHECK(soa.column<Id>().size() == 1);
+}
@@ -1,6 +1,8 @@
 #include "catch.hpp"
 #include "js/iterator.hpp"
+#include <algorithm>
 #include <array>
+#include <list>
 #include <type_traits>
 #include <vector>
 
@@ -70,6 +72,56 @@ TEST_CASE("IteratorTuple") {
     }
 }
 
+TEST_CASE("IteratorTuple random access") {
+    std::vector<int> vec{10, 11, 12, 13};
+    std::array<double, 4> arr{20, 21, 22, 23};
+    auto begin = js::makeIteratorTuple(vec.begin(), arr.begin());
+    auto end = js::makeIteratorTuple(vec.end(), arr.end());
+
+    SECTION("Iterator category") {
+        auto is_random_access =
+            std::is_same<std::iterator_traits<decltype(begin)>::iterator_category,
+                         std::random_access_iterator_tag>::value;
+        CHECK(is_random_access);
+        std::list<int> list{1, 2, 3, 4};
+        auto list_iter = js::makeIteratorTuple(vec.begin(), list.begin());
+        auto is_bidirectional = std::is_same<
+            std::iterator_traits<decltype(list_iter)>::iterator_category,
+            std::bidirectional_iterator_tag>::value;
+        CHECK(is_bidirectional);
+    }
+
+    SECTION("Arithmetic") {
+        CHECK(end - begin == 4);
+        auto third = begin + 2;
+        CHECK(std::get<0>(*third) == 12);
+        CHECK(std::get<1>(begin[3]) == 23);
+        CHECK(third - 2 == begin);
+        CHECK(begin < third);
+        CHECK(third >= begin);
+        third -= 1;
+        CHECK(std::get<0>(*third) == 11);
+        CHECK(1 + begin == third);
+    }
+
+    SECTION("Sorting zipped ranges") {
+        std::vector<int> keys{3, 1, 4, 1, 5, 9, 2, 6};
+        std::vector<char> values{'c', 'a', 'd', 'b', 'e', 'h', 'x', 'g'};
+        js::ZipBase<std::vector<int>, std::vector<char>> zip(keys, values);
+        CHECK(zip.size() == 8);
+        std::stable_sort(zip.begin(), zip.end(),
+                         [](const auto& a, const auto& b) {
+                             return std::get<0>(a) < std::get<0>(b);
+                         });
+        CHECK(keys == (std::vector<int>{1, 1, 2, 3, 4, 5, 6, 9}));
+        CHECK(values ==
+              (std::vector<char>{'a', 'b', 'x', 'c', 'd', 'e', 'g', 'h'}));
+        std::sort(zip.begin(), zip.end());
+        CHECK(values ==
+              (std::vector<char>{'a', 'b', 'x', 'c', 'd', 'e', 'g', 'h'}));
+    }
+}
+
 TEST_CASE("ZipBase") {
     using VectorInt = std::vector<int>;
     using ArrayInt = std::array<int, 3>;
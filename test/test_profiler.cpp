@@ -0,0 +1,82 @@
+#include "catch.hpp"
+#include "js/profiler.hpp"
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+void profiled_leaf() { JS_PROFILE_SCOPE("leaf"); }
+
+void profiled_inner(int n) {
+    JS_PROFILE_SCOPE("inner \"quoted\"");
+    for (int i = 0; i != n; ++i) {
+        profiled_leaf();
+    }
+}
+
+void profiled_outer() {
+    JS_PROFILE_FUNCTION();
+    profiled_inner(3);
+    profiled_leaf();
+}
+
+std::size_t count(const std::string& str, const std::string& sub) {
+    std::size_t n = 0;
+    for (auto pos = str.find(sub); pos != std::string::npos;
+         pos = str.find(sub, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+}  // end namespace
+
+TEST_CASE("Profiler") {
+    js::Profiler::reset();
+
+    SECTION("Disabled") {
+        js::Profiler::disable();
+        profiled_outer();
+        std::ostringstream flat;
+        js::Profiler::report_flat(flat);
+        CHECK(count(flat.str(), "leaf") == 0);
+    }
+
+    SECTION("Reports") {
+        js::Profiler::enable(true);
+        profiled_outer();
+        std::thread t([]() {
+            profiled_outer();
+            profiled_leaf();
+        });
+        t.join();
+        js::Profiler::disable();
+
+        std::ostringstream flat;
+        js::Profiler::report_flat(flat);
+        std::string flat_str = flat.str();
+        CHECK(count(flat_str, "leaf") == 1);
+        CHECK(count(flat_str, "profiled_outer") == 1);
+        // 2 * (3 + 1) + 1 calls of the leaf
+        CHECK(count(flat_str, "           9") == 1);
+
+        std::ostringstream tree;
+        js::Profiler::report_tree(tree);
+        std::string tree_str = tree.str();
+        // Leaf below inner, below outer and directly at the root
+        CHECK(count(tree_str, "leaf") == 3);
+        CHECK(count(tree_str, "      leaf") == 1);
+
+        std::ostringstream trace;
+        js::Profiler::write_chrome_trace(trace);
+        std::string trace_str = trace.str();
+        CHECK(count(trace_str, "\"ph\":\"X\"") == 2 * (1 + 1 + 4) + 1);
+        CHECK(count(trace_str, "inner \\\"quoted\\\"") == 2);
+        CHECK(trace_str.front() == '{');
+
+        js::Profiler::reset();
+        std::ostringstream after_reset;
+        js::Profiler::report_flat(after_reset);
+        CHECK(count(after_reset.str(), "leaf") == 0);
+    }
+}
@@ -0,0 +1,362 @@
+#include "catch.hpp"
+#include "js/random.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace {
+template <class Sampler>
+void check_moments(Sampler sampler, double mean, double variance) {
+    const int samples = 20000;
+    double sum = 0;
+    double sum_sq = 0;
+    for (int i = 0; i != samples; ++i) {
+        double x = sampler();
+        sum += x;
+        sum_sq += x * x;
+    }
+    double sample_mean = sum / samples;
+    double sample_var = sum_sq / samples - sample_mean * sample_mean;
+    CHECK(sample_mean == Approx(mean).epsilon(0.02));
+    CHECK(sample_var == Approx(variance).epsilon(0.1));
+}
+}  // end namespace
+
+TEST_CASE("Binomial samplers") {
+    std::mt19937_64 g(1234);
+    SECTION("Inversion") {
+        check_moments([&g]() { return js::detail::binomial(g, 20, 0.3); },
+                      6.0, 4.2);
+    }
+    SECTION("BTPE") {
+        check_moments([&g]() { return js::detail::binomial(g, 1000, 0.4); },
+                      400.0, 240.0);
+    }
+    SECTION("Flipped probability") {
+        check_moments([&g]() { return js::detail::binomial(g, 500, 0.9); },
+                      450.0, 45.0);
+    }
+    SECTION("Edge cases") {
+        CHECK(js::detail::binomial(g, 10, 0.0) == 0);
+        CHECK(js::detail::binomial(g, 10, 1.0) == 10);
+        CHECK(js::detail::binomial(g, 0, 0.5) == 0);
+    }
+}
+
+TEST_CASE("MultinomialDistribution") {
+    std::mt19937_64 g(42);
+    std::array<double, 4> prob = {0.1, 0.2, 0.3, 0.4};
+    js::MultinomialDistribution<4> dist(1000, prob);
+
+    SECTION("Samples sum up to trials") {
+        auto sample = dist(g);
+        CHECK(std::accumulate(sample.begin(), sample.end(), 0) == 1000);
+    }
+
+    SECTION("generate") {
+        std::vector<std::array<int, 4>> samples(500);
+        auto last = dist.generate(g, samples.data(), samples.size());
+        CHECK(last == samples.data() + samples.size());
+        std::array<double, 4> mean{};
+        for (const auto& s : samples) {
+            CHECK(std::accumulate(s.begin(), s.end(), 0) == 1000);
+            for (std::size_t i = 0; i != 4; ++i) {
+                mean[i] += s[i] / 500.0;
+            }
+        }
+        for (std::size_t i = 0; i != 4; ++i) {
+            CHECK(mean[i] == Approx(1000 * prob[i]).epsilon(0.02));
+        }
+    }
+
+    SECTION("Few trials") {
+        // Counts categorical draws from the alias table
+        js::MultinomialDistribution<4> few(3, prob);
+        std::array<double, 4> mean{};
+        for (int k = 0; k != 20000; ++k) {
+            auto s = few(g);
+            CHECK(std::accumulate(s.begin(), s.end(), 0) == 3);
+            for (std::size_t i = 0; i != 4; ++i) mean[i] += s[i] / 20000.0;
+        }
+        for (std::size_t i = 0; i != 4; ++i) {
+            CHECK(mean[i] == Approx(3 * prob[i]).epsilon(0.05));
+        }
+        js::MultinomialDistribution<4> none(0, prob);
+        CHECK(none(g) == (std::array<int, 4>{{0, 0, 0, 0}}));
+    }
+
+    SECTION("Default and parameters") {
+        js::MultinomialDistribution<4> default_dist;
+        auto sample = default_dist(g);
+        CHECK(std::accumulate(sample.begin(), sample.end(), 0) == 1);
+        default_dist.param(dist.param());
+        CHECK(default_dist == dist);
+    }
+}
+
+TEST_CASE("Philox4x32") {
+    SECTION("Known answers") {
+        // Test vectors of the Random123 library
+        using block = std::array<std::uint32_t, 4>;
+        using key = std::array<std::uint32_t, 2>;
+        CHECK(js::detail::philox4x32_10(block{{0, 0, 0, 0}}, key{{0, 0}}) ==
+              (block{{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}}));
+        CHECK(js::detail::philox4x32_10(
+                  block{{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}},
+                  key{{0xffffffff, 0xffffffff}}) ==
+              (block{{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}}));
+        CHECK(js::detail::philox4x32_10(
+                  block{{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}},
+                  key{{0xa4093822, 0x299f31d0}}) ==
+              (block{{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}));
+        js::Philox4x32 g(0);
+        CHECK(g() == 0xe169c58d6627e8d5);
+        CHECK(g() == 0x9b00dbd8bc57ac4c);
+    }
+
+    SECTION("Engine concept") {
+        js::Philox4x32 g1(42, 3);
+        js::Philox4x32 g2(42, 3);
+        CHECK(g1 == g2);
+        std::vector<std::uint64_t> seq(100);
+        for (auto& x : seq) x = g1();
+        CHECK(g1 != g2);
+        g2.discard(37);
+        CHECK(g2() == seq[37]);
+        g2.discard(50);
+        CHECK(g2() == seq[88]);
+        g2.discard(11);
+        CHECK(g1 == g2);
+
+        std::stringstream state;
+        g2.discard(3);
+        state << g2;
+        js::Philox4x32 g3;
+        state >> g3;
+        CHECK(g3 == g2);
+        CHECK(g3() == g2());
+
+        std::seed_seq seq1{1, 2, 3};
+        std::seed_seq seq2{1, 2, 3};
+        js::Philox4x32 g4(seq1);
+        g3.seed(seq2);
+        CHECK(g3 == g4);
+    }
+
+    SECTION("Positions beyond 2^64") {
+        js::Philox4x32 g1(11);
+        js::Philox4x32 g2(11);
+        g1.discard(std::numeric_limits<unsigned long long>::max());
+        g1.discard(3);
+        // 2^64 + 2 numbers are 2^63 + 1 blocks
+        std::stringstream state("11 0 9223372036854775809 0");
+        state >> g2;
+        CHECK(g1 == g2);
+        CHECK(g1() == g2());
+        std::stringstream out;
+        out << g1;
+        CHECK(out.str() == "11 0 9223372036854775809 1");
+        js::Philox4x32 g3(11);
+        CHECK(g3 != g2);
+    }
+
+    SECTION("Bulk fill") {
+        js::Philox4x32 g1(7);
+        js::Philox4x32 g2(7);
+        // Unaligned start and odd lengths
+        for (std::size_t n : {3, 40, 1, 17, 0, 100}) {
+            std::vector<std::uint64_t> bulk(n);
+            g1.fill(bulk.data(), n);
+            for (auto x : bulk) CHECK(x == g2());
+        }
+        CHECK(g1 == g2);
+    }
+
+    SECTION("Streams") {
+        js::Philox4x32 g1(5, 0);
+        js::Philox4x32 g2(5, 1);
+        int equal = 0;
+        for (int i = 0; i != 1000; ++i) equal += g1() == g2();
+        CHECK(equal == 0);
+        g1.stream(1);
+        g2.stream(1);
+        CHECK(g1 == g2);
+        CHECK(g1.stream() == 1);
+        CHECK(g1.key() == 5);
+        std::uniform_real_distribution<double> uniform;
+        check_moments([&]() { return uniform(g1); }, 0.5, 1. / 12);
+    }
+}
+
+TEST_CASE("DiscreteAliasDistribution") {
+    std::mt19937_64 g(99);
+    const std::vector<double> weights{1, 0, 3, 2, 0.5, 1.5};
+    js::DiscreteAliasDistribution<> dist(weights.begin(), weights.end());
+    std::discrete_distribution<> reference(weights.begin(), weights.end());
+    CHECK(dist.min() == 0);
+    CHECK(dist.max() == 5);
+    auto prob = dist.probabilities();
+    auto ref_prob = reference.probabilities();
+    for (std::size_t i = 0; i != prob.size(); ++i) {
+        CHECK(prob[i] == Approx(ref_prob[i]));
+    }
+
+    SECTION("Frequencies") {
+        const int samples = 60000;
+        std::vector<int> out(samples);
+        auto last = dist.generate(g, out.begin(), out.size());
+        CHECK(last == out.end());
+        std::vector<double> freq(weights.size());
+        for (int x : out) freq.at(x) += 1. / samples;
+        for (std::size_t i = 0; i != freq.size(); ++i) {
+            CHECK(freq[i] == Approx(prob[i]).margin(0.01));
+        }
+        CHECK(freq[1] == 0);
+        const double mean = 21.5 / 8;
+        check_moments([&]() { return dist(g); }, mean,
+                      75.5 / 8 - mean * mean);
+    }
+
+    SECTION("Parameters") {
+        js::DiscreteAliasDistribution<> single;
+        CHECK(single(g) == 0);
+        CHECK(single.max() == 0);
+        js::DiscreteAliasDistribution<> list{1, 1};
+        std::stringstream state;
+        state << dist;
+        state >> list;
+        CHECK(list.max() == 5);
+        list.param(dist.param());
+        CHECK(list == dist);
+        CHECK(list != single);
+        CHECK_THROWS_AS(js::DiscreteAliasDistribution<>({1, -1}),
+                        std::invalid_argument);
+        CHECK_THROWS_AS(js::DiscreteAliasDistribution<>({0, 0}),
+                        std::invalid_argument);
+    }
+}
+
+TEST_CASE("DynamicMultinomialDistribution") {
+    std::mt19937_64 g(5);
+    // Unsorted probabilities with a long tail
+    std::vector<double> prob(1000, 0.1 / 997);
+    prob[10] = 0.5;
+    prob[500] = 0.1;
+    prob[999] = 0.3;
+
+    for (int trials : {1, 50, 1999, 2001, 100000}) {
+        js::DynamicMultinomialDistribution<> dist(trials, prob);
+        CHECK(dist.size() == 1000);
+        CHECK(dist.max_val() == trials);
+        std::vector<double> mean(prob.size());
+        const int samples = 400;
+        std::vector<std::vector<int>> rows(samples, std::vector<int>(1000));
+        dist.generate(g, rows.begin(), samples);
+        for (const auto& s : rows) {
+            CHECK(std::accumulate(s.begin(), s.end(), 0) == trials);
+            for (std::size_t i = 0; i != s.size(); ++i) {
+                mean[i] += s[i] / double(samples);
+            }
+        }
+        for (std::size_t i : {10, 500, 999}) {
+            CHECK(mean[i] == Approx(trials * prob[i]).epsilon(0.1).margin(1));
+        }
+
+        std::vector<std::pair<std::size_t, int>> sparse;
+        dist.sparse(g, std::back_inserter(sparse));
+        int total = 0;
+        for (const auto& entry : sparse) {
+            CHECK(entry.first < 1000);
+            CHECK(entry.second > 0);
+            total += entry.second;
+        }
+        CHECK(total == trials);
+        CHECK(sparse.size() <= static_cast<std::size_t>(trials));
+        auto dense = dist(g);
+        CHECK(std::accumulate(dense.begin(), dense.end(), 0) == trials);
+    }
+
+    SECTION("Parameters") {
+        js::DynamicMultinomialDistribution<> dist(10, {0.2, 0.3, 0.5});
+        js::DynamicMultinomialDistribution<> copy(1, {1.0});
+        std::stringstream state;
+        state << dist;
+        state >> copy;
+        CHECK(copy == dist);
+        CHECK(copy.param().trials() == 10);
+        CHECK(copy.param().probabilities().size() == 3);
+        copy.param(js::DynamicMultinomialDistribution<>(5, {1.0}).param());
+        CHECK(copy != dist);
+        CHECK(copy(g) == std::vector<int>{5});
+        js::DynamicMultinomialDistribution<> none(0, {0.5, 0.5});
+        CHECK(none(g) == (std::vector<int>{0, 0}));
+    }
+
+    SECTION("Relative weights") {
+        // Weights summing to 10, with the alias path and the chain
+        for (int trials : {6, 1000}) {
+            js::DynamicMultinomialDistribution<> dist(trials, {2, 3, 5});
+            std::vector<double> mean(3);
+            for (int k = 0; k != 2000; ++k) {
+                auto row = dist(g);
+                for (std::size_t i = 0; i != 3; ++i) mean[i] += row[i];
+            }
+            CHECK(mean[0] / 2000 == Approx(0.2 * trials).epsilon(0.05));
+            CHECK(mean[2] / 2000 == Approx(0.5 * trials).epsilon(0.05));
+        }
+    }
+}
+
+TEST_CASE("Seeding") {
+    SECTION("System entropy") {
+        std::uint64_t s1 = js::seed64();
+        std::uint64_t s2 = js::seed64();
+        std::uint32_t s3 = js::seed32();
+        CHECK((s1 != s2 || s2 != s3));
+        std::vector<std::uint64_t> seeds(1000);
+        js::fill_seeds(seeds.begin(), seeds.end());
+        std::sort(seeds.begin(), seeds.end());
+        CHECK(std::unique(seeds.begin(), seeds.end()) == seeds.end());
+
+        std::vector<std::uint32_t> words(8);
+        js::fill_seeds(words.begin(), words.end());
+        std::seed_seq seq(words.begin(), words.end());
+        std::mt19937 g(seq);
+        g();
+    }
+
+    SECTION("SeedExpander") {
+        js::SeedExpander seq1{1, 2, 3};
+        js::SeedExpander seq2{1, 2, 3};
+        js::SeedExpander other{1, 2, 4};
+        CHECK(seq1.size() == 3);
+        std::vector<std::uint32_t> values;
+        seq1.param(std::back_inserter(values));
+        CHECK(values == (std::vector<std::uint32_t>{1, 2, 3}));
+
+        // Same initial values give the same engines, each call continues
+        std::mt19937_64 g1(seq1);
+        std::mt19937_64 g2(seq2);
+        std::mt19937_64 g3(seq1);
+        std::mt19937_64 g4(other);
+        CHECK(g1 == g2);
+        CHECK(g1 != g3);
+        CHECK(g1 != g4);
+        CHECK(js::SeedExpander{5}() == js::SeedExpander{5}());
+
+        js::SeedExpander entropy = js::SeedExpander::from_entropy();
+        CHECK(entropy.size() == 2);
+        std::vector<std::uint64_t> seeds(1000);
+        for (auto& s : seeds) s = entropy();
+        std::sort(seeds.begin(), seeds.end());
+        CHECK(std::unique(seeds.begin(), seeds.end()) == seeds.end());
+    }
+}
@@ -0,0 +1,663 @@
+#include "catch.hpp"
+#include "js/stream.hpp"
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+std::string read_file(const std::string& name) {
+    std::ifstream file(name);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+}  // end namespace
+
+TEST_CASE("AsyncFileHandler") {
+    std::stringstream expected;
+    for (int i = 0; i != 10000; ++i) {
+        expected << i << " " << 0.5 * i << "\n";
+    }
+
+    SECTION("Write and close") {
+        std::string name;
+        {
+            // Small buffers to exercise the hand over and backpressure
+            js::detail::AsyncFileHandler handler(-42, 64, 2);
+            handler.open("test_async_output", "txt");
+            name = handler.getFilename();
+            for (int i = 0; i != 10000; ++i) {
+                handler << i << " " << 0.5 * i << "\n";
+            }
+            handler.close();
+        }
+        CHECK(read_file(name) == expected.str());
+        std::remove(name.c_str());
+    }
+
+    SECTION("Flush and destructor") {
+        std::string name;
+        {
+            js::detail::AsyncFileHandler handler("test_async_output", "txt");
+            name = handler.getFilename();
+            handler << "first line\n";
+            handler.flush();
+            CHECK(read_file(name) == "first line\n");
+            handler << "second line\n";
+        }
+        CHECK(read_file(name) == "first line\nsecond line\n");
+        std::remove(name.c_str());
+    }
+}
+
+namespace {
+struct Position {
+    using type = double;
+    static constexpr const char* name = "position";
+};
+struct Count {
+    using type = int;
+    static constexpr const char* name = "count";
+};
+struct Flag {
+    using type = bool;
+};
+}  // end namespace
+
+TEST_CASE("Binary record files") {
+    std::string name;
+    {
+        js::detail::TaggedBinaryFileHandler<Position, Count, Flag> handler(
+            "test_binary_output", "bin");
+        name = handler.getFilename();
+        CHECK(handler.record_size() == 16);
+        for (int i = 0; i != 100; ++i) {
+            handler << js::TaggedTuple<Position, Count, Flag>(
+                std::make_tuple(0.5 * i, i, i % 2 == 0));
+        }
+        handler.write(1.5, -1, false);
+        CHECK(handler.size() == 101);
+    }
+
+    js::BinaryFileReader reader(name);
+    REQUIRE(reader.size() == 101);
+    REQUIRE(reader.fields().size() == 3);
+    CHECK(reader.fields()[0].name == "position");
+    CHECK(reader.fields()[0].type == js::BinaryType::float64);
+    CHECK(reader.fields()[1].name == "count");
+    CHECK(reader.fields()[1].type == js::BinaryType::int32);
+    CHECK(reader.fields()[2].name == "field2");
+    CHECK(reader.fields()[2].type == js::BinaryType::boolean);
+
+    SECTION("Access values") {
+        std::size_t count = reader.field_index("count");
+        CHECK(reader.get<int>(42, count) == 42);
+        CHECK(reader.get<double>(42, 0) == 21.0);
+        CHECK(reader.row<double, int, bool>(100) ==
+              std::make_tuple(1.5, -1, false));
+        CHECK_THROWS_AS(reader.get<float>(0, 0), std::invalid_argument);
+    }
+
+    SECTION("Read column") {
+        std::vector<int> counts;
+        reader.column<int>(1, std::back_inserter(counts));
+        REQUIRE(counts.size() == 101);
+        CHECK(counts[7] == 7);
+    }
+
+    SECTION("Corrupted header") {
+        std::string corrupt;
+        {
+            js::detail::BinaryFileHandler<long, long> handler;
+            handler.open("test_binary_corrupt", "bin");
+            corrupt = handler.getFilename();
+            handler.write(1, 2);
+        }
+        CHECK(js::BinaryFileReader(corrupt).row<long, long>(0) ==
+              std::make_tuple(1L, 2L));
+        // offset of the first field so that it ends behind the record
+        std::string bytes = read_file(corrupt);
+        std::uint32_t offset = 12;
+        std::memcpy(&bytes[36], &offset, sizeof(offset));
+        std::ofstream(corrupt, std::ios::binary) << bytes;
+        CHECK_THROWS_AS(js::BinaryFileReader{corrupt}, std::runtime_error);
+        std::remove(corrupt.c_str());
+    }
+    std::remove(name.c_str());
+}
+
+TEST_CASE("MappedFile") {
+    const std::string name = "test_mapped_file.bin";
+    std::remove(name.c_str());
+    {
+        js::MappedFile out(name, js::MappedFile::Mode::read_write);
+        CHECK(out.is_open());
+        CHECK(out.empty());
+        for (std::uint64_t i = 0; i != 1000; ++i) {
+            CHECK(out.append(&i, sizeof(i)) == i * sizeof(i));
+        }
+        CHECK(out.size() == 8000);
+        CHECK(out.capacity() >= out.size());
+        auto values = out.writable_span<std::uint64_t>();
+        REQUIRE(values.size() == 1000);
+        values[999] = 42;
+        // Shrink and grow again, the new bytes are zero
+        out.resize(7992);
+        out.resize(8000);
+        CHECK(out.span<std::uint64_t>().back() == 0);
+        out.writable_span<std::uint64_t>(7992).front() = 4242;
+    }
+
+    std::ifstream in(name, std::ios::binary | std::ios::ate);
+    CHECK(in.tellg() == 8000);
+
+    js::MappedFile file(name, js::MappedFile::Mode::read,
+                        js::AccessHint::sequential);
+    REQUIRE(file.size() == 8000);
+    auto values = file.span<std::uint64_t>();
+    REQUIRE(values.size() == 1000);
+    CHECK(values[0] == 0);
+    CHECK(values[998] == 998);
+    CHECK(values.back() == 4242);
+    std::uint64_t sum = 0;
+    for (auto x : values.subspan(10, 5)) sum += x;
+    CHECK(sum == 10 + 11 + 12 + 13 + 14);
+    file.advise(js::AccessHint::random, 100, 1000);
+
+    CHECK(file.span<std::uint32_t>(4, 3).size() == 3);
+    CHECK_THROWS_AS(file.span<std::uint64_t>(4), std::invalid_argument);
+    CHECK_THROWS_AS(file.span<std::uint64_t>(0, 1001), std::out_of_range);
+    CHECK_THROWS_AS(file.writable_data(), std::runtime_error);
+    CHECK_THROWS_AS(file.resize(10), std::runtime_error);
+
+    js::MappedFile moved(std::move(file));
+    CHECK(!file.is_open());
+    CHECK(moved.span<std::uint64_t>()[5] == 5);
+    moved.close();
+    CHECK(!moved.is_open());
+    CHECK_THROWS_AS(js::MappedFile("does/not/exist"), std::runtime_error);
+    std::remove(name.c_str());
+}
+
+TEST_CASE("File name discovery") {
+    const std::string base = "test_free_name";
+    std::vector<std::string> created;
+    for (std::size_t i = 0; i != 37; ++i) {
+        created.push_back(js::detail::numbered_filename(base, "txt", i));
+        std::ofstream(created.back()) << i;
+    }
+    CHECK(created[0] == "test_free_name.txt");
+    CHECK(created[3] == "test_free_name-3.txt");
+    CHECK(js::detail::free_file_index(base, "txt", 0) == 37);
+    CHECK(js::detail::free_file_index(base, "txt", 40) == 40);
+    CHECK(js::detail::free_filename(base, "txt", -42) ==
+          "test_free_name-37.txt");
+    CHECK_THROWS_AS(js::detail::free_filename(base, "txt", 10),
+                    std::runtime_error);
+
+    std::string name;
+    int fd = js::detail::create_free_file(base, "txt", -42, name);
+    CHECK(fd != -1);
+    CHECK(name == "test_free_name-37.txt");
+    ::close(fd);
+    created.push_back(name);
+    {
+        js::detail::BasicFileHandler handler(base, "txt");
+        CHECK(handler.getFilename() == "test_free_name-38.txt");
+        created.push_back(handler.getFilename());
+    }
+    for (const auto& n : created) std::remove(n.c_str());
+}
+
+TEST_CASE("RotatingFileHandler") {
+    std::stringstream expected;
+    for (int i = 0; i != 1000; ++i) {
+        expected << "line " << i << "\n";
+    }
+
+    SECTION("By size") {
+        js::RotationPolicy policy;
+        policy.max_bytes = 1000;
+        std::vector<std::string> files;
+        {
+            js::RotatingFileHandler handler("test_rotating", "txt", policy);
+            for (int i = 0; i != 1000; ++i) {
+                handler << "line " << i << "\n";
+            }
+            files = handler.files();
+        }
+        REQUIRE(files.size() > 5);
+        CHECK(files[0] == "test_rotating.txt");
+        CHECK(files[1] == "test_rotating-1.txt");
+        std::string all;
+        for (const auto& name : files) {
+            std::string content = read_file(name);
+            CHECK(content.size() < 1000 + 10);
+            CHECK(content.back() == '\n');
+            all += content;
+            std::remove(name.c_str());
+        }
+        CHECK(all == expected.str());
+    }
+
+    SECTION("By time") {
+        js::RotationPolicy policy;
+        policy.max_age = std::chrono::nanoseconds(1);
+        js::RotatingFileHandler handler("test_rotating", "txt", policy);
+        handler << "first" << std::endl;
+        handler << "second\n";
+        handler << 'a' << 'b' << '\n';
+        handler.close();
+        auto files = handler.files();
+        REQUIRE(files.size() == 3);
+        CHECK(read_file(files[0]) == "first\n");
+        CHECK(read_file(files[1]) == "second\n");
+        CHECK(read_file(files[2]) == "ab\n");
+        for (const auto& name : files) std::remove(name.c_str());
+    }
+
+    SECTION("Sharded") {
+        js::RotationPolicy policy;
+        policy.max_bytes = 4096;
+        js::ShardedFileHandler sharded("test_sharded", "txt", policy);
+        std::vector<std::thread> threads;
+        for (int t = 0; t != 4; ++t) {
+            threads.emplace_back([&sharded, t]() {
+                for (int i = 0; i != 1000; ++i) {
+                    sharded.local() << t << " " << i << "\n";
+                }
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        CHECK(sharded.shards() == 4);
+        sharded.close();
+        std::vector<int> lines(4);
+        for (const auto& name : sharded.files()) {
+            std::stringstream content(read_file(name));
+            int t, i, shard_thread = -1;
+            while (content >> t >> i) {
+                // Every file holds the lines of a single thread in order
+                if (shard_thread == -1) shard_thread = t;
+                CHECK(t == shard_thread);
+                CHECK(i == lines[t]++);
+            }
+            std::remove(name.c_str());
+        }
+        CHECK(lines == (std::vector<int>{1000, 1000, 1000, 1000}));
+    }
+
+    SECTION("Alternating sharded handlers") {
+        std::vector<std::string> files;
+        for (int round = 0; round != 3; ++round) {
+            js::ShardedFileHandler a("test_sharded_a", "txt");
+            js::ShardedFileHandler b("test_sharded_b", "txt");
+            for (int i = 0; i != 10; ++i) {
+                a.local() << i << "\n";
+                b.local() << i << "\n";
+            }
+            // Same thread, one shard each despite the cache misses
+            CHECK(a.shards() == 1);
+            CHECK(b.shards() == 1);
+            a.close();
+            b.close();
+            CHECK(read_file(a.files()[0]) == read_file(b.files()[0]));
+            for (const auto& name : a.files()) std::remove(name.c_str());
+            for (const auto& name : b.files()) std::remove(name.c_str());
+        }
+    }
+}
+
+TEST_CASE("Compressed files") {
+    std::string text;
+    for (int i = 0; i != 20000; ++i) {
+        text += "line " + std::to_string(i) + " " + std::to_string(i % 7) +
+                "\n";
+    }
+
+    SECTION("LZ codec") {
+        for (std::size_t size : {0, 1, 3, 4, 17, 1000, 100000}) {
+            std::string raw = text.substr(0, size);
+            std::vector<char> compressed;
+            js::detail::lz_compress(raw.data(), raw.size(), compressed);
+            std::string restored(raw.size(), '\0');
+            js::detail::lz_decompress(compressed.data(), compressed.size(),
+                                      &restored[0], restored.size());
+            CHECK(restored == raw);
+        }
+        std::string runs(5000, 'a');
+        std::vector<char> compressed;
+        js::detail::lz_compress(runs.data(), runs.size(), compressed);
+        CHECK(compressed.size() < 100);
+        std::string restored(runs.size(), '\0');
+        js::detail::lz_decompress(compressed.data(), compressed.size(),
+                                  &restored[0], restored.size());
+        CHECK(restored == runs);
+        CHECK_THROWS_AS(js::detail::lz_decompress(compressed.data(),
+                                                  compressed.size(),
+                                                  &restored[0], 4000),
+                        std::runtime_error);
+    }
+
+    SECTION("Write and read") {
+        js::ThreadPool pool(3);
+        for (js::Codec codec :
+             {js::Codec::stored, js::Codec::lz, js::detail::default_codec()}) {
+            std::string name;
+            {
+                js::CompressedFileHandler out("test_compressed", "jsz",
+                                              4096, codec, pool);
+                name = out.getFilename();
+                out.write(text.data(), text.size() / 2);
+                out.flush();
+                out << text.substr(text.size() / 2);
+            }
+            js::CompressedFileReader in(name);
+            CHECK(in.size() == text.size());
+            CHECK(in.blocks() == (text.size() + 4095) / 4096 + 1);
+            if (codec != js::Codec::stored) {
+                CHECK(in.compressed_size() < text.size() / 2);
+            }
+            CHECK(in.str(pool) == text);
+            std::string part(10000, '\0');
+            in.read(3000, part.size(), &part[0]);
+            CHECK(part == text.substr(3000, part.size()));
+            CHECK_THROWS_AS(in.read(in.size() - 1, 2, &part[0]),
+                            std::out_of_range);
+            // Little endian block size after the magic
+            std::string raw = read_file(name);
+            CHECK(raw.substr(8, 4) == std::string("\0\x10\0\0", 4));
+            std::remove(name.c_str());
+        }
+    }
+
+    SECTION("Empty and invalid files") {
+        std::string name;
+        {
+            js::CompressedFileHandler out("test_compressed", "jsz");
+            name = out.getFilename();
+        }
+        js::CompressedFileReader in(name);
+        CHECK(in.size() == 0);
+        CHECK(in.blocks() == 0);
+        CHECK(in.str().empty());
+        std::remove(name.c_str());
+        {
+            js::CompressedFileHandler out("test_compressed", "jsz");
+            name = out.getFilename();
+            out << "some text";
+        }
+        {
+            // Block header does not match the index
+            std::fstream file(name, std::ios::in | std::ios::out |
+                                        std::ios::binary);
+            file.seekp(16 + 4);
+            file.put('\x7f');
+        }
+        CHECK_THROWS_AS(js::CompressedFileReader(name), std::runtime_error);
+        std::remove(name.c_str());
+        std::ofstream("test_compressed.txt") << "no compressed file";
+        CHECK_THROWS_AS(js::CompressedFileReader("test_compressed.txt"),
+                        std::runtime_error);
+        std::remove("test_compressed.txt");
+    }
+}
+
+TEST_CASE("Number formatting") {
+    SECTION("Integers") {
+        CHECK(js::format_number(0) == "0");
+        CHECK(js::format_number(-7) == "-7");
+        CHECK(js::format_number(100u) == "100");
+        CHECK(js::format_number(std::int64_t(-9223372036854775807 - 1)) ==
+              "-9223372036854775808");
+        CHECK(js::format_number(std::uint64_t(18446744073709551615u)) ==
+              "18446744073709551615");
+        CHECK(js::format_number(short(-32768)) == "-32768");
+    }
+
+    SECTION("Floating point") {
+        CHECK(js::format_number(0.0) == "0");
+        CHECK(js::format_number(-0.0) == "-0");
+        CHECK(js::format_number(1.0) == "1");
+        CHECK(js::format_number(0.1) == "0.1");
+        CHECK(js::format_number(0.3f) == "0.3");
+        CHECK(js::format_number(4999.5) == "4999.5");
+        CHECK(js::format_number(1e-4) == "0.0001");
+        CHECK(js::format_number(1.5e-5) == "1.5e-05");
+        CHECK(js::format_number(1e16) == "10000000000000000");
+        CHECK(js::format_number(1e17) == "1e+17");
+        CHECK(js::format_number(5e-324) == "5e-324");
+        CHECK(js::format_number(1.7976931348623157e308) ==
+              "1.7976931348623157e+308");
+        CHECK(js::format_number(std::numeric_limits<double>::infinity()) ==
+              "inf");
+        CHECK(js::format_number(-std::numeric_limits<float>::infinity()) ==
+              "-inf");
+        CHECK(js::format_number(std::numeric_limits<double>::quiet_NaN()) ==
+              "nan");
+    }
+
+    SECTION("Round trip") {
+        std::mt19937_64 g(4);
+        for (int i = 0; i != 100000; ++i) {
+            std::uint64_t bits = g();
+            double d;
+            std::memcpy(&d, &bits, sizeof(d));
+            if (!std::isfinite(d)) continue;
+            std::string text = js::format_number(d);
+            CHECK(std::strtod(text.c_str(), nullptr) == d);
+            float f = static_cast<float>(bits >> 40) / (1 << 10);
+            text = js::format_number(f);
+            CHECK(std::strtof(text.c_str(), nullptr) == f);
+        }
+    }
+
+    SECTION("BasicFileHandler") {
+        std::string name;
+        {
+            js::detail::BasicFileHandler handler("test_numbers", "txt");
+            name = handler.getFilename();
+            handler << 1 << ' ' << 0.25 << " " << 'c' << std::string("s")
+                    << true << "\n";
+            handler.write_row(std::make_tuple(1, 2.5, "x", 'y'));
+            handler.separator(", ");
+            handler.lineEnd(";\n");
+            handler.write_row(std::make_tuple(-3, 0.1f));
+            handler.write_column(std::vector<double>{1.5, 2});
+            handler.flush();
+            CHECK(read_file(name).size() == 38);
+            handler << std::vector<int>(20000, 1).size();
+        }
+        CHECK(read_file(name) ==
+              "1 0.25 cs1\n1\t2.5\tx\ty\n-3, 0.1;\n1.5;\n2;\n20000");
+        std::remove(name.c_str());
+    }
+
+    SECTION("Manipulators") {
+        std::string name;
+        {
+            js::detail::BasicFileHandler handler("test_numbers", "txt");
+            name = handler.getFilename();
+            handler << 0.1 + 0.2 << ' ' << std::setprecision(3) << 3.14159
+                    << ' ' << std::fixed << 2.5 << ' ' << std::setw(4) << 7
+                    << std::setw(3) << "ab" << ' ' << std::hex << 255;
+        }
+        CHECK(read_file(name) == "0.30000000000000004 3.14 2.500    7 ab ff");
+        std::remove(name.c_str());
+    }
+
+    SECTION("Stream precision for floats") {
+        std::string name;
+        {
+            js::detail::BasicFileHandler handler("test_numbers", "txt");
+            name = handler.getFilename();
+            CHECK(handler.shortest_floats());
+            handler.shortest_floats(false);
+            handler << 0.1 + 0.2 << ' ' << 1234567.0 << ' ' << 1234567;
+        }
+        CHECK(read_file(name) == "0.3 1.23457e+06 1234567");
+        std::remove(name.c_str());
+    }
+}
+
+TEST_CASE("Number parsing") {
+    auto parse = [](const std::string& text, auto& value) {
+        return js::parse_number(text.data(), text.data() + text.size(),
+                                value);
+    };
+    int i;
+    CHECK(parse("-42", i));
+    CHECK(i == -42);
+    CHECK(parse("+7", i));
+    CHECK(i == 7);
+    CHECK(parse("-2147483648", i));
+    CHECK(i == -2147483648LL);
+    CHECK_FALSE(parse("2147483648", i));
+    CHECK_FALSE(parse("1.5", i));
+    CHECK_FALSE(parse("", i));
+    CHECK_FALSE(parse("-", i));
+    unsigned u;
+    CHECK_FALSE(parse("-1", u));
+    std::uint64_t big;
+    CHECK(parse("18446744073709551615", big));
+    CHECK(big == 18446744073709551615u);
+    CHECK_FALSE(parse("18446744073709551616", big));
+    bool flag;
+    CHECK(parse("1", flag));
+    CHECK(flag);
+    CHECK_FALSE(parse("2", flag));
+
+    double d;
+    CHECK(parse("0.1", d));
+    CHECK(d == 0.1);
+    CHECK(parse("-1.5e-3", d));
+    CHECK(d == -1.5e-3);
+    CHECK(parse("1E22", d));
+    CHECK(d == 1e22);
+    CHECK(parse(".5", d));
+    CHECK(d == 0.5);
+    CHECK(parse("-0", d));
+    CHECK(std::signbit(d));
+    CHECK(parse("123456789012345678901234567890", d));
+    CHECK(d == 123456789012345678901234567890.0);
+    CHECK(parse("2.2250738585072014e-308", d));
+    CHECK(d == 2.2250738585072014e-308);
+    CHECK(parse("inf", d));
+    CHECK(std::isinf(d));
+    CHECK(parse("nan", d));
+    CHECK(std::isnan(d));
+    CHECK_FALSE(parse("1e", d));
+    CHECK_FALSE(parse("1.5x", d));
+    CHECK_FALSE(parse(" 1", d));
+    float f;
+    CHECK(parse("0.3", f));
+    CHECK(f == 0.3f);
+
+    std::mt19937_64 g(5);
+    for (int n = 0; n != 100000; ++n) {
+        std::uint64_t bits = g();
+        std::memcpy(&d, &bits, sizeof(d));
+        if (!std::isfinite(d)) continue;
+        double x = (n % 2) ? d : static_cast<double>(bits % 1000000) / 1000;
+        double parsed;
+        REQUIRE(parse(js::format_number(x), parsed));
+        CHECK(parsed == x);
+    }
+}
+
+namespace {
+struct Parity {
+    using type = short;
+};
+}  // end namespace
+
+TEST_CASE("TableReader") {
+    const std::string name = "test_table.txt";
+
+    SECTION("Blank separated") {
+        {
+            std::ofstream out(name);
+            out.precision(17);
+            out << "# position count parity\n";
+            for (int i = 0; i != 100000; ++i) {
+                out << 0.25 * i << "\t" << i << "  " << i % 2 << "\n";
+                if (i % 1000 == 0) out << "\n# comment\n";
+            }
+        }
+        js::ThreadPool pool(3);
+        js::TableReader<Position, Count, Parity> reader(
+            name, js::TableFormat(), pool);
+        auto table = reader.read();
+        REQUIRE(table.size() == 100000);
+        bool all = true;
+        for (int i = 0; i != 100000; ++i) {
+            all = all && js::get<Position>(table[i]) == 0.25 * i &&
+                  js::get<Count>(table[i]) == i &&
+                  js::get<Parity>(table[i]) == i % 2;
+        }
+        CHECK(all);
+
+        // Only the count, twice
+        js::TableReader<Count, Count> counts(name);
+        counts.columns({{1, 1}});
+        CHECK(counts.read().size() == 100000);
+    }
+
+    SECTION("CSV with header") {
+        {
+            std::ofstream out(name);
+            out << "count, position,other\r\n";
+            out << "1, 0.5, x\r\n";
+            out << "2,1.5,y\r\n";
+        }
+        js::TableFormat format;
+        format.delimiter = ',';
+        format.header = true;
+        js::TableReader<Position, Count> reader(name, format);
+        CHECK(reader.header() ==
+              (std::vector<std::string>{"count", "position", "other"}));
+        CHECK(reader.columns() == (std::array<std::size_t, 2>{{1, 0}}));
+        auto table = reader.read();
+        REQUIRE(table.size() == 2);
+        CHECK(js::get<Position>(table).front() == 0.5);
+        CHECK(js::get<Position>(table).back() == 1.5);
+        CHECK(js::get<Count>(table).back() == 2);
+    }
+
+    SECTION("Errors") {
+        {
+            std::ofstream out(name);
+            out << "1 2\n3\n";
+        }
+        js::TableReader<Count, Count> reader(name);
+        CHECK_THROWS_WITH(reader.read(),
+                          "test_table.txt:2: missing column 1");
+        {
+            std::ofstream out(name);
+            out << "1 2\n3 x\n";
+        }
+        js::TableReader<Count, Count> invalid(name);
+        CHECK_THROWS_WITH(invalid.read(),
+                          "test_table.txt:2: invalid number 'x'");
+        js::TableFormat format;
+        format.header = true;
+        CHECK_THROWS_AS((js::TableReader<Position>(name, format)),
+                        std::invalid_argument);
+    }
+    std::remove(name.c_str());
+}
@@ -0,0 +1,45 @@
+#include "catch.hpp"
+#include "js/thread.hpp"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("ThreadPool") {
+    js::ThreadPool pool(3);
+    CHECK(pool.size() == 3);
+
+    SECTION("submit") {
+        auto result = pool.submit([]() { return 42; });
+        CHECK(result.get() == 42);
+    }
+
+    SECTION("submit with exception") {
+        auto result =
+            pool.submit([]() -> int { throw std::runtime_error("fail"); });
+        CHECK_THROWS_AS(result.get(), std::runtime_error);
+    }
+
+    SECTION("post and wait_until") {
+        std::atomic<int> counter(0);
+        for (int i = 0; i != 100; ++i) {
+            pool.post([&counter]() { ++counter; });
+        }
+        pool.wait_until([&counter]() { return counter == 100; });
+        CHECK(counter == 100);
+    }
+
+    SECTION("Nested tasks") {
+        std::atomic<int> counter(0);
+        auto outer = pool.submit([&pool, &counter]() {
+            std::atomic<int> inner(0);
+            for (int i = 0; i != 10; ++i) {
+                pool.post([&inner]() { ++inner; });
+            }
+            pool.wait_until([&inner]() { return inner == 10; });
+            counter += inner;
+        });
+        pool.wait_until([&counter]() { return counter == 10; });
+        outer.get();
+        CHECK_FALSE(pool.is_worker());
+    }
+}